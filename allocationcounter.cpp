@@ -0,0 +1,145 @@
+/**
+    \file allocationcounter.cpp
+    \brief Replacement global allocation functions counting heap allocations, only built with COUNT_ALLOCATIONS
+*/
+
+#include "allocationcounter.h"
+
+#ifdef COUNT_ALLOCATIONS
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    /// Number of heap allocations made by the program
+    std::atomic<std::size_t> allocation_count{0};
+
+    /**
+        \brief Allocate memory and count the allocation
+        \param size number of bytes
+        \param alignment alignment of the memory, 0 for default alignment
+        \return Pointer to memory, nullptr if allocation failed
+    */
+    void* countedAllocate(std::size_t size, std::size_t alignment)
+    {
+        allocation_count.fetch_add(1, std::memory_order_relaxed);
+        if(size == 0)
+            size = 1;
+        if(alignment == 0)
+            return std::malloc(size);
+        return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    }
+}
+
+void* operator new(std::size_t size)
+{
+    void* ptr = countedAllocate(size, 0);
+    if(ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size, 0);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size, 0);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    void* ptr = countedAllocate(size, static_cast<std::size_t>(alignment));
+    if(ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
+std::size_t allocationCount()
+{
+    return allocation_count.load(std::memory_order_relaxed);
+}
+#endif
@@ -0,0 +1,22 @@
+/**
+    \file allocationcounter.h
+    \brief Header for counting heap allocations in allocation tests
+*/
+
+#ifndef ALLOCATIONCOUNTER_H_INCLUDED
+#define ALLOCATIONCOUNTER_H_INCLUDED
+#include <cstddef>
+
+#ifdef COUNT_ALLOCATIONS
+/**
+    \brief Function to get number of heap allocations made by the program
+
+    Global allocation functions are replaced only in builds with COUNT_ALLOCATIONS defined,
+    so normal builds do not pay for counting. Every form of operator new and delete is
+    replaced, so memory is always released by the allocator that gave it.
+    \return Number of allocations since the program started
+*/
+std::size_t allocationCount();
+#endif
+
+#endif // ALLOCATIONCOUNTER_H_INCLUDED
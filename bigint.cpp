@@ -0,0 +1,403 @@
+/**
+    \file bigint.cpp
+    \brief Code for BigInt class
+*/
+
+#include "bigint.h"
+#include "element.h"
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <stdexcept>
+
+/**
+    \brief Multiply magnitude by small number and add small number
+*/
+static void multiplyAdd(std::vector<std::uint32_t>& limbs, std::uint32_t factor, std::uint32_t addend)
+{
+    std::uint64_t carry = addend;
+    for(std::uint32_t& limb: limbs)
+    {
+        std::uint64_t t = static_cast<std::uint64_t>(limb) * factor + carry;
+        limb = static_cast<std::uint32_t>(t);
+        carry = t >> 32;
+    }
+    if(carry != 0)
+        limbs.push_back(static_cast<std::uint32_t>(carry));
+}
+
+/**
+    \brief Divide magnitude by small number
+    \return The remainder
+*/
+static std::uint32_t divideSmall(std::vector<std::uint32_t>& limbs, std::uint32_t divisor)
+{
+    std::uint64_t rem = 0;
+    for(std::size_t i = limbs.size(); i-- > 0; )
+    {
+        std::uint64_t cur = (rem << 32) | limbs[i];
+        limbs[i] = static_cast<std::uint32_t>(cur / divisor);
+        rem = cur % divisor;
+    }
+    while(!limbs.empty() && limbs.back() == 0)
+        limbs.pop_back();
+    return static_cast<std::uint32_t>(rem);
+}
+
+BigInt::BigInt(long long v)
+{
+    negative = v < 0;
+    std::uint64_t mag = negative ? 0 - static_cast<std::uint64_t>(v) : static_cast<std::uint64_t>(v);
+    while(mag != 0)
+    {
+        limbs.push_back(static_cast<std::uint32_t>(mag));
+        mag >>= 32;
+    }
+}
+
+BigInt::BigInt(const std::string& str)
+{
+    std::size_t pos = 0;
+    if(!str.empty() && str[0] == '-')
+        pos = 1;
+    if(pos == str.size())
+    {
+        throw std::invalid_argument("Not a number");
+    }
+
+    for( ; pos < str.size(); pos++)
+    {
+        if(!std::isdigit(static_cast<unsigned char>(str[pos])))
+        {
+            throw std::invalid_argument("Not a number");
+        }
+        multiplyAdd(limbs, 10, static_cast<std::uint32_t>(str[pos] - '0'));
+    }
+    negative = str[0] == '-';
+    trim();
+}
+
+void BigInt::trim()
+{
+    while(!limbs.empty() && limbs.back() == 0)
+        limbs.pop_back();
+    if(limbs.empty())
+        negative = false;
+}
+
+int BigInt::compareMagnitude(const BigInt& a, const BigInt& b)
+{
+    if(a.limbs.size() != b.limbs.size())
+        return a.limbs.size() < b.limbs.size() ? -1 : 1;
+
+    for(std::size_t i = a.limbs.size(); i-- > 0; )
+    {
+        if(a.limbs[i] != b.limbs[i])
+            return a.limbs[i] < b.limbs[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+void BigInt::addMagnitude(const BigInt& b)
+{
+    if(limbs.size() < b.limbs.size())
+        limbs.resize(b.limbs.size(), 0);
+
+    std::uint64_t carry = 0;
+    for(std::size_t i = 0; i < limbs.size(); i++)
+    {
+        std::uint64_t t = static_cast<std::uint64_t>(limbs[i]) + (i < b.limbs.size() ? b.limbs[i] : 0) + carry;
+        limbs[i] = static_cast<std::uint32_t>(t);
+        carry = t >> 32;
+        if(carry == 0 && i >= b.limbs.size())
+            break;
+    }
+    if(carry != 0)
+        limbs.push_back(static_cast<std::uint32_t>(carry));
+}
+
+void BigInt::subtractMagnitude(const BigInt& b)
+{
+    std::int64_t borrow = 0;
+    for(std::size_t i = 0; i < limbs.size(); i++)
+    {
+        std::int64_t t = static_cast<std::int64_t>(limbs[i]) - (i < b.limbs.size() ? b.limbs[i] : 0) - borrow;
+        borrow = t < 0 ? 1 : 0;
+        limbs[i] = static_cast<std::uint32_t>(t + (borrow << 32));
+        if(borrow == 0 && i >= b.limbs.size())
+            break;
+    }
+    trim();
+}
+
+bool BigInt::fitsLongLong() const
+{
+    if(limbs.size() > 2)
+        return false;
+
+    std::uint64_t mag = 0;
+    for(std::size_t i = limbs.size(); i-- > 0; )
+        mag = (mag << 32) | limbs[i];
+    std::uint64_t limit = static_cast<std::uint64_t>(std::numeric_limits<long long>::max()) + (negative ? 1 : 0);
+    return mag <= limit;
+}
+
+long long BigInt::toLongLong() const
+{
+    if(!fitsLongLong())
+    {
+        throw std::overflow_error("Number does not fit in 64 bits");
+    }
+
+    std::uint64_t mag = 0;
+    for(std::size_t i = limbs.size(); i-- > 0; )
+        mag = (mag << 32) | limbs[i];
+    return negative ? static_cast<long long>(0 - mag) : static_cast<long long>(mag);
+}
+
+void BigInt::appendTo(std::string& out) const
+{
+    if(limbs.empty())
+    {
+        out += '0';
+        return;
+    }
+
+    std::vector<std::uint32_t> mag = limbs;
+    std::vector<std::uint32_t> chunks;
+    while(!mag.empty())
+    {
+        chunks.push_back(divideSmall(mag, 1000000000u));
+    }
+
+    if(negative)
+        out += '-';
+    out += std::to_string(chunks.back());
+    for(std::size_t i = chunks.size() - 1; i-- > 0; )
+    {
+        std::string digits = std::to_string(chunks[i]);
+        out.append(9 - digits.size(), '0');
+        out += digits;
+    }
+}
+
+std::string BigInt::toString() const
+{
+    std::string out;
+    appendTo(out);
+    return out;
+}
+
+std::uint64_t BigInt::hash() const
+{
+    std::uint64_t h = hashCombine(negative ? '-' : '+', limbs.size());
+    for(std::uint32_t limb: limbs)
+        h = hashCombine(h, limb);
+    return h;
+}
+
+BigInt BigInt::operator-() const
+{
+    BigInt r = *this;
+    if(!r.limbs.empty())
+        r.negative = !r.negative;
+    return r;
+}
+
+BigInt& BigInt::operator+=(const BigInt& b)
+{
+    if(negative == b.negative)
+    {
+        addMagnitude(b);
+    }
+    else if(compareMagnitude(*this, b) >= 0)
+    {
+        subtractMagnitude(b);
+    }
+    else
+    {
+        BigInt r = b;
+        r.subtractMagnitude(*this);
+        *this = std::move(r);
+    }
+    return *this;
+}
+
+BigInt& BigInt::operator-=(const BigInt& b)
+{
+    return *this += -b;
+}
+
+BigInt& BigInt::operator*=(const BigInt& b)
+{
+    if(limbs.empty() || b.limbs.empty())
+    {
+        limbs.clear();
+        negative = false;
+        return *this;
+    }
+
+    std::vector<std::uint32_t> r(limbs.size() + b.limbs.size(), 0);
+    for(std::size_t i = 0; i < limbs.size(); i++)
+    {
+        std::uint64_t carry = 0;
+        for(std::size_t j = 0; j < b.limbs.size(); j++)
+        {
+            std::uint64_t t = static_cast<std::uint64_t>(limbs[i]) * b.limbs[j] + r[i + j] + carry;
+            r[i + j] = static_cast<std::uint32_t>(t);
+            carry = t >> 32;
+        }
+        r[i + b.limbs.size()] = static_cast<std::uint32_t>(carry);
+    }
+
+    limbs = std::move(r);
+    negative = negative != b.negative;
+    trim();
+    return *this;
+}
+
+void BigInt::divide(const BigInt& a, const BigInt& b, BigInt& quotient, BigInt& remainder)
+{
+    if(b.limbs.empty())
+    {
+        throw std::domain_error("Division by zero");
+    }
+
+    BigInt q;
+    BigInt r;
+    if(compareMagnitude(a, b) < 0)
+    {
+        r = a;
+    }
+    else if(b.limbs.size() == 1)
+    {
+        q.limbs = a.limbs;
+        std::uint32_t rem = divideSmall(q.limbs, b.limbs[0]);
+        if(rem != 0)
+            r.limbs.push_back(rem);
+    }
+    else
+    {
+        // Knuth's algorithm D, divisor is normalized so that its top bit is set
+        std::size_t n = b.limbs.size();
+        std::size_t m = a.limbs.size() - n;
+        int shift = 0;
+        for(std::uint32_t top = b.limbs.back(); (top & 0x80000000u) == 0; top <<= 1)
+            shift++;
+
+        std::vector<std::uint32_t> vn(n);
+        std::vector<std::uint32_t> un(a.limbs.size() + 1);
+        for(std::size_t i = n - 1; i > 0; i--)
+            vn[i] = (b.limbs[i] << shift) | (shift ? static_cast<std::uint32_t>(static_cast<std::uint64_t>(b.limbs[i - 1]) >> (32 - shift)) : 0);
+        vn[0] = b.limbs[0] << shift;
+        un[a.limbs.size()] = shift ? static_cast<std::uint32_t>(static_cast<std::uint64_t>(a.limbs.back()) >> (32 - shift)) : 0;
+        for(std::size_t i = a.limbs.size() - 1; i > 0; i--)
+            un[i] = (a.limbs[i] << shift) | (shift ? static_cast<std::uint32_t>(static_cast<std::uint64_t>(a.limbs[i - 1]) >> (32 - shift)) : 0);
+        un[0] = a.limbs[0] << shift;
+
+        q.limbs.assign(m + 1, 0);
+        const std::uint64_t base = std::uint64_t(1) << 32;
+        for(std::size_t j = m + 1; j-- > 0; )
+        {
+            std::uint64_t num = (static_cast<std::uint64_t>(un[j + n]) << 32) | un[j + n - 1];
+            std::uint64_t qhat = num / vn[n - 1];
+            std::uint64_t rhat = num % vn[n - 1];
+            while(qhat >= base || qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2]))
+            {
+                qhat--;
+                rhat += vn[n - 1];
+                if(rhat >= base)
+                    break;
+            }
+
+            std::int64_t k = 0;
+            std::int64_t t;
+            for(std::size_t i = 0; i < n; i++)
+            {
+                std::uint64_t p = qhat * vn[i];
+                t = static_cast<std::int64_t>(un[i + j]) - k - static_cast<std::int64_t>(p & 0xffffffffu);
+                un[i + j] = static_cast<std::uint32_t>(t);
+                k = static_cast<std::int64_t>(p >> 32) - (t >> 32);
+            }
+            t = static_cast<std::int64_t>(un[j + n]) - k;
+            un[j + n] = static_cast<std::uint32_t>(t);
+
+            if(t < 0)
+            {
+                qhat--;
+                std::uint64_t carry = 0;
+                for(std::size_t i = 0; i < n; i++)
+                {
+                    std::uint64_t s = static_cast<std::uint64_t>(un[i + j]) + vn[i] + carry;
+                    un[i + j] = static_cast<std::uint32_t>(s);
+                    carry = s >> 32;
+                }
+                un[j + n] = static_cast<std::uint32_t>(un[j + n] + carry);
+            }
+            q.limbs[j] = static_cast<std::uint32_t>(qhat);
+        }
+
+        r.limbs.resize(n);
+        for(std::size_t i = 0; i < n; i++)
+            r.limbs[i] = (un[i] >> shift) | (shift ? static_cast<std::uint32_t>(static_cast<std::uint64_t>(un[i + 1]) << (32 - shift)) : 0);
+    }
+
+    q.negative = a.negative != b.negative;
+    r.negative = a.negative;
+    q.trim();
+    r.trim();
+    quotient = std::move(q);
+    remainder = std::move(r);
+}
+
+BigInt& BigInt::operator/=(const BigInt& b)
+{
+    BigInt r;
+    divide(*this, b, *this, r);
+    return *this;
+}
+
+bool operator==(const BigInt& a, const BigInt& b)
+{
+    return a.negative == b.negative && a.limbs == b.limbs;
+}
+
+bool operator<(const BigInt& a, const BigInt& b)
+{
+    if(a.negative != b.negative)
+        return a.negative;
+
+    int c = BigInt::compareMagnitude(a, b);
+    return a.negative ? c > 0 : c < 0;
+}
+
+BigInt operator+(BigInt a, const BigInt& b)
+{
+    return a += b;
+}
+
+BigInt operator-(BigInt a, const BigInt& b)
+{
+    return a -= b;
+}
+
+BigInt operator*(const BigInt& a, const BigInt& b)
+{
+    BigInt r = a;
+    return r *= b;
+}
+
+BigInt operator/(BigInt a, const BigInt& b)
+{
+    return a /= b;
+}
+
+bool operator!=(const BigInt& a, const BigInt& b)
+{
+    return !(a == b);
+}
+
+std::ostream& operator<<(std::ostream& os, const BigInt& b)
+{
+    return os << b.toString();
+}
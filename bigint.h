@@ -0,0 +1,147 @@
+/**
+    \file bigint.h
+    \brief Header for BigInt class
+*/
+
+#ifndef BIGINT_H_INCLUDED
+#define BIGINT_H_INCLUDED
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+    \class BigInt
+    \brief Arbitrary-precision signed integer
+*/
+class BigInt
+{
+    private:
+        bool negative = false;
+        std::vector<std::uint32_t> limbs;   ///< magnitude, least significant limb first, no leading zero limbs
+
+        /**
+            \brief Remove leading zero limbs, zero is never negative
+        */
+        void trim();
+
+        /**
+            \brief Compare magnitudes
+            \return negative, zero or positive like strcmp
+        */
+        static int compareMagnitude(const BigInt& a, const BigInt& b);
+
+        /**
+            \brief Add magnitude of b to magnitude of this
+        */
+        void addMagnitude(const BigInt& b);
+
+        /**
+            \brief Subtract magnitude of b from magnitude of this, magnitude of b must not be larger
+        */
+        void subtractMagnitude(const BigInt& b);
+
+    public:
+
+        /**
+            \brief Default constructor, value is 0
+        */
+        BigInt() = default;
+
+        /**
+            \brief Parametric constructor
+            \param v value
+        */
+        BigInt(long long v);
+
+        /**
+            \brief Parametric constructor
+            \param str decimal number, optionally starting with '-'
+            \throw std::invalid_argument if str is not a number
+        */
+        explicit BigInt(const std::string& str);
+
+        /**
+            \brief Tell if value is 0
+            \return true if value is 0
+        */
+        bool isZero() const
+        {
+            return limbs.empty();
+        }
+
+        /**
+            \brief Tell if value is below 0
+            \return true if value is below 0
+        */
+        bool isNegative() const
+        {
+            return negative;
+        }
+
+        /**
+            \brief Tell if value fits in long long
+            \return true if value fits
+        */
+        bool fitsLongLong() const;
+
+        /**
+            \brief Convert to long long
+            \throw std::overflow_error if value does not fit
+            \return The value
+        */
+        long long toLongLong() const;
+
+        /**
+            \brief Returns decimal representation
+            \return The string representation
+        */
+        std::string toString() const;
+
+        /**
+            \brief Append decimal representation to a string
+            \param out string to append to
+        */
+        void appendTo(std::string& out) const;
+
+        /**
+            \brief Calculate 64-bit hash of value
+            \return The hash
+        */
+        std::uint64_t hash() const;
+
+        BigInt operator-() const;
+        BigInt& operator+=(const BigInt& b);
+        BigInt& operator-=(const BigInt& b);
+        BigInt& operator*=(const BigInt& b);
+
+        /**
+            \brief Divide, quotient is rounded toward zero
+            \param b divisor
+            \throw std::domain_error if b is 0
+            \return Reference to this
+        */
+        BigInt& operator/=(const BigInt& b);
+
+        /**
+            \brief Divide with remainder, quotient is rounded toward zero and remainder has the sign of a
+            \param a dividend
+            \param b divisor
+            \param quotient the quotient
+            \param remainder the remainder
+            \throw std::domain_error if b is 0
+        */
+        static void divide(const BigInt& a, const BigInt& b, BigInt& quotient, BigInt& remainder);
+
+        friend bool operator==(const BigInt& a, const BigInt& b);
+        friend bool operator<(const BigInt& a, const BigInt& b);
+};
+
+BigInt operator+(BigInt a, const BigInt& b);
+BigInt operator-(BigInt a, const BigInt& b);
+BigInt operator*(const BigInt& a, const BigInt& b);
+BigInt operator/(BigInt a, const BigInt& b);
+bool operator!=(const BigInt& a, const BigInt& b);
+std::ostream& operator<<(std::ostream& os, const BigInt& b);
+
+#endif // BIGINT_H_INCLUDED
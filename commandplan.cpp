@@ -0,0 +1,382 @@
+/**
+    \file commandplan.cpp
+    \brief Code for CommandPlan class
+*/
+
+#include "commandplan.h"
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+    /**
+        \brief Node of the expression DAG of a plan, op is 0 for matrices
+
+        An operation leaves its second operand on the stack, so a node can be the operand
+        of several operations. Values are kept once calculated.
+    */
+    struct PlanNode
+    {
+        char op;
+        std::size_t left;       ///< topmost operand
+        std::size_t right;      ///< operand below it, stays on the stack
+        std::shared_ptr<SquareMatrix> matrix;
+        unsigned int size = 0;
+        std::vector<int> values;                        ///< evaluated values in symbolic mode
+        std::shared_ptr<SymbolicSquareMatrix> operand;  ///< node read as an operand in symbolic mode
+        std::vector<std::uint32_t> reduced;             ///< reduced values in modular mode
+        std::shared_ptr<ExactSquareMatrix> exact;       ///< value in exact mode
+
+        PlanNode(char operation, std::size_t top, std::size_t below, std::shared_ptr<SquareMatrix> m):
+            op(operation), left(top), right(below), matrix(std::move(m)) {}
+    };
+
+    /**
+        \class PlanBuilder
+        \brief Builds results of plan nodes with the same values as running their lines one at a time
+    */
+    class PlanBuilder
+    {
+        private:
+            std::vector<PlanNode>& nodes;
+            const Valuation& v;
+            const Modulus* mod;
+            bool exact;
+
+            /**
+                \brief Check that operands are the same size
+                \throw std::invalid_argument if they are not
+            */
+            static void checkSize(unsigned int n1, unsigned int n2)
+            {
+                if(n1 != n2)
+                {
+                    throw std::invalid_argument("Matrices are not the same size");
+                }
+            }
+
+            /**
+                \brief Evaluated values of node in symbolic mode, sums are added from the values of their operands
+                \param node the node
+                \return Row-major values
+            */
+            const std::vector<int>& values(std::size_t node)
+            {
+                PlanNode& pn = nodes[node];
+                if(!pn.values.empty())
+                    return pn.values;
+
+                if(pn.op == 0 || pn.op == '*')
+                {
+                    // a product is only evaluated once its element expressions are built
+                    ConcreteSquareMatrix m = evaluateWatched(*pn.matrix, v, nullptr);
+                    pn.size = m.getSize();
+                    pn.values.resize(static_cast<std::size_t>(pn.size) * pn.size);
+                    m.copyValues(pn.values.data());
+                    return pn.values;
+                }
+
+                const std::vector<int>& a = values(pn.left);
+                const std::vector<int>& b = values(pn.right);
+                checkSize(nodes[pn.left].size, nodes[pn.right].size);
+                pn.size = nodes[pn.left].size;
+
+                // unsigned arithmetic wraps like the element operations do
+                pn.values.resize(a.size());
+                for(std::size_t k = 0; k < a.size(); k++)
+                {
+                    unsigned int x = static_cast<unsigned int>(a[k]);
+                    unsigned int y = static_cast<unsigned int>(b[k]);
+                    pn.values[k] = static_cast<int>((pn.op == '+') ? x + y : x - y);
+                }
+                return pn.values;
+            }
+
+            /**
+                \brief Node read as an operand of '+', '-' or '*' in symbolic mode
+                \param node the node
+                \throw std::invalid_argument if it cannot be read
+                \return SymbolicSquareMatrix object
+            */
+            const SymbolicSquareMatrix& operand(std::size_t node)
+            {
+                PlanNode& pn = nodes[node];
+                if(pn.operand != nullptr)
+                    return *pn.operand;
+
+                if(pn.op == 0)
+                {
+                    pn.operand = std::make_shared<SymbolicSquareMatrix>();
+                    std::ostringstream ignored;
+                    if(!readOperand(*pn.matrix, v, *pn.operand, ignored))
+                    {
+                        throw std::invalid_argument("Could not do evaluation");
+                    }
+                    return *pn.operand;
+                }
+
+                // results of operations cannot be read back, so they are evaluated without printing and parsing them
+                const std::vector<int>& vals = values(node);
+                pn.operand = std::make_shared<SymbolicSquareMatrix>(ConcreteSquareMatrix::fromValues(nodes[node].size, vals.data()).specialize(v));
+                return *pn.operand;
+            }
+
+            /**
+                \brief Reduced values of node in modular mode
+                \param node the node
+                \return Row-major values 0..p-1
+            */
+            const std::vector<std::uint32_t>& reduced(std::size_t node)
+            {
+                PlanNode& pn = nodes[node];
+                if(!pn.reduced.empty())
+                    return pn.reduced;
+
+                if(pn.op == 0)
+                {
+                    ConcreteSquareMatrix m = evaluateWatched(*pn.matrix, v, nullptr);
+                    pn.size = m.getSize();
+                    pn.reduced = reducedValues(m, *mod);
+                    return pn.reduced;
+                }
+
+                const std::vector<std::uint32_t>& a = reduced(pn.left);
+                const std::vector<std::uint32_t>& b = reduced(pn.right);
+                checkSize(nodes[pn.left].size, nodes[pn.right].size);
+                pn.size = nodes[pn.left].size;
+                pn.reduced.resize(a.size());
+                if(pn.op == '*')
+                {
+                    modularMultiply(pn.size, a.data(), b.data(), pn.reduced.data(), *mod);
+                    return pn.reduced;
+                }
+                for(std::size_t k = 0; k < a.size(); k++)
+                {
+                    pn.reduced[k] = (pn.op == '+') ? mod->add(a[k], b[k]) : mod->subtract(a[k], b[k]);
+                }
+                return pn.reduced;
+            }
+
+            /**
+                \brief Value of node in exact mode
+                \param node the node
+                \return ExactSquareMatrix object
+            */
+            const ExactSquareMatrix& exactValue(std::size_t node)
+            {
+                PlanNode& pn = nodes[node];
+                if(pn.exact != nullptr)
+                    return *pn.exact;
+
+                if(pn.op == 0)
+                {
+                    pn.exact = std::make_shared<ExactSquareMatrix>(toExact(*pn.matrix, v));
+                    return *pn.exact;
+                }
+
+                const ExactSquareMatrix& m1 = exactValue(pn.left);
+                const ExactSquareMatrix& m2 = exactValue(pn.right);
+                if(pn.op == '+')
+                    pn.exact = std::make_shared<ExactSquareMatrix>(exactAdd(m1, m2));
+                else if(pn.op == '-')
+                    pn.exact = std::make_shared<ExactSquareMatrix>(exactSubtract(m1, m2));
+                else
+                    pn.exact = std::make_shared<ExactSquareMatrix>(exactMultiply(m1, m2));
+                return *pn.exact;
+            }
+
+        public:
+
+            /**
+                \brief Parametric constructor
+                \param plan_nodes nodes of the plan
+                \param valuation map where variable values are stored
+                \param modulus modulus in modular mode, nullptr otherwise
+                \param exact_mode true in exact mode
+            */
+            PlanBuilder(std::vector<PlanNode>& plan_nodes, const Valuation& valuation, const Modulus* modulus, bool exact_mode):
+                nodes(plan_nodes), v(valuation), mod(modulus), exact(exact_mode) {}
+
+            /**
+                \brief Build result of an operation node, operands must be built first
+                \param node the node
+                \throw std::invalid_argument if operation cannot be done
+            */
+            void build(std::size_t node)
+            {
+                PlanNode& pn = nodes[node];
+                if(exact)
+                {
+                    exactValue(node);
+                    pn.matrix = pn.exact;
+                }
+                else if(mod != nullptr)
+                {
+                    const std::vector<std::uint32_t>& vals = reduced(node);
+                    pn.matrix = std::make_shared<ConcreteSquareMatrix>(fromReduced(pn.size, vals));
+                }
+                else if(pn.op == '*')
+                {
+                    pn.matrix = std::make_shared<SymbolicSquareMatrix>(multiply(operand(pn.left), operand(pn.right), nullptr));
+                }
+                else
+                {
+                    const SymbolicSquareMatrix& m1 = operand(pn.left);
+                    const SymbolicSquareMatrix& m2 = operand(pn.right);
+                    pn.matrix = std::make_shared<SymbolicSquareMatrix>((pn.op == '+') ? m1 + m2 : m1 - m2);
+                }
+            }
+    };
+
+    /**
+        \brief Name of operation used in messages
+        \param op character of operation
+        \return The name
+    */
+    const char* operationName(char op)
+    {
+        return (op == '+') ? "addition" : (op == '-') ? "subtraction" : "multiplication";
+    }
+
+    /**
+        \brief Tell if line is an operation of a plan
+        \param line the line
+        \return Character of operation, 0 for other lines
+    */
+    char planOperation(const std::string& line)
+    {
+        std::istringstream strm(line);
+        std::string word;
+        if(!(strm >> word) || (word != "+" && word != "-" && word != "*"))
+            return 0;
+        strm >> std::ws;
+        return strm.eof() ? word[0] : 0;
+    }
+}
+
+bool CommandPlan::isPlannable(const std::string& line)
+{
+    std::istringstream strm(line);
+    return (strm >> std::ws).peek() == '[' || planOperation(line) != 0;
+}
+
+void CommandPlan::add(const std::string& line)
+{
+    if(planOperation(line) != 0)
+        operations++;
+    lines.push_back(line);
+}
+
+void CommandPlan::run(std::stack<std::shared_ptr<SquareMatrix>>& matrices, const Valuation& v, ResultCache& cache, const Modulus* mod, bool exact,
+                      std::vector<std::string>& responses)
+{
+    const std::stack<std::shared_ptr<SquareMatrix>> snapshot = matrices;
+    std::vector<PlanNode> nodes;
+    std::vector<std::size_t> pending;
+    std::vector<std::string> messages(lines.size());
+    bool planned = operations >= 2;
+
+    // stack entries below the plan become matrix nodes when an operation needs them
+    auto topOperand = [&]()
+    {
+        if(pending.empty())
+        {
+            pending.push_back(nodes.size());
+            nodes.emplace_back(0, 0, 0, matrices.top());
+            matrices.pop();
+        }
+        return pending.back();
+    };
+
+    for(std::size_t i = 0; planned && i < lines.size(); i++)
+    {
+        char op = planOperation(lines[i]);
+        if(op == 0)
+        {
+            std::shared_ptr<SquareMatrix> matrix_ptr = readMatrixLine(lines[i]);
+            if(matrix_ptr == nullptr)
+            {
+                messages[i] = "Invalid input\n";
+                continue;
+            }
+            pending.push_back(nodes.size());
+            nodes.emplace_back(0, 0, 0, matrix_ptr);
+            messages[i] = "Added matrix to stack\n";
+            continue;
+        }
+
+        std::size_t available = pending.size() + matrices.size();
+        if(available < 2)
+        {
+            messages[i] = (available == 0) ? "Stack is empty\n" : "Stack only has one matrix\n";
+            continue;
+        }
+        std::size_t first = topOperand();
+        pending.pop_back();
+        std::size_t second = topOperand();
+        pending.push_back(nodes.size());
+        nodes.emplace_back(op, first, second, nullptr);
+    }
+
+    if(planned)
+    {
+        try
+        {
+            // every result is printed, operands come before the operations using them
+            PlanBuilder builder(nodes, v, mod, exact);
+            for(std::size_t node = 0; node < nodes.size(); node++)
+            {
+                if(nodes[node].op != 0)
+                    builder.build(node);
+            }
+        }
+        catch(...)
+        {
+            planned = false;
+        }
+    }
+
+    if(planned)
+    {
+        for(std::size_t node: pending)
+        {
+            matrices.push(nodes[node].matrix);
+        }
+        std::size_t node = 0;
+        for(std::size_t i = 0; i < lines.size(); i++)
+        {
+            if(!messages[i].empty())
+                continue;
+            while(nodes[node].op == 0)
+            {
+                node++;
+            }
+            const PlanNode& pn = nodes[node++];
+            messages[i] = std::string("Added result of ") + operationName(pn.op) + ": " + pn.matrix->toString() + " to the stack\n";
+        }
+    }
+    else
+    {
+        matrices = snapshot;
+        for(std::size_t i = 0; i < lines.size(); i++)
+        {
+            char op = planOperation(lines[i]);
+            if(op == 0)
+            {
+                std::shared_ptr<SquareMatrix> matrix_ptr = readMatrixLine(lines[i]);
+                if(matrix_ptr != nullptr)
+                    matrices.push(matrix_ptr);
+                messages[i] = (matrix_ptr != nullptr) ? "Added matrix to stack\n" : "Invalid input\n";
+                continue;
+            }
+            std::ostringstream out;
+            stackOperation(matrices, v, cache, op, mod, exact, out);
+            messages[i] = out.str();
+        }
+    }
+
+    responses.insert(responses.end(), messages.begin(), messages.end());
+    lines.clear();
+    operations = 0;
+}
@@ -0,0 +1,78 @@
+/**
+    \file commandplan.h
+    \brief Header for CommandPlan class
+*/
+
+#ifndef COMMANDPLAN_H_INCLUDED
+#define COMMANDPLAN_H_INCLUDED
+#include "commands.h"
+#include <memory>
+#include <stack>
+#include <string>
+#include <vector>
+
+/**
+    \class CommandPlan
+    \brief Matrix and '+', '-' and '*' lines read ahead from a batch and run together
+
+    Lines are recorded as a small expression DAG over the stack, an operation leaves its
+    second operand on the stack so later lines can use it again. When the plan is run each
+    operand is evaluated once and results of operations are calculated from the values of
+    their operands instead of being printed and parsed back, or evaluated again, by the
+    next line. Responses are the same as when the lines are run one at a time. If an
+    operation fails the lines are run again one at a time, so errors are reported in the
+    same way.
+*/
+class CommandPlan
+{
+    private:
+        std::vector<std::string> lines;
+        std::size_t operations = 0;
+
+    public:
+
+        /**
+            \brief Tell if line can be added to a plan
+            \param line the line
+            \return true for a matrix and for '+', '-' and '*'
+        */
+        static bool isPlannable(const std::string& line);
+
+        /**
+            \brief Add line to the plan
+            \param line matrix or '+', '-' or '*'
+        */
+        void add(const std::string& line);
+
+        /**
+            \brief Function to get number of '+', '-' and '*' lines in the plan
+            \return The number
+        */
+        std::size_t getOperations() const
+        {
+            return operations;
+        }
+
+        /**
+            \brief Function to get number of lines in the plan
+            \return The number
+        */
+        std::size_t size() const
+        {
+            return lines.size();
+        }
+
+        /**
+            \brief Run the lines and empty the plan
+            \param matrices stack of matrices
+            \param v map where variable values are stored
+            \param cache cache of results, used when lines are run one at a time
+            \param mod modulus in modular mode, nullptr otherwise
+            \param exact true in exact mode
+            \param responses messages of each line are appended to it, one string per line
+        */
+        void run(std::stack<std::shared_ptr<SquareMatrix>>& matrices, const Valuation& v, ResultCache& cache, const Modulus* mod, bool exact,
+                 std::vector<std::string>& responses);
+};
+
+#endif // COMMANDPLAN_H_INCLUDED
@@ -0,0 +1,302 @@
+/**
+    \file commands.cpp
+    \brief Code for stack commands shared by the interactive calculator and the server
+*/
+
+#include "commands.h"
+#include "fixedmatrix.h"
+#include "matrixparser.h"
+#include <sstream>
+
+std::shared_ptr<SquareMatrix> readMatrixLine(const std::string& line)
+{
+    std::istringstream strm(line);
+    try
+    {
+        std::shared_ptr<SquareMatrix> matrix_ptr = std::make_shared<SymbolicSquareMatrix>(MatrixStreamParser<Element>(strm).parse());
+        if((strm >> std::ws).peek() != std::char_traits<char>::eof())
+            return nullptr;
+        return matrix_ptr;
+    }
+    catch(const std::invalid_argument& ia)
+    {
+        return nullptr;
+    }
+}
+
+bool readOperand(const SquareMatrix& m, const Valuation& v, SymbolicSquareMatrix& out, std::ostream& os)
+{
+    try
+    {
+        out = SymbolicSquareMatrix(m.toString());
+    }
+    catch(const std::invalid_argument& ia)
+    {
+        try
+        {
+            out = SymbolicSquareMatrix(m.evaluate(v).toString());
+        }
+        catch(const std::invalid_argument& ia)
+        {
+            os << "Couldn't do evaluation, please declare values to variables" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+ConcreteSquareMatrix evaluateWatched(const SquareMatrix& m, const Valuation& v, Progress* progress)
+{
+    if(const SymbolicSquareMatrix* sm = dynamic_cast<const SymbolicSquareMatrix*>(&m))
+        return evaluateParallel(*sm, v, 0, progress);
+    return m.evaluate(v);
+}
+
+ExactSquareMatrix toExact(const SquareMatrix& m, const Valuation& v)
+{
+    if(const ExactSquareMatrix* em = dynamic_cast<const ExactSquareMatrix*>(&m))
+        return *em;
+    return ExactSquareMatrix(m.evaluate(v));
+}
+
+void stackOperation(std::stack<std::shared_ptr<SquareMatrix>>& matrices, const Valuation& v, ResultCache& cache, char op, const Modulus* mod, bool exact,
+                    std::ostream& out, Progress* progress)
+{
+    if(matrices.empty())
+    {
+        out << "Stack is empty" << std::endl;
+        return;
+    }
+    std::shared_ptr<SquareMatrix> first = matrices.top();
+    matrices.pop();
+    if(matrices.empty())
+    {
+        out << "Stack only has one matrix" << std::endl;
+        matrices.push(first);
+        return;
+    }
+    const SquareMatrix& second = *matrices.top();
+    const char* name = (op == '+') ? "addition" : (op == '-') ? "subtraction" : "multiplication";
+
+    // operands that cannot be read back are evaluated, so results also depend on the valuation
+    CachedOperation cached_op = (op == '+') ? CachedOperation::Add : (op == '-') ? CachedOperation::Subtract : CachedOperation::Multiply;
+    // modulus is never 1, so 1 marks exact mode
+    std::uint64_t mode = mod ? mod->getValue() : exact ? 1 : 0;
+    std::shared_ptr<SquareMatrix> res_ptr = cache.find(cached_op, *first, &second, v, mode);
+    if(res_ptr == nullptr && exact)
+    {
+        try
+        {
+            ExactSquareMatrix m1 = toExact(*first, v);
+            ExactSquareMatrix m2 = toExact(second, v);
+            if(op == '+')
+                res_ptr = std::make_shared<ExactSquareMatrix>(exactAdd(m1, m2));
+            else if(op == '-')
+                res_ptr = std::make_shared<ExactSquareMatrix>(exactSubtract(m1, m2));
+            else
+                res_ptr = std::make_shared<ExactSquareMatrix>(exactMultiply(m1, m2, progress));
+        }
+        catch(const std::invalid_argument& ia)
+        {
+            out << ia.what() << std::endl;
+            matrices.push(first);
+            return;
+        }
+        catch(const OperationCancelled& oc)
+        {
+            out << "Cancelled " << name << std::endl;
+            matrices.push(first);
+            return;
+        }
+        cache.insert(cached_op, *first, &second, v, mode, res_ptr);
+    }
+    else if(res_ptr == nullptr && mod != nullptr)
+    {
+        try
+        {
+            ConcreteSquareMatrix m1 = evaluateWatched(*first, v, progress);
+            ConcreteSquareMatrix m2 = evaluateWatched(second, v, progress);
+            if(op == '+')
+                res_ptr = std::make_shared<ConcreteSquareMatrix>(modularAdd(m1, m2, *mod));
+            else if(op == '-')
+                res_ptr = std::make_shared<ConcreteSquareMatrix>(modularSubtract(m1, m2, *mod));
+            else
+                res_ptr = std::make_shared<ConcreteSquareMatrix>(modularMultiply(m1, m2, *mod, progress));
+        }
+        catch(const std::invalid_argument& ia)
+        {
+            out << ia.what() << std::endl;
+            matrices.push(first);
+            return;
+        }
+        catch(const OperationCancelled& oc)
+        {
+            out << "Cancelled " << name << std::endl;
+            matrices.push(first);
+            return;
+        }
+        cache.insert(cached_op, *first, &second, v, mode, res_ptr);
+    }
+    else if(res_ptr == nullptr)
+    {
+        SymbolicSquareMatrix m1;
+        SymbolicSquareMatrix m2;
+        if(!readOperand(*first, v, m1, out) || !readOperand(second, v, m2, out))
+        {
+            matrices.push(first);
+            return;
+        }
+
+        try
+        {
+            if(op == '+')
+                res_ptr = std::make_shared<SymbolicSquareMatrix>(m1 + m2);
+            else if(op == '-')
+                res_ptr = std::make_shared<SymbolicSquareMatrix>(m1 - m2);
+            else
+                res_ptr = std::make_shared<SymbolicSquareMatrix>(multiply(m1, m2, progress));
+        }
+        catch(const std::invalid_argument& ia)
+        {
+            out << ia.what() << std::endl;
+            matrices.push(first);
+            return;
+        }
+        catch(const OperationCancelled& oc)
+        {
+            out << "Cancelled " << name << std::endl;
+            matrices.push(first);
+            return;
+        }
+        cache.insert(cached_op, *first, &second, v, mode, res_ptr);
+    }
+    matrices.push(res_ptr);
+    out << "Added result of " << name << ": " << res_ptr->toString() << " to the stack" << std::endl;
+}
+
+void semiringOperation(std::stack<std::shared_ptr<SquareMatrix>>& matrices, const Valuation& v, ResultCache& cache, Semiring s,
+                       std::ostream& out, Progress* progress)
+{
+    if(matrices.empty())
+    {
+        out << "Stack is empty" << std::endl;
+        return;
+    }
+    std::shared_ptr<SquareMatrix> first = matrices.top();
+    matrices.pop();
+    if(matrices.empty())
+    {
+        out << "Stack only has one matrix" << std::endl;
+        matrices.push(first);
+        return;
+    }
+
+    std::shared_ptr<SquareMatrix> res_ptr;
+    try
+    {
+        std::shared_ptr<const ConcreteSquareMatrix> m1;
+        std::shared_ptr<const ConcreteSquareMatrix> m2;
+        try
+        {
+            m1 = evaluateCached(*first, v, cache, progress);
+            m2 = evaluateCached(*matrices.top(), v, cache, progress);
+        }
+        catch(const std::invalid_argument& ia)
+        {
+            out << "Couldn't do evaluation, please declare values to variables" << std::endl;
+            matrices.push(first);
+            return;
+        }
+        res_ptr = std::make_shared<ConcreteSquareMatrix>(semiringMultiply(*m1, *m2, s, progress));
+    }
+    catch(const std::invalid_argument& ia)
+    {
+        out << ia.what() << std::endl;
+        matrices.push(first);
+        return;
+    }
+    catch(const OperationCancelled& oc)
+    {
+        out << "Cancelled " << semiringName(s) << " multiplication" << std::endl;
+        matrices.push(first);
+        return;
+    }
+    matrices.push(res_ptr);
+    out << "Added result of " << semiringName(s) << " multiplication: " << res_ptr->toString() << " to the stack" << std::endl;
+}
+
+std::shared_ptr<const ConcreteSquareMatrix> evaluateCached(const SquareMatrix& m, const Valuation& v, ResultCache& cache, Progress* progress)
+{
+    std::shared_ptr<SquareMatrix> res_ptr = cache.find(CachedOperation::Evaluate, m, nullptr, v);
+    if(res_ptr == nullptr)
+    {
+        res_ptr = std::make_shared<ConcreteSquareMatrix>(evaluateWatched(m, v, progress));
+        cache.insert(CachedOperation::Evaluate, m, nullptr, v, 0, res_ptr);
+    }
+    return std::static_pointer_cast<const ConcreteSquareMatrix>(res_ptr);
+}
+
+std::shared_ptr<SquareMatrix> transposeCached(const SquareMatrix& m, const Valuation& v, ResultCache& cache, std::ostream& os)
+{
+    std::shared_ptr<SquareMatrix> res_ptr = cache.find(CachedOperation::Transpose, m, nullptr, v);
+    if(res_ptr == nullptr)
+    {
+        SymbolicSquareMatrix sm;
+        if(!readOperand(m, v, sm, os))
+            return nullptr;
+        res_ptr = std::make_shared<SymbolicSquareMatrix>(sm.transpose());
+        cache.insert(CachedOperation::Transpose, m, nullptr, v, 0, res_ptr);
+    }
+    return res_ptr;
+}
+
+std::shared_ptr<SquareMatrix> power(const SquareMatrix& m, unsigned long long e, const Valuation& v, ResultCache& cache, const Modulus* mod, bool exact,
+                                    Progress* progress)
+{
+    if(exact)
+    {
+        return std::make_shared<ExactSquareMatrix>(exactPower(toExact(m, v), e, progress));
+    }
+    if(mod != nullptr)
+    {
+        return std::make_shared<ConcreteSquareMatrix>(modularPower(*evaluateCached(m, v, cache, progress), e, *mod, progress));
+    }
+
+    std::shared_ptr<const ConcreteSquareMatrix> base = evaluateCached(m, v, cache, progress);
+    unsigned int n = base->getSize();
+
+    // small powers are squared in registers and built once
+    std::shared_ptr<SquareMatrix> fixed;
+    if(dispatchFixed(n, [&](auto size)
+    {
+        constexpr unsigned int N = decltype(size)::value;
+        FixedSquareMatrix<unsigned int, N> result = FixedSquareMatrix<unsigned int, N>::identity();
+        FixedSquareMatrix<unsigned int, N> square = toFixed<N, unsigned int>(*base);
+        for( ; e != 0; e >>= 1)
+        {
+            if(e & 1)
+                result = result * square;
+            if(e > 1)
+                square = square * square;
+        }
+        fixed = std::make_shared<ConcreteSquareMatrix>(toConcrete(result));
+    }))
+    {
+        return fixed;
+    }
+
+    std::vector<int> identity(static_cast<std::size_t>(n) * n, 0);
+    for(unsigned int i = 0; i < n; i++)
+        identity[static_cast<std::size_t>(i) * n + i] = 1;
+
+    ConcreteSquareMatrix result = ConcreteSquareMatrix::fromValues(n, identity.data());
+    ConcreteSquareMatrix square = *base;
+    for( ; e != 0; e >>= 1)
+    {
+        if(e & 1)
+            result = multiply(result, square, progress);
+        if(e > 1)
+            square = multiply(square, square, progress);
+    }
+    return std::make_shared<ConcreteSquareMatrix>(std::move(result));
+}
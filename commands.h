@@ -0,0 +1,120 @@
+/**
+    \file commands.h
+    \brief Header for stack commands shared by the interactive calculator and the server
+*/
+
+#ifndef COMMANDS_H_INCLUDED
+#define COMMANDS_H_INCLUDED
+#include "elementarymatrix.h"
+#include "exactmatrix.h"
+#include "modular.h"
+#include "progress.h"
+#include "resultcache.h"
+#include "semiring.h"
+#include <iostream>
+#include <memory>
+#include <stack>
+#include <string>
+
+/**
+    \brief Read matrix given on one line
+    \param line the line
+    \return Pointer to SymbolicSquareMatrix object, nullptr if line is not a valid matrix
+*/
+std::shared_ptr<SquareMatrix> readMatrixLine(const std::string& line);
+
+/**
+    \brief Read stack entry as SymbolicSquareMatrix, entries that cannot be read back are evaluated first
+    \param m stack entry
+    \param v map where variable values are stored
+    \param out matrix to read into
+    \param os stream for messages
+    \return true if matrix could be read
+*/
+bool readOperand(const SquareMatrix& m, const Valuation& v, SymbolicSquareMatrix& out, std::ostream& os = std::cout);
+
+/**
+    \brief Evaluate stack entry, symbolic matrices report their rows to progress
+    \param m stack entry
+    \param v map where variable values are stored
+    \param progress progress of the rows, nullptr if not watched
+    \throw std::invalid_argument if evaluation cannot be done
+    \throw OperationCancelled if progress is cancelled
+    \return ConcreteSquareMatrix object
+*/
+ConcreteSquareMatrix evaluateWatched(const SquareMatrix& m, const Valuation& v, Progress* progress);
+
+/**
+    \brief Convert stack entry to ExactSquareMatrix, other entries are evaluated first
+    \param m stack entry
+    \param v map where variable values are stored
+    \throw std::invalid_argument if evaluation cannot be done
+    \return ExactSquareMatrix object
+*/
+ExactSquareMatrix toExact(const SquareMatrix& m, const Valuation& v);
+
+/**
+    \brief Perform +, - or * to the two topmost matrices and push the result, results are looked up in cache first
+    \param matrices stack of matrices
+    \param v map where variable values are stored
+    \param cache cache of results
+    \param op character of operation
+    \param mod modulus in modular mode, nullptr otherwise
+    \param exact true in exact mode
+    \param out stream for messages
+    \param progress progress of multiplication and evaluation, nullptr if not watched
+*/
+void stackOperation(std::stack<std::shared_ptr<SquareMatrix>>& matrices, const Valuation& v, ResultCache& cache, char op, const Modulus* mod, bool exact,
+                    std::ostream& out = std::cout, Progress* progress = nullptr);
+
+/**
+    \brief Multiply the two topmost matrices over a semiring and push the result, operands are evaluated first
+    \param matrices stack of matrices
+    \param v map where variable values are stored
+    \param cache cache of evaluations
+    \param s the semiring
+    \param out stream for messages
+    \param progress progress of multiplication and evaluation, nullptr if not watched
+*/
+void semiringOperation(std::stack<std::shared_ptr<SquareMatrix>>& matrices, const Valuation& v, ResultCache& cache, Semiring s,
+                       std::ostream& out = std::cout, Progress* progress = nullptr);
+
+/**
+    \brief Evaluate matrix, result is looked up in cache first
+    \param m matrix to evaluate
+    \param v map where variable values are stored
+    \param cache cache of results
+    \param progress progress of the rows, nullptr if not watched
+    \throw std::invalid_argument if evaluation cannot be done
+    \throw OperationCancelled if progress is cancelled
+    \return Pointer to ConcreteSquareMatrix object
+*/
+std::shared_ptr<const ConcreteSquareMatrix> evaluateCached(const SquareMatrix& m, const Valuation& v, ResultCache& cache, Progress* progress = nullptr);
+
+/**
+    \brief Transpose matrix, result is looked up in cache first
+    \param m matrix to transpose
+    \param v map where variable values are stored
+    \param cache cache of results
+    \param os stream for messages
+    \return Pointer to transposed matrix, nullptr if matrix could not be read
+*/
+std::shared_ptr<SquareMatrix> transposeCached(const SquareMatrix& m, const Valuation& v, ResultCache& cache, std::ostream& os = std::cout);
+
+/**
+    \brief Raise matrix to a power by repeated squaring
+    \param m the matrix
+    \param e exponent
+    \param v map where variable values are stored
+    \param cache cache of evaluations
+    \param mod modulus in modular mode, nullptr otherwise
+    \param exact true in exact mode
+    \param progress progress of multiplications and evaluation, nullptr if not watched
+    \throw std::invalid_argument if evaluation cannot be done
+    \throw OperationCancelled if progress is cancelled
+    \return Pointer to the power
+*/
+std::shared_ptr<SquareMatrix> power(const SquareMatrix& m, unsigned long long e, const Valuation& v, ResultCache& cache, const Modulus* mod, bool exact,
+                                    Progress* progress = nullptr);
+
+#endif // COMMANDS_H_INCLUDED
@@ -1,58 +1,275 @@
-/**
-    \file compositeelement.cpp
-    \brief Code for CompositeElement class
-*/
-
-#include "compositeelement.h"
-#include <sstream>
-
-CompositeElement::CompositeElement(const Element& e1, const Element& e2, const std::function<int(int,int)>& op, char opc)
-{
-    oprnd1 = std::shared_ptr<Element>(static_cast<Element*>(e1.clone()));
-    oprnd2 = std::shared_ptr<Element>(static_cast<Element*>(e2.clone()));
-    op_fun = op;
-
-    if(opc == '+' || opc == '-' || opc == '*')
-    {
-        op_ch = opc;
-    }
-    else
-    {
-        throw std::invalid_argument("Symbol must be +, - or *");
-    }
-}
-
-CompositeElement::CompositeElement(const CompositeElement& e)
-{
-    oprnd1 = e.oprnd1;
-    oprnd2 = e.oprnd2;
-    op_fun = e.op_fun;
-    op_ch = e.op_ch;
-}
-
-CompositeElement& CompositeElement::operator=(const CompositeElement& e)
-{
-    oprnd1 = e.oprnd1;
-    oprnd2 = e.oprnd2;
-    op_fun = e.op_fun;
-    op_ch = e.op_ch;
-
-    return *this;
-}
-
-Element* CompositeElement::clone() const
-{
-    return new CompositeElement(*this);
-}
-
-std::string CompositeElement::toString() const
-{
-    std::stringstream strm;
-    strm << '(' << *oprnd1 << op_ch << *oprnd2 << ')';
-    return strm.str();
-}
-
-int CompositeElement::evaluate(const Valuation& v) const
-{
-    return op_fun(oprnd1->evaluate(v), oprnd2->evaluate(v));
-}
+/**
+    \file compositeelement.cpp
+    \brief Code for CompositeElement class
+*/
+
+#include "compositeelement.h"
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    /**
+        \brief Position in a CompositeElement during iterative traversal
+    */
+    struct Frame
+    {
+        const CompositeElement* element;
+        unsigned char stage;    ///< 0 before first operand, 1 before second operand, 2 after both
+    };
+
+    /**
+        \brief CompositeElement whose operand is being evaluated
+    */
+    struct EvaluationFrame
+    {
+        const CompositeElement* element;
+        int first;      ///< value of first operand once second is true
+        bool second;    ///< true while the second operand is evaluated
+    };
+}
+
+Operation operationFromSymbol(char opc)
+{
+    if(opc == '+')
+        return Operation::Add;
+    if(opc == '-')
+        return Operation::Subtract;
+    if(opc == '*')
+        return Operation::Multiply;
+    throw std::invalid_argument("Symbol must be +, - or *");
+}
+
+CompositeElement::CompositeElement(const Element& e1, const Element& e2, char opc): op(operationFromSymbol(opc))
+{
+    oprnd1 = std::shared_ptr<Element>(static_cast<Element*>(e1.clone()));
+    oprnd2 = std::shared_ptr<Element>(static_cast<Element*>(e2.clone()));
+    composite1 = dynamic_cast<const CompositeElement*>(oprnd1.get()) != nullptr;
+    composite2 = dynamic_cast<const CompositeElement*>(oprnd2.get()) != nullptr;
+    hash_value = hashCombine(hashCombine(static_cast<unsigned char>(opc), oprnd1->hash()), oprnd2->hash());
+}
+
+CompositeElement::CompositeElement(const std::shared_ptr<Element>& e1, const std::shared_ptr<Element>& e2, Operation operation): op(operation)
+{
+    oprnd1 = e1;
+    oprnd2 = e2;
+    composite1 = dynamic_cast<const CompositeElement*>(oprnd1.get()) != nullptr;
+    composite2 = dynamic_cast<const CompositeElement*>(oprnd2.get()) != nullptr;
+    hash_value = hashCombine(hashCombine(static_cast<unsigned char>(operationSymbol(op)), oprnd1->hash()), oprnd2->hash());
+}
+
+CompositeElement::CompositeElement(const std::shared_ptr<Element>& e1, const std::shared_ptr<Element>& e2, char opc):
+    CompositeElement(e1, e2, operationFromSymbol(opc))
+{
+}
+
+CompositeElement::CompositeElement(const CompositeElement& e)
+{
+    oprnd1 = e.oprnd1;
+    oprnd2 = e.oprnd2;
+    hash_value = e.hash_value;
+    op = e.op;
+    composite1 = e.composite1;
+    composite2 = e.composite2;
+}
+
+CompositeElement& CompositeElement::operator=(const CompositeElement& e)
+{
+    oprnd1 = e.oprnd1;
+    oprnd2 = e.oprnd2;
+    hash_value = e.hash_value;
+    op = e.op;
+    composite1 = e.composite1;
+    composite2 = e.composite2;
+
+    return *this;
+}
+
+CompositeElement::~CompositeElement()
+{
+    // operands owned only by this element are taken apart here, so deep trees are not destroyed recursively
+    auto unique = [](const std::shared_ptr<Element>& p)
+    {
+        return p.use_count() == 1 && dynamic_cast<const CompositeElement*>(p.get()) != nullptr;
+    };
+    if(!unique(oprnd1) && !unique(oprnd2))
+        return;
+
+    std::vector<std::shared_ptr<Element>> pending;
+    pending.push_back(std::move(oprnd1));
+    pending.push_back(std::move(oprnd2));
+    while(!pending.empty())
+    {
+        std::shared_ptr<Element> current = std::move(pending.back());
+        pending.pop_back();
+        if(unique(current))
+        {
+            CompositeElement* ce = static_cast<CompositeElement*>(current.get());
+            pending.push_back(std::move(ce->oprnd1));
+            pending.push_back(std::move(ce->oprnd2));
+        }
+    }
+}
+
+Element* CompositeElement::clone() const
+{
+    return new CompositeElement(*this);
+}
+
+std::string CompositeElement::toString() const
+{
+    std::string str;
+    appendTo(str);
+    return str;
+}
+
+void CompositeElement::appendTo(std::string& out) const
+{
+    std::vector<Frame> frames;
+    frames.push_back({this, 0});
+    out += '(';
+
+    while(!frames.empty())
+    {
+        Frame& f = frames.back();
+        const Element* operand;
+        if(f.stage == 0)
+        {
+            operand = f.element->oprnd1.get();
+        }
+        else if(f.stage == 1)
+        {
+            out += operationSymbol(f.element->op);
+            operand = f.element->oprnd2.get();
+        }
+        else
+        {
+            out += ')';
+            frames.pop_back();
+            continue;
+        }
+        f.stage++;
+
+        if(const CompositeElement* ce = f.element->compositeOperand(operand))
+        {
+            out += '(';
+            frames.push_back({ce, 0});
+        }
+        else
+        {
+            operand->appendTo(out);
+        }
+    }
+}
+
+int CompositeElement::evaluate(const Valuation& v) const
+{
+    // the stack is kept between calls, so evaluating the same deep tree again does not grow it from empty;
+    // operands that are not composite never evaluate a CompositeElement, so it is not used reentrantly
+    thread_local std::vector<EvaluationFrame> frames;
+    frames.clear();
+
+    const CompositeElement* node = this;
+    int value;
+    while(true)
+    {
+        while(node->composite1)
+        {
+            frames.push_back({node, 0, false});
+            node = static_cast<const CompositeElement*>(node->oprnd1.get());
+        }
+        value = node->oprnd1->evaluate(v);
+
+        // value belongs to the first operand of node, nodes are finished until a composite second operand is found
+        while(!node->composite2)
+        {
+            value = applyOperation(node->op, value, node->oprnd2->evaluate(v));
+            while(!frames.empty() && frames.back().second)
+            {
+                value = applyOperation(frames.back().element->op, frames.back().first, value);
+                frames.pop_back();
+            }
+            if(frames.empty())
+                return value;
+            node = frames.back().element;
+            frames.pop_back();
+        }
+        frames.push_back({node, value, true});
+        node = static_cast<const CompositeElement*>(node->oprnd2.get());
+    }
+}
+
+Element* CompositeElement::specialize(const Valuation& v) const
+{
+    std::vector<Frame> frames;
+    std::vector<std::shared_ptr<Element>> results;
+    frames.push_back({this, 0});
+
+    while(!frames.empty())
+    {
+        Frame& f = frames.back();
+        if(f.stage == 2)
+        {
+            std::shared_ptr<Element> spec2 = std::move(results.back());
+            results.pop_back();
+            std::shared_ptr<Element>& spec1 = results.back();
+            const IntElement* int1 = dynamic_cast<const IntElement*>(spec1.get());
+            const IntElement* int2 = dynamic_cast<const IntElement*>(spec2.get());
+
+            if(int1 && int2)
+                spec1 = std::make_shared<IntElement>(applyOperation(f.element->op, int1->getVal(), int2->getVal()));
+            else
+                spec1 = std::make_shared<CompositeElement>(spec1, spec2, f.element->op);
+            frames.pop_back();
+            continue;
+        }
+
+        const Element* operand = (f.stage == 0) ? f.element->oprnd1.get() : f.element->oprnd2.get();
+        f.stage++;
+        if(const CompositeElement* ce = f.element->compositeOperand(operand))
+            frames.push_back({ce, 0});
+        else
+            results.emplace_back(operand->specialize(v));
+    }
+
+    const Element& result = *results.back();
+    return result.clone();
+}
+
+std::uint64_t CompositeElement::hash() const
+{
+    return hash_value;
+}
+
+bool CompositeElement::equals(const Element& e) const
+{
+    std::vector<std::pair<const Element*, const Element*>> pending;
+    pending.emplace_back(this, &e);
+
+    while(!pending.empty())
+    {
+        const Element* a = pending.back().first;
+        const Element* b = pending.back().second;
+        pending.pop_back();
+        if(a == b)
+            continue;
+
+        const CompositeElement* ca = dynamic_cast<const CompositeElement*>(a);
+        if(ca == nullptr)
+        {
+            if(!(*a == *b))
+                return false;
+            continue;
+        }
+
+        const CompositeElement* cb = dynamic_cast<const CompositeElement*>(b);
+        if(cb == nullptr || cb->op != ca->op || cb->hash_value != ca->hash_value)
+        {
+            return false;
+        }
+        pending.emplace_back(ca->oprnd2.get(), cb->oprnd2.get());
+        pending.emplace_back(ca->oprnd1.get(), cb->oprnd1.get());
+    }
+    return true;
+}
@@ -1,70 +1,224 @@
-/**
-    \file compositeelement.h
-    \brief Header for CompositeElement class
-*/
-#ifndef COMPOSITEELEMENT_H_INCLUDED
-#define COMPOSITEELEMENT_H_INCLUDED
-#include "element.h"
-#include <functional>
-
-/**
-    \class CompositeElement
-    \brief CompositeElement class
-*/
-class CompositeElement : public Element
-{
-    private:
-        std::shared_ptr<Element> oprnd1;
-        std::shared_ptr<Element> oprnd2;
-        std::function<int(int,int)> op_fun;
-        char op_ch;
-    public:
-
-        /**
-            \brief Parametric constructor
-            \param e1 Element object
-            \param e2 Element object
-            \param op Function object used for integer operations
-            \param opc Character representing operation to perform
-        */
-        CompositeElement(const Element& e1, const Element& e2, const std::function<int(int,int)>& op, char opc);
-
-        /**
-            \brief Copy constructor
-            \param e CompositeElement to copy
-        */
-        CompositeElement(const CompositeElement& e);
-
-        /**
-            \brief Assignment operator
-            \param e CompositeElement to assign
-            \return Assigned object
-        */
-        CompositeElement& operator=(const CompositeElement& e);
-
-        /**
-            \brief Destructor
-        */
-        virtual ~CompositeElement() = default;
-
-        /**
-            \brief Return a pointer to a copy of CompositeElement
-            \return Pointer to copy
-        */
-        Element* clone() const override;
-
-        /**
-            \brief Makes string representation of CompositeElement
-            \return The string representation
-        */
-        std::string toString() const override;
-
-        /**
-            \brief Evaluate variable
-            \param v map where variable values are stored
-            \return Result of evaluation
-        */
-        int evaluate(const Valuation& v) const override;
-};
-
-#endif // COMPOSITEELEMENT_H_INCLUDED
+/**
+    \file compositeelement.h
+    \brief Header for CompositeElement class
+*/
+#ifndef COMPOSITEELEMENT_H_INCLUDED
+#define COMPOSITEELEMENT_H_INCLUDED
+#include "element.h"
+
+/**
+    \brief Operation of CompositeElement
+*/
+enum class Operation : std::uint8_t
+{
+    Add,
+    Subtract,
+    Multiply
+};
+
+/**
+    \brief Get operation represented by a character
+    \param opc '+', '-' or '*'
+    \throw std::invalid_argument if opc is not +, - or *
+    \return The operation
+*/
+Operation operationFromSymbol(char opc);
+
+/**
+    \brief Get character representing an operation
+    \param op the operation
+    \return '+', '-' or '*'
+*/
+inline char operationSymbol(Operation op)
+{
+    switch(op)
+    {
+        case Operation::Add:
+            return '+';
+        case Operation::Subtract:
+            return '-';
+        default:
+            return '*';
+    }
+}
+
+/**
+    \brief Apply operation to two integers, results that do not fit wrap around
+    \param op the operation
+    \param a first operand
+    \param b second operand
+    \return Result of operation
+*/
+inline int applyOperation(Operation op, int a, int b)
+{
+    // unsigned arithmetic wraps without undefined behaviour, like batches and fixed size matrices
+    unsigned int x = static_cast<unsigned int>(a);
+    unsigned int y = static_cast<unsigned int>(b);
+    switch(op)
+    {
+        case Operation::Add:
+            return static_cast<int>(x + y);
+        case Operation::Subtract:
+            return static_cast<int>(x - y);
+        default:
+            return static_cast<int>(x * y);
+    }
+}
+
+/**
+    \class CompositeElement
+    \brief CompositeElement class
+
+    Printing, evaluation, specialization, comparison and destruction walk the tree with
+    explicit work stacks, so the depth of the tree does not affect native stack usage.
+*/
+class CompositeElement : public Element
+{
+    private:
+        std::shared_ptr<Element> oprnd1;
+        std::shared_ptr<Element> oprnd2;
+        std::uint64_t hash_value;
+        Operation op;
+        bool composite1;    ///< true if first operand is a CompositeElement
+        bool composite2;    ///< true if second operand is a CompositeElement
+
+        /**
+            \brief Tell if operand is a CompositeElement without dynamic_cast
+            \param operand first or second operand of this element
+            \return operand as CompositeElement or nullptr
+        */
+        const CompositeElement* compositeOperand(const Element* operand) const
+        {
+            bool composite = (operand == oprnd1.get()) ? composite1 : composite2;
+            return composite ? static_cast<const CompositeElement*>(operand) : nullptr;
+        }
+    public:
+
+        /**
+            \brief Parametric constructor
+            \param e1 Element object
+            \param e2 Element object
+            \param opc Character representing operation to perform
+            \throw std::invalid_argument if opc is not +, - or *
+        */
+        CompositeElement(const Element& e1, const Element& e2, char opc);
+
+        /**
+            \brief Parametric constructor sharing already built operands
+            \param e1 first operand
+            \param e2 second operand
+            \param operation operation to perform
+        */
+        CompositeElement(const std::shared_ptr<Element>& e1, const std::shared_ptr<Element>& e2, Operation operation);
+
+        /**
+            \brief Parametric constructor sharing already built operands
+            \param e1 first operand
+            \param e2 second operand
+            \param opc Character representing operation to perform
+            \throw std::invalid_argument if opc is not +, - or *
+        */
+        CompositeElement(const std::shared_ptr<Element>& e1, const std::shared_ptr<Element>& e2, char opc);
+
+        /**
+            \brief Copy constructor
+            \param e CompositeElement to copy
+        */
+        CompositeElement(const CompositeElement& e);
+
+        /**
+            \brief Assignment operator
+            \param e CompositeElement to assign
+            \return Assigned object
+        */
+        CompositeElement& operator=(const CompositeElement& e);
+
+        /**
+            \brief Destructor, operands are released without recursion
+        */
+        virtual ~CompositeElement();
+
+        /**
+            \brief Return a pointer to a copy of CompositeElement
+            \return Pointer to copy
+        */
+        Element* clone() const override;
+
+        /**
+            \brief Makes string representation of CompositeElement
+            \return The string representation
+        */
+        std::string toString() const override;
+
+        /**
+            \brief Append string representation of CompositeElement to the end of a string
+            \param out string to append to
+        */
+        void appendTo(std::string& out) const override;
+
+        /**
+            \brief Evaluate variable
+            \param v map where variable values are stored
+            \return Result of evaluation
+        */
+        int evaluate(const Valuation& v) const override;
+
+        /**
+            \brief Substitute bound variables and fold operations whose operands are both known
+            \param v map where variable values are stored
+            \return Pointer to IntElement if whole expression is known, otherwise pointer to reduced CompositeElement
+        */
+        Element* specialize(const Valuation& v) const override;
+
+        /**
+            \brief Return hash of CompositeElement, calculated once when object is constructed
+            \return The hash
+        */
+        std::uint64_t hash() const override;
+
+        /**
+            \brief Function to get first operand
+            \return Pointer to operand
+        */
+        const std::shared_ptr<Element>& getOperand1() const
+        {
+            return oprnd1;
+        }
+
+        /**
+            \brief Function to get second operand
+            \return Pointer to operand
+        */
+        const std::shared_ptr<Element>& getOperand2() const
+        {
+            return oprnd2;
+        }
+
+        /**
+            \brief Function to get operation
+            \return Character representing operation
+        */
+        char getOperator() const
+        {
+            return operationSymbol(op);
+        }
+
+        /**
+            \brief Function to get operation
+            \return The operation
+        */
+        Operation getOperation() const
+        {
+            return op;
+        }
+
+        /**
+            \brief Compare operation and operands with another Element
+            \param e Element to compare with
+            \return true if e is a CompositeElement with same operation and same operands
+            \return false otherwise
+        */
+        bool equals(const Element& e) const override;
+};
+
+#endif // COMPOSITEELEMENT_H_INCLUDED
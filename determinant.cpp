@@ -0,0 +1,530 @@
+/**
+    \file determinant.cpp
+    \brief Code for calculating exact determinant of ConcreteSquareMatrix
+*/
+
+#include "determinant.h"
+#include "fixedmatrix.h"
+#include "modular.h"
+#include "taskscheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace
+{
+    /// Matrices smaller than this are eliminated in one thread
+    const unsigned int parallel_threshold = 256;
+
+    /// Largest prime below 2^31, products of two reduced numbers fit 62 bits
+    const std::uint32_t largest_prime = 2147483647u;
+
+    /// Elimination steps updating fewer values than this are done in the calling thread
+    const std::size_t parallel_step_work = std::size_t(1) << 14;
+
+    /// Number of columns updated at a time, keeps the used part of pivot row in cache for large n
+    const unsigned int column_tile = 1024;
+
+    template <typename W>
+    struct UnsignedOf;
+
+    template <>
+    struct UnsignedOf<long long>
+    {
+        using type = unsigned long long;
+    };
+
+#ifdef __SIZEOF_INT128__
+    template <>
+    struct UnsignedOf<__int128>
+    {
+        using type = unsigned __int128;
+    };
+#endif
+
+    /**
+        \brief Multiply and subtract with overflow check
+        \return false if a*b - c*d does not fit in W
+    */
+    template <typename W>
+    inline bool mulSub(W a, W b, W c, W d, W& result)
+    {
+        W ab;
+        W cd;
+        return !__builtin_mul_overflow(a, b, &ab) && !__builtin_mul_overflow(c, d, &cd) && !__builtin_sub_overflow(ab, cd, &result);
+    }
+
+    /**
+        \class ExactDivisor
+        \brief Divides numbers known to be multiples of the divisor with one multiplication
+    */
+    template <typename W>
+    class ExactDivisor
+    {
+        private:
+            using U = typename UnsignedOf<W>::type;
+            U inverse;
+            unsigned int shift = 0;
+        public:
+
+            /**
+                \brief Parametric constructor
+                \param d divisor, must not be 0
+            */
+            explicit ExactDivisor(W d)
+            {
+                while((d & 1) == 0)
+                {
+                    d >>= 1;
+                    shift++;
+                }
+
+                // Newton iteration doubles the number of correct low bits, d*d == 1 mod 8 to start with
+                U odd = static_cast<U>(d);
+                inverse = odd;
+                for(unsigned int bits = 3; bits < std::numeric_limits<U>::digits; bits *= 2)
+                {
+                    inverse *= 2 - odd * inverse;
+                }
+            }
+
+            /**
+                \brief Divide exact multiple of divisor
+                \param x number to divide
+                \return x divided by divisor
+            */
+            W divide(W x) const
+            {
+                return static_cast<W>(static_cast<U>(x >> shift) * inverse);
+            }
+    };
+
+    /**
+        \brief Call f(begin, end) for at most about the given number of parts of [first, last) on the global scheduler
+        \param first start of range
+        \param last end of range
+        \param parts number of parts, 1 calls f in the calling thread
+        \param f function called with subranges
+    */
+    template <typename F>
+    void forParts(std::size_t first, std::size_t last, unsigned int parts, const F& f)
+    {
+        if(parts <= 1)
+        {
+            if(first < last)
+                f(first, last);
+            return;
+        }
+        parallelFor(first, last, (last - first + parts - 1) / parts, f);
+    }
+
+    /**
+        \brief Bareiss elimination of contiguous row-major working copy, rows of each step are divided between threads
+        \param a working copy, overwritten
+        \param n number of rows and columns
+        \param threads number of parts the rows of each step are divided into
+        \param det determinant if elimination succeeds
+        \param progress progress reported by elimination steps and checked for cancellation, may be nullptr
+        \throw OperationCancelled if progress is cancelled
+        \return false if an intermediate value overflows
+    */
+    template <typename W>
+    bool eliminate(std::vector<W>& a, unsigned int n, unsigned int threads, W& det, Progress* progress)
+    {
+        std::atomic<bool> overflow(false);
+        bool negative = false;
+        W prev = 1;
+        if(progress)
+            progress->setTotal(n);
+
+        for(unsigned int k = 0; k + 1 < n; k++)
+        {
+            if(progress)
+                progress->check();
+
+            unsigned int p = k;
+            while(p < n && a[static_cast<std::size_t>(p) * n + k] == 0)
+                p++;
+            if(p == n)
+            {
+                det = 0;
+                return true;
+            }
+            if(p != k)
+            {
+                std::swap_ranges(a.begin() + static_cast<std::size_t>(p) * n + k, a.begin() + static_cast<std::size_t>(p + 1) * n,
+                                 a.begin() + static_cast<std::size_t>(k) * n + k);
+                negative = !negative;
+            }
+
+            const W* pivot_row = &a[static_cast<std::size_t>(k) * n];
+            const W pivot = pivot_row[k];
+            const ExactDivisor<W> divisor(prev);
+            auto rows = [&](std::size_t first, std::size_t last)
+            {
+                for(unsigned int j0 = k + 1; j0 < n; j0 += column_tile)
+                {
+                    unsigned int j1 = std::min(n, j0 + column_tile);
+                    for(std::size_t i = first; i < last; i++)
+                    {
+                        W* row = &a[i * n];
+                        W factor = row[k];
+                        if(factor == 0 && pivot == prev)
+                            continue;
+                        for(unsigned int j = j0; j < j1; j++)
+                        {
+                            W x;
+                            if(!mulSub(row[j], pivot, factor, pivot_row[j], x))
+                            {
+                                overflow = true;
+                                return;
+                            }
+                            row[j] = divisor.divide(x);
+                        }
+                    }
+                }
+            };
+
+            std::size_t remaining = n - k - 1;
+            forParts(k + 1, n, remaining * remaining < parallel_step_work ? 1 : threads, rows);
+            if(overflow)
+                return false;
+            prev = pivot;
+            if(progress)
+                progress->advance();
+        }
+
+        det = a[static_cast<std::size_t>(n) * n - 1];
+        return !negative || !__builtin_sub_overflow(W(0), det, &det);
+    }
+
+    /**
+        \brief Convert native working value to BigInt
+    */
+    inline BigInt toBigInt(long long x)
+    {
+        return BigInt(x);
+    }
+
+#ifdef __SIZEOF_INT128__
+    inline BigInt toBigInt(__int128 x)
+    {
+        if(x >= std::numeric_limits<long long>::min() && x <= std::numeric_limits<long long>::max())
+            return BigInt(static_cast<long long>(x));
+
+        const BigInt half(std::int64_t(1) << 32);
+        unsigned __int128 mag = x < 0 ? 0 - static_cast<unsigned __int128>(x) : static_cast<unsigned __int128>(x);
+        BigInt r;
+        for(int shift = 96; shift >= 0; shift -= 32)
+        {
+            r = r * half + BigInt(static_cast<long long>((mag >> shift) & 0xffffffffu));
+        }
+        return x < 0 ? -r : r;
+    }
+
+    /**
+        \brief Tell if cofactor expansion of 4 x 4 matrix fits 128 bits, 24 products of four values below 2^30 do
+        \param m the matrix
+        \return true if all values are below 2^30 in absolute value
+    */
+    bool fitsCofactors(const ConcreteSquareMatrix& m)
+    {
+        const int limit = 1 << 30;
+        for(unsigned int i = 0; i < m.getSize(); i++)
+        {
+            for(unsigned int j = 0; j < m.getSize(); j++)
+            {
+                int value = m.valueAt(i, j);
+                if(value >= limit || value <= -limit)
+                    return false;
+            }
+        }
+        return true;
+    }
+#endif
+
+    template <typename W>
+    bool determinantAs(const std::vector<int>& values, unsigned int n, unsigned int threads, BigInt& det, Progress* progress)
+    {
+        std::vector<W> a(values.begin(), values.end());
+        W result = 0;
+        if(!eliminate(a, n, threads, result, progress))
+            return false;
+
+        det = toBigInt(result);
+        return true;
+    }
+
+    /**
+        \brief Raise reduced number to a power
+        \param mod the modulus
+        \param base reduced number
+        \param e the exponent
+        \return base^e mod p
+    */
+    std::uint32_t power(const Modulus& mod, std::uint32_t base, std::uint32_t e)
+    {
+        std::uint32_t result = 1;
+        while(e != 0)
+        {
+            if(e & 1)
+                result = mod.multiply(result, base);
+            base = mod.multiply(base, base);
+            e >>= 1;
+        }
+        return result;
+    }
+
+    /**
+        \brief Miller-Rabin test, bases 2, 7 and 61 are enough for all 32-bit numbers
+        \param x number to test
+        \return true if x is prime
+    */
+    bool isPrime(std::uint32_t x)
+    {
+        for(std::uint32_t small: {2u, 3u, 5u, 7u, 61u})
+        {
+            if(x % small == 0)
+                return x == small;
+        }
+        if(x < 2)
+            return false;
+
+        Modulus mod(x);
+        std::uint32_t d = x - 1;
+        unsigned int s = 0;
+        while((d & 1) == 0)
+        {
+            d >>= 1;
+            s++;
+        }
+        for(std::uint32_t a: {2u, 7u, 61u})
+        {
+            std::uint32_t y = power(mod, a, d);
+            bool composite = y != 1 && y != x - 1;
+            for(unsigned int r = 1; r < s && composite; r++)
+            {
+                y = mod.multiply(y, y);
+                composite = y != x - 1;
+            }
+            if(composite)
+                return false;
+        }
+        return true;
+    }
+
+    /**
+        \brief Bound size of determinant with Hadamard's inequality, |det| is at most the product of lengths of rows and of columns
+        \param values row-major values
+        \param n number of rows and columns
+        \return Upper bound of log2 |det|, negative infinity if a row or column is zero
+    */
+    double hadamardBits(const std::vector<int>& values, unsigned int n)
+    {
+        std::vector<double> columns(n, 0.0);
+        double row_bits = 0;
+        for(unsigned int i = 0; i < n; i++)
+        {
+            double sum = 0;
+            for(unsigned int j = 0; j < n; j++)
+            {
+                double x = values[static_cast<std::size_t>(i) * n + j];
+                sum += x * x;
+                columns[j] += x * x;
+            }
+            row_bits += 0.5 * std::log2(sum);
+        }
+
+        double column_bits = 0;
+        for(double sum: columns)
+        {
+            column_bits += 0.5 * std::log2(sum);
+        }
+        return std::min(row_bits, column_bits);
+    }
+
+    /**
+        \brief Gaussian elimination modulo prime, rows of each step are divided between threads
+        \param values row-major values
+        \param n number of rows and columns
+        \param mod the modulus, must be prime
+        \param threads number of parts the rows of each step are divided into
+        \param a working copy of n*n numbers, overwritten
+        \param progress checked for cancellation, may be nullptr
+        \throw OperationCancelled if progress is cancelled
+        \return det mod p
+    */
+    std::uint32_t determinantModulo(const std::vector<int>& values, unsigned int n, const Modulus& mod, unsigned int threads,
+                                    std::vector<std::uint32_t>& a, const Progress* progress)
+    {
+        for(std::size_t k = 0; k < a.size(); k++)
+        {
+            a[k] = mod.fromInt(values[k]);
+        }
+
+        std::uint32_t det = 1;
+        for(unsigned int k = 0; k + 1 < n; k++)
+        {
+            if(progress)
+                progress->check();
+
+            unsigned int p = k;
+            while(p < n && a[static_cast<std::size_t>(p) * n + k] == 0)
+                p++;
+            if(p == n)
+                return 0;
+            if(p != k)
+            {
+                std::swap_ranges(a.begin() + static_cast<std::size_t>(p) * n + k, a.begin() + static_cast<std::size_t>(p + 1) * n,
+                                 a.begin() + static_cast<std::size_t>(k) * n + k);
+                det = mod.subtract(0, det);
+            }
+
+            const std::uint32_t* pivot_row = &a[static_cast<std::size_t>(k) * n];
+            det = mod.multiply(det, pivot_row[k]);
+            const std::uint32_t inverse = power(mod, pivot_row[k], mod.getValue() - 2);
+            auto rows = [&](std::size_t first, std::size_t last)
+            {
+                for(std::size_t i = first; i < last; i++)
+                {
+                    std::uint32_t* row = &a[i * n];
+                    if(row[k] == 0)
+                        continue;
+
+                    // adding the negated factor keeps the sum below 2^62, so one reduction per value is enough
+                    const std::uint64_t factor = mod.subtract(0, mod.multiply(row[k], inverse));
+                    for(unsigned int j = k + 1; j < n; j++)
+                    {
+                        row[j] = mod.reduce(row[j] + factor * pivot_row[j]);
+                    }
+                }
+            };
+
+            std::size_t remaining = n - k - 1;
+            forParts(k + 1, n, remaining * remaining < parallel_step_work ? 1 : threads, rows);
+        }
+
+        return mod.multiply(det, a[static_cast<std::size_t>(n) * n - 1]);
+    }
+
+    /**
+        \brief Find integer of residues with Garner's algorithm
+        \param primes distinct primes
+        \param residues the integer modulo each prime
+        \return The integer x with |x| smaller than half of the product of primes
+    */
+    BigInt combineResidues(const std::vector<std::uint32_t>& primes, const std::vector<std::uint32_t>& residues)
+    {
+        // x = d0 + d1*p0 + d2*p0*p1 + ..., digit i is found modulo prime i
+        std::vector<std::uint32_t> digits(primes.size());
+        for(std::size_t i = 0; i < primes.size(); i++)
+        {
+            Modulus mod(primes[i]);
+            std::uint32_t x = residues[i];
+            for(std::size_t j = 0; j < i; j++)
+            {
+                x = mod.multiply(mod.subtract(x, mod.reduce(digits[j])), power(mod, mod.reduce(primes[j]), primes[i] - 2));
+            }
+            digits[i] = x;
+        }
+
+        BigInt result;
+        BigInt product = 1;
+        for(std::size_t i = digits.size(); i-- > 0;)
+        {
+            result = result * BigInt(primes[i]) + BigInt(digits[i]);
+            product *= BigInt(primes[i]);
+        }
+        return product < result + result ? result - product : result;
+    }
+
+    /**
+        \brief Determinant modulo enough primes below 2^31 for Hadamard's bound, used when 128 bits are not enough
+        \param values row-major values
+        \param n number of rows and columns
+        \param threads number of parts the work is divided into
+        \param bits bound of log2 |det|
+        \param progress progress reported by primes and checked for cancellation, may be nullptr
+        \throw OperationCancelled if progress is cancelled
+        \return The determinant
+    */
+    BigInt determinantModular(const std::vector<int>& values, unsigned int n, unsigned int threads, double bits, Progress* progress)
+    {
+        // the product of primes must exceed twice the bound, one more bit covers rounding of the bound
+        std::vector<std::uint32_t> primes;
+        double product_bits = 0;
+        for(std::uint32_t candidate = largest_prime; product_bits < bits + 2; candidate -= 2)
+        {
+            if(isPrime(candidate))
+            {
+                primes.push_back(candidate);
+                product_bits += std::log2(candidate);
+            }
+        }
+
+        // small matrices are eliminated for several primes at once, large ones for one prime at a time with all threads
+        std::vector<std::uint32_t> residues(primes.size());
+        if(progress)
+            progress->setTotal(primes.size());
+        auto eliminatePrimes = [&](std::size_t first, std::size_t last, unsigned int row_threads)
+        {
+            std::vector<std::uint32_t> a(static_cast<std::size_t>(n) * n);
+            for(std::size_t k = first; k < last; k++)
+            {
+                residues[k] = determinantModulo(values, n, Modulus(primes[k]), row_threads, a, progress);
+                if(progress)
+                    progress->advance();
+            }
+        };
+
+        if(n < parallel_threshold)
+            forParts(0, primes.size(), threads, [&](std::size_t first, std::size_t last) { eliminatePrimes(first, last, 1); });
+        else
+            eliminatePrimes(0, primes.size(), threads);
+
+        return combineResidues(primes, residues);
+    }
+}
+
+BigInt determinant(const ConcreteSquareMatrix& m, unsigned int threads, Progress* progress)
+{
+    unsigned int n = m.getSize();
+    if(n == 0)
+        return 1;
+
+#ifdef __SIZEOF_INT128__
+    if(n <= 3 || (n == fixed_matrix_limit && fitsCofactors(m)))
+    {
+        BigInt det;
+        dispatchFixed(n, [&](auto size)
+        {
+            det = toBigInt(toFixed<decltype(size)::value>(m).template determinant<__int128>());
+        });
+        return det;
+    }
+#endif
+
+    if(threads == 0)
+        threads = TaskScheduler::global().getThreadCount();
+    unsigned int row_threads = n < parallel_threshold ? 1 : std::min(threads, n);
+
+    std::vector<int> values(static_cast<std::size_t>(n) * n);
+    m.copyValues(values.data());
+
+    // elimination with native numbers is only tried when the determinant can fit
+    double bits = hadamardBits(values, n);
+    if(std::isinf(bits))
+        return BigInt();
+
+    BigInt det;
+    if(bits < std::numeric_limits<long long>::digits && determinantAs<long long>(values, n, row_threads, det, progress))
+        return det;
+#ifdef __SIZEOF_INT128__
+    if(bits < 127 && determinantAs<__int128>(values, n, row_threads, det, progress))
+        return det;
+#endif
+    return determinantModular(values, n, threads, bits, progress);
+}
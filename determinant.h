@@ -0,0 +1,28 @@
+/**
+    \file determinant.h
+    \brief Header for calculating exact determinant of ConcreteSquareMatrix
+*/
+
+#ifndef DETERMINANT_H_INCLUDED
+#define DETERMINANT_H_INCLUDED
+#include "bigint.h"
+#include "elementarymatrix.h"
+#include "progress.h"
+
+/**
+    \brief Calculate exact determinant with fraction-free Bareiss elimination
+
+    Elimination is done in a contiguous 64-bit working copy and repeated with 128-bit
+    numbers if some intermediate value does not fit. Rows of each elimination step are
+    divided between tasks of the global task scheduler. Hadamard's bound tells when the determinant cannot fit in
+    these, then it is calculated modulo enough primes below 2^31 and combined with the
+    Chinese remainder theorem. Small matrices are eliminated for several primes at once.
+    \param m matrix
+    \param threads number of parts the work is divided into, 0 uses the thread count of the global task scheduler
+    \param progress progress reported by elimination steps or primes and checked for cancellation, may be nullptr
+    \throw OperationCancelled if progress is cancelled
+    \return The determinant, 1 for empty matrix
+*/
+BigInt determinant(const ConcreteSquareMatrix& m, unsigned int threads = 0, Progress* progress = nullptr);
+
+#endif // DETERMINANT_H_INCLUDED
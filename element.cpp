@@ -1,98 +1,150 @@
-/**
-    \file element.cpp
-    \brief Code for Element abstract class and TElement template class
-*/
-
-#include "element.h"
-#include <sstream>
-
-template<>
-std::string TElement<int>::toString() const
-{
-    std::stringstream strm;
-    strm << val;
-    return strm.str();
-}
-
-template<>
-std::string TElement<char>::toString() const
-{
-    std::stringstream strm;
-    strm << val;
-    return strm.str();
-}
-
-template<>
-int TElement<int>::evaluate(const Valuation& v) const
-{
-    return val;
-}
-
-template<>
-int TElement<char>::evaluate(const Valuation& v) const
-{
-    auto iter = v.find(val);
-
-    if(iter != v.end())
-    {
-        return iter->second;
-    }
-
-    throw "Could not find variable";
-}
-
-template<>
-TElement<int>& TElement<int>::operator+=(const TElement<int>& i)
-{
-    val = val + i.val;
-    return *this;
-}
-
-template<>
-TElement<int>& TElement<int>::operator-=(const TElement<int>& i)
-{
-    val = val - i.val;
-    return *this;
-}
-
-template<>
-TElement<int>& TElement<int>::operator*=(const TElement<int>& i)
-{
-    val = val * i.val;
-    return *this;
-}
-
-std::ostream& operator<<(std::ostream& os, const Element& i)
-{
-    os << i.toString();
-    return os;
-}
-
-bool operator==(const Element& i, const Element& j)
-{
-    if(i.toString() == j.toString())
-        return true;
-    else
-        return false;
-}
-
-IntElement operator+(const IntElement& i, const IntElement& j)
-{
-    IntElement element{i};
-    element+=j;
-    return element;
-}
-
-IntElement operator-(const IntElement& i, const IntElement& j)
-{
-    IntElement element{i};
-    element-=j;
-    return element;
-}
-
-IntElement operator*(const IntElement& i, const IntElement& j)
-{
-    IntElement element{i};
-    element*=j;
-    return element;
-}
+/**
+    \file element.cpp
+    \brief Code for Element abstract class and TElement template class
+*/
+
+#include "element.h"
+#include <charconv>
+
+std::uint64_t hashCombine(std::uint64_t seed, std::uint64_t value)
+{
+    std::uint64_t x = seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+template<>
+void TElement<int>::appendTo(std::string& out) const
+{
+    char buffer[16];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), val);
+    out.append(buffer, result.ptr);
+}
+
+template<>
+void TElement<char>::appendTo(std::string& out) const
+{
+    out += val;
+}
+
+template<>
+std::string TElement<int>::toString() const
+{
+    std::string str;
+    appendTo(str);
+    return str;
+}
+
+template<>
+std::string TElement<char>::toString() const
+{
+    return std::string(1, val);
+}
+
+template<>
+int TElement<int>::evaluate(const Valuation& v) const
+{
+    return val;
+}
+
+template<>
+int TElement<char>::evaluate(const Valuation& v) const
+{
+    auto iter = v.find(val);
+
+    if(iter != v.end())
+    {
+        return iter->second;
+    }
+
+    throw "Could not find variable";
+}
+
+template<>
+Element* TElement<int>::specialize(const Valuation&) const
+{
+    return clone();
+}
+
+template<>
+Element* TElement<char>::specialize(const Valuation& v) const
+{
+    auto iter = v.find(val);
+
+    if(iter != v.end())
+    {
+        return new TElement<int>(iter->second);
+    }
+
+    return clone();
+}
+
+template<>
+std::uint64_t TElement<int>::hash() const
+{
+    return hashCombine('i', static_cast<std::uint32_t>(val));
+}
+
+template<>
+std::uint64_t TElement<char>::hash() const
+{
+    return hashCombine('c', static_cast<unsigned char>(val));
+}
+
+template<>
+TElement<int>& TElement<int>::operator+=(const TElement<int>& i)
+{
+    val = val + i.val;
+    return *this;
+}
+
+template<>
+TElement<int>& TElement<int>::operator-=(const TElement<int>& i)
+{
+    val = val - i.val;
+    return *this;
+}
+
+template<>
+TElement<int>& TElement<int>::operator*=(const TElement<int>& i)
+{
+    val = val * i.val;
+    return *this;
+}
+
+std::ostream& operator<<(std::ostream& os, const Element& i)
+{
+    os << i.toString();
+    return os;
+}
+
+bool operator==(const Element& i, const Element& j)
+{
+    if(&i == &j)
+        return true;
+    if(i.hash() != j.hash())
+        return false;
+    return i.equals(j);
+}
+
+IntElement operator+(const IntElement& i, const IntElement& j)
+{
+    IntElement element{i};
+    element+=j;
+    return element;
+}
+
+IntElement operator-(const IntElement& i, const IntElement& j)
+{
+    IntElement element{i};
+    element-=j;
+    return element;
+}
+
+IntElement operator*(const IntElement& i, const IntElement& j)
+{
+    IntElement element{i};
+    element*=j;
+    return element;
+}
@@ -1,538 +1,503 @@
-/**
-    \file elementarymatrix.cpp
-    \brief Code for ElementarySquareMatrix class functions
-*/
-
-#include "elementarymatrix.h"
-
-template<>
-ElementarySquareMatrix<IntElement>& ElementarySquareMatrix<IntElement>::operator+=(const ElementarySquareMatrix<IntElement>& m)
-{
-    try
-    {
-        if(n != m.n)
-        {
-            throw m;
-        }
-        else
-        {
-            for(unsigned int i = 0; i < n; i++)
-            {
-                unsigned int j = 0;
-                for(auto iter = m.elements[i].begin(); iter != m.elements[i].end(); iter++, j++)
-                {
-                    *elements[i][j] += *(*iter);
-                }
-            }
-        }
-    }
-    catch(ElementarySquareMatrix<IntElement>& m)
-    {
-        throw std::invalid_argument("Matrices are not the same size");
-    }
-
-    return *this;
-}
-
-template<>
-ElementarySquareMatrix<IntElement>& ElementarySquareMatrix<IntElement>::operator-=(const ElementarySquareMatrix<IntElement>& m)
-{
-    try
-    {
-        if(n != m.n)
-        {
-            throw m;
-        }
-        else
-        {
-            for(unsigned int i = 0; i < n; i++)
-            {
-                unsigned int j = 0;
-                for(auto iter = m.elements[i].begin(); iter != m.elements[i].end(); iter++, j++)
-                {
-                    *elements[i][j] -= *(*iter);
-                }
-            }
-        }
-    }
-    catch(ElementarySquareMatrix<IntElement>& m)
-    {
-        throw std::invalid_argument("Matrices are not the same size");
-    }
-
-    return *this;
-}
-
-template<>
-ElementarySquareMatrix<IntElement>& ElementarySquareMatrix<IntElement>::operator*=(const ElementarySquareMatrix<IntElement>& m)
-{
-    try
-    {
-        if(n != m.n)
-        {
-            throw m;
-        }
-        else
-        {
-            std::vector<std::vector<std::shared_ptr<IntElement>>> temp;
-            std::vector<std::shared_ptr<IntElement>> vec;
-            ConcreteSquareMatrix sq = m.transpose();
-            IntElement elem(0);
-            unsigned int i = 0;
-            unsigned int j = 0;
-
-            while(i < n)
-            {
-                temp.push_back(vec);
-                i++;
-            }
-
-            for(i = 0; i < n; i++)
-            {
-                for(j = 0; j < n; j++)
-                {
-                    auto iter1 = elements[i].begin();
-                    auto iter2 = sq.elements[j].begin();
-                    for( ; iter1 != elements[i].end(); iter1++, iter2++)
-                    {
-                        elem += *(*iter1) * *(*iter2);
-                    }
-                    temp[i].push_back(std::shared_ptr<IntElement>(static_cast<IntElement*>(elem.clone())));
-                    elem.setVal(0);
-                }
-            }
-            elements = temp;
-        }
-    }
-    catch(ElementarySquareMatrix<IntElement>& m)
-    {
-        throw std::invalid_argument("Matrices are not the same size");
-    }
-    return *this;
-}
-
-template<>
-ElementarySquareMatrix<Element> ElementarySquareMatrix<Element>::operator+(const ElementarySquareMatrix<Element>& m)
-{
-    SymbolicSquareMatrix sq;
-    std::vector<std::vector<std::shared_ptr<Element>>> elems;
-    std::vector<std::shared_ptr<Element>> row;
-    unsigned int i = 0;
-    unsigned int j = 0;
-
-    if(n != m.n)
-    {
-        throw std::invalid_argument("Matrices are not the same size");
-    }
-    else
-    {
-        while(i < n)
-        {
-            elems.push_back(row);
-            i++;
-        }
-        for(i = 0; i < n; i++)
-        {
-            j = 0;
-            for(auto iter = m.elements[i].begin(); iter != m.elements[i].end(); iter++, j++)
-            {
-                CompositeElement com_elem(*elements[i][j], *(*iter), std::plus<int>(), '+');
-                elems[i].push_back(std::shared_ptr<Element>(static_cast<Element*>(com_elem.clone())));
-            }
-        }
-        sq.setVector(elems);
-        return sq;
-    }
-}
-
-template<>
-ElementarySquareMatrix<Element> ElementarySquareMatrix<Element>::operator-(const ElementarySquareMatrix<Element>& m)
-{
-    SymbolicSquareMatrix sq;
-    std::vector<std::vector<std::shared_ptr<Element>>> elems;
-    std::vector<std::shared_ptr<Element>> row;
-    unsigned int i = 0;
-    unsigned int j = 0;
-
-    if(n != m.n)
-    {
-        throw std::invalid_argument("Matrices are not the same size");
-    }
-    else
-    {
-        while(i < n)
-        {
-            elems.push_back(row);
-            i++;
-        }
-        for(i = 0; i < n; i++)
-        {
-            j = 0;
-            for(auto iter = m.elements[i].begin(); iter != m.elements[i].end(); iter++, j++)
-            {
-                CompositeElement com_elem(*elements[i][j], *(*iter), std::minus<int>(), '-');
-                elems[i].push_back(std::shared_ptr<Element>(static_cast<Element*>(com_elem.clone())));
-            }
-        }
-        sq.setVector(elems);
-        return sq;
-    }
-}
-
-template<>
-ElementarySquareMatrix<Element> ElementarySquareMatrix<Element>::operator*(const ElementarySquareMatrix<Element>& m)
-{
-    SymbolicSquareMatrix sq;
-    SymbolicSquareMatrix test = m.transpose();
-    std::vector<std::vector<std::shared_ptr<Element>>> elems;
-    std::vector<std::shared_ptr<Element>> row;
-    std::vector<std::shared_ptr<Element>> temp;
-    unsigned int i = 0;
-    unsigned int j = 0;
-
-    if(n != m.n)
-    {
-        throw std::invalid_argument("Matrices are not the same size");
-    }
-    else
-    {
-        while(i < n)
-        {
-            elems.push_back(row);
-            i++;
-        }
-        for(i = 0; i < n; i++)
-        {
-            for(j = 0; j < n; j++)
-            {
-                auto iter1 = elements[i].begin();
-                auto iter2 = test.elements[j].begin();
-                for( ; iter1 != elements[i].end(); iter1++, iter2++)
-                {
-                    CompositeElement com_elem(*(*iter1), *(*iter2), std::multiplies<int>(), '*');
-                    elems[i].push_back(std::shared_ptr<Element>(static_cast<Element*>(com_elem.clone())));
-                }
-            }
-        }
-    }
-    sq.setVector(elems);
-    return sq;
-}
-
-template<>
-bool ElementarySquareMatrix<IntElement>::isSquareMatrix(const std::string& s)
-{
-    std::vector<std::shared_ptr<IntElement>> row;
-    std::istringstream strm(s);
-    std::string line;
-    std::string nums;
-    unsigned int i = 0;
-    unsigned int j = 0;
-    n = 0;
-    int number;
-    char c;
-
-    strm >> c;
-    if(c != '[')
-        throw false;
-    strm >> c;
-    if(c != '[')
-        throw false;
-
-    while(!strm.eof())
-    {
-        elements.push_back(row);
-        j = 0;
-
-        std::getline(strm, line, ']');
-        if((line.find(',') == std::string::npos) && (line != ""))
-        {
-            try
-            {
-                number = std::stoi(line);
-                std::shared_ptr<IntElement> elem_ptr(new IntElement(number));
-                elements[i].push_back(elem_ptr);
-            }
-            catch(const std::invalid_argument& ia)
-            {
-                throw false;
-            }
-            j++;
-        }
-        else if (line.find(',') != std::string::npos)
-        {
-            std::istringstream line_temp(line);
-            while(!line_temp.eof())
-            {
-                std::getline(line_temp, nums, ',');
-                try
-                {
-                    number = std::stoi(nums);
-                    std::shared_ptr<IntElement> elem_ptr(new IntElement(number));
-                    elements[i].push_back(elem_ptr);
-                }
-                catch(const std::invalid_argument& ia)
-                {
-                    throw false;
-                }
-                j++;
-            }
-        }
-
-        if (n == 0)
-        {
-            n = j;
-            strm >> c;
-            i++;
-        }
-        else if(n != j && line != "")
-        {
-            throw false;
-        }
-        else
-        {
-            strm >> c;
-            if(n != 1)
-            {
-                i++;
-            }
-
-            if(strm.str().back() == ']')
-            {
-                if(i == n)
-                {
-                    strm >> c;
-                    if(c != ']')
-                    {
-                        throw false;
-                    }
-                    else if(strm.eof())
-                    {
-                        return true;
-                    }
-                }
-            }
-        }
-    }
-    throw false;
-}
-
-template<>
-bool ElementarySquareMatrix<Element>::isSquareMatrix(const std::string& s)
-{
-    std::vector<std::shared_ptr<Element>> row;
-    std::istringstream strm(s);
-    std::string line;
-    std::string nums;
-    unsigned int i = 0;
-    unsigned int j = 0;
-    n = 0;
-    int number;
-    char character;
-    char c;
-
-    strm >> c;
-    if(c != '[')
-        throw false;
-    strm >> c;
-    if(c != '[')
-        throw false;
-
-    while(!strm.eof())
-    {
-        elements.push_back(row);
-        j = 0;
-
-        std::getline(strm, line, ']');
-        if((line.find(',') == std::string::npos) && (line != ""))
-        {
-            try
-            {
-                number = std::stoi(line);
-                std::shared_ptr<Element> elem_ptr(new IntElement(number));
-                elements[i].push_back(elem_ptr);
-            }
-            catch(const std::invalid_argument& ia)
-            {
-                try
-                {
-                    if(line.size() > 1)
-                    {
-                        throw false;
-                    }
-
-                    character = line[0];
-                    if(std::isalpha(character) == false)
-                    {
-                        throw false;
-                    }
-
-                    std::shared_ptr<Element> var_ptr(new VariableElement(character));
-                    elements[i].push_back(var_ptr);
-                }
-                catch(bool incorrect)
-                {
-                    throw false;
-                }
-            }
-            j++;
-        }
-        else if (line.find(',') != std::string::npos)
-        {
-            std::istringstream line_temp(line);
-            while(!line_temp.eof())
-            {
-                std::getline(line_temp, nums, ',');
-                try
-                {
-                    number = std::stoi(nums);
-                    std::shared_ptr<Element> elem_ptr(new IntElement(number));
-                    elements[i].push_back(elem_ptr);
-                }
-                catch(const std::invalid_argument& ia)
-                {
-                    try
-                    {
-                        if(nums.size() > 1)
-                        {
-                            throw false;
-                        }
-
-                        character = nums[0];
-                        if(std::isalpha(character) == false)
-                        {
-                            throw false;
-                        }
-
-                        std::shared_ptr<Element> var_ptr(new VariableElement(character));
-                        elements[i].push_back(var_ptr);
-                    }
-                    catch(bool incorrect)
-                    {
-                        throw false;
-                    }
-                }
-                j++;
-            }
-        }
-
-        if (n == 0)
-        {
-            n = j;
-            strm >> c;
-            i++;
-        }
-        else if(n != j && line != "")
-        {
-            throw false;
-        }
-        else
-        {
-            strm >> c;
-            if(n != 1)
-            {
-                i++;
-            }
-
-            if(strm.str().back() == ']')
-            {
-                if(i == n)
-                {
-                    strm >> c;
-                    if(c != ']')
-                    {
-                        throw false;
-                    }
-                    else if(strm.eof())
-                    {
-                        return true;
-                    }
-                }
-            }
-        }
-    }
-    throw false;
-}
-
-template<>
-ElementarySquareMatrix<IntElement> ElementarySquareMatrix<IntElement>::evaluate(const Valuation& v) const
-{
-    return *this;
-}
-
-template<>
-ElementarySquareMatrix<IntElement> ElementarySquareMatrix<Element>::evaluate(const Valuation& v) const
-{
-    ElementarySquareMatrix<IntElement> sq;
-    unsigned int i = 0;
-    int number;
-    std::vector<std::vector<std::shared_ptr<IntElement>>> elems;
-    std::vector<std::shared_ptr<IntElement>> row;
-
-    while(i < n)
-    {
-        elems.push_back(row);
-        i++;
-    }
-    i=0;
-
-    for(auto iter1: this->elements)
-    {
-        for(auto iter2: iter1)
-        {
-            try
-            {
-                number = iter2->evaluate(v);
-                std::shared_ptr<IntElement> elem_ptr(new IntElement(number));
-                elems[i].push_back(elem_ptr);
-            }
-            catch(...)
-            {
-                throw std::invalid_argument("Could not do evaluation");
-            }
-        }
-        i++;
-    }
-
-    sq.setVector(elems);
-    return sq;
-}
-
-template<>
-ElementarySquareMatrix<IntElement> ElementarySquareMatrix<IntElement>::operator+(const ElementarySquareMatrix<IntElement>& m)
-{
-    ConcreteSquareMatrix sq{*this};
-    ConcreteSquareMatrix matrix{m};
-    sq+=matrix;
-    return sq;
-}
-
-template<>
-ElementarySquareMatrix<IntElement> ElementarySquareMatrix<IntElement>::operator-(const ElementarySquareMatrix<IntElement>& m)
-{
-    ConcreteSquareMatrix sq{*this};
-    ConcreteSquareMatrix matrix{m};
-    sq-=matrix;
-    return sq;
-}
-
-template<>
-ElementarySquareMatrix<IntElement> ElementarySquareMatrix<IntElement>::operator*(const ElementarySquareMatrix<IntElement>& m)
-{
-    ConcreteSquareMatrix sq{*this};
-    ConcreteSquareMatrix matrix{m};
-    sq*=matrix;
-    return sq;
-}
-
-std::ostream& operator<<(std::ostream& os, const ElementarySquareMatrix<IntElement>& m)
-{
-    os << m.toString();
-    return os;
-}
-
-std::ostream& operator<<(std::ostream& os, const ElementarySquareMatrix<Element>& m)
-{
-    os << m.toString();
-    return os;
-}
+/**
+    \file elementarymatrix.cpp
+    \brief Code for ElementarySquareMatrix class functions
+*/
+
+#include "elementarymatrix.h"
+#include "expressionpool.h"
+#include "fixedmatrix.h"
+#include "matrixparser.h"
+#include "taskscheduler.h"
+#include <atomic>
+#include <exception>
+
+/// Matrices smaller than this are evaluated in one thread unless number of threads is given
+static const unsigned int parallel_evaluation_threshold = 64;
+
+/// Matrices smaller than this are multiplied in one thread
+static const unsigned int parallel_multiply_threshold = 128;
+
+template<>
+ElementarySquareMatrix<IntElement>& ElementarySquareMatrix<IntElement>::operator+=(const ElementarySquareMatrix<IntElement>& m)
+{
+    try
+    {
+        if(n != m.n)
+        {
+            throw m;
+        }
+        else
+        {
+            detach();
+            hash_valid = false;
+            for(unsigned int i = 0; i < n; i++)
+            {
+                unsigned int j = 0;
+                for(auto iter = (*m.elements)[i].begin(); iter != (*m.elements)[i].end(); iter++, j++)
+                {
+                    *(*elements)[i][j] += *(*iter);
+                }
+            }
+        }
+    }
+    catch(ElementarySquareMatrix<IntElement>& m)
+    {
+        throw std::invalid_argument("Matrices are not the same size");
+    }
+
+    return *this;
+}
+
+template<>
+ElementarySquareMatrix<IntElement>& ElementarySquareMatrix<IntElement>::operator-=(const ElementarySquareMatrix<IntElement>& m)
+{
+    try
+    {
+        if(n != m.n)
+        {
+            throw m;
+        }
+        else
+        {
+            detach();
+            hash_valid = false;
+            for(unsigned int i = 0; i < n; i++)
+            {
+                unsigned int j = 0;
+                for(auto iter = (*m.elements)[i].begin(); iter != (*m.elements)[i].end(); iter++, j++)
+                {
+                    *(*elements)[i][j] -= *(*iter);
+                }
+            }
+        }
+    }
+    catch(ElementarySquareMatrix<IntElement>& m)
+    {
+        throw std::invalid_argument("Matrices are not the same size");
+    }
+
+    return *this;
+}
+
+template<>
+ElementarySquareMatrix<IntElement>& ElementarySquareMatrix<IntElement>::operator*=(const ElementarySquareMatrix<IntElement>& m)
+{
+    *this = *this * m;
+    return *this;
+}
+
+SymbolicSquareMatrix operator+(const SymbolicSquareMatrix& m1, const SymbolicSquareMatrix& m2)
+{
+    SymbolicSquareMatrix sq;
+    std::vector<std::vector<std::shared_ptr<Element>>> elems;
+    std::vector<std::shared_ptr<Element>> row;
+    unsigned int n = m1.getSize();
+    unsigned int i = 0;
+    unsigned int j = 0;
+
+    if(n != m2.getSize())
+    {
+        throw std::invalid_argument("Matrices are not the same size");
+    }
+    else
+    {
+        while(i < n)
+        {
+            elems.push_back(row);
+            i++;
+        }
+        for(i = 0; i < n; i++)
+        {
+            for(j = 0; j < n; j++)
+            {
+                CompositeElement com_elem(m1.getElement(i, j), m2.getElement(i, j), '+');
+                elems[i].push_back(std::shared_ptr<Element>(static_cast<Element*>(com_elem.clone())));
+            }
+        }
+        sq.setVector(std::move(elems));
+        return sq;
+    }
+}
+
+SymbolicSquareMatrix operator-(const SymbolicSquareMatrix& m1, const SymbolicSquareMatrix& m2)
+{
+    SymbolicSquareMatrix sq;
+    std::vector<std::vector<std::shared_ptr<Element>>> elems;
+    std::vector<std::shared_ptr<Element>> row;
+    unsigned int n = m1.getSize();
+    unsigned int i = 0;
+    unsigned int j = 0;
+
+    if(n != m2.getSize())
+    {
+        throw std::invalid_argument("Matrices are not the same size");
+    }
+    else
+    {
+        while(i < n)
+        {
+            elems.push_back(row);
+            i++;
+        }
+        for(i = 0; i < n; i++)
+        {
+            for(j = 0; j < n; j++)
+            {
+                CompositeElement com_elem(m1.getElement(i, j), m2.getElement(i, j), '-');
+                elems[i].push_back(std::shared_ptr<Element>(static_cast<Element*>(com_elem.clone())));
+            }
+        }
+        sq.setVector(std::move(elems));
+        return sq;
+    }
+}
+
+SymbolicSquareMatrix operator*(const SymbolicSquareMatrix& m1, const SymbolicSquareMatrix& m2)
+{
+    return multiply(m1, m2, nullptr);
+}
+
+SymbolicSquareMatrix multiply(const SymbolicSquareMatrix& m1, const SymbolicSquareMatrix& m2, Progress* progress)
+{
+    SymbolicSquareMatrix sq;
+    SymbolicSquareMatrix test = m2.transpose();
+    std::vector<std::vector<std::shared_ptr<Element>>> elems;
+    std::vector<std::shared_ptr<Element>> row;
+    unsigned int n = m1.getSize();
+    unsigned int i = 0;
+    unsigned int j = 0;
+
+    if(n != m2.getSize())
+    {
+        throw std::invalid_argument("Matrices are not the same size");
+    }
+    else
+    {
+        while(i < n)
+        {
+            elems.push_back(row);
+            i++;
+        }
+        if(progress)
+            progress->setTotal(n);
+        for(i = 0; i < n; i++)
+        {
+            if(progress)
+                progress->check();
+            for(j = 0; j < n; j++)
+            {
+                for(unsigned int k = 0; k < n; k++)
+                {
+                    CompositeElement com_elem(m1.getElement(i, k), test.getElement(j, k), '*');
+                    elems[i].push_back(std::shared_ptr<Element>(static_cast<Element*>(com_elem.clone())));
+                }
+            }
+            if(progress)
+                progress->advance();
+        }
+    }
+    sq.setVector(std::move(elems));
+    return sq;
+}
+
+ConcreteSquareMatrix operator*(const ConcreteSquareMatrix& m1, const ConcreteSquareMatrix& m2)
+{
+    return multiply(m1, m2, nullptr);
+}
+
+ConcreteSquareMatrix multiply(const ConcreteSquareMatrix& m1, const ConcreteSquareMatrix& m2, Progress* progress)
+{
+    unsigned int n = m1.getSize();
+
+    if(n != m2.getSize())
+    {
+        throw std::invalid_argument("Matrices are not the same size");
+    }
+
+    // unsigned values wrap around like the sums below
+    ConcreteSquareMatrix sq;
+    if(dispatchFixed(n, [&](auto size)
+    {
+        constexpr unsigned int N = decltype(size)::value;
+        if(progress)
+        {
+            progress->setTotal(N);
+            progress->check();
+        }
+        sq = toConcrete(toFixed<N, unsigned int>(m1) * toFixed<N, unsigned int>(m2));
+        if(progress)
+            progress->advance(N);
+    }))
+    {
+        return sq;
+    }
+
+    std::vector<int> values(n * n);
+    std::vector<int> trans(n * n);
+    if(progress)
+        progress->setTotal(n);
+
+    for(unsigned int i = 0; i < n; i++)
+    {
+        for(unsigned int j = 0; j < n; j++)
+        {
+            trans[j * n + i] = m2.valueAt(i, j);
+        }
+    }
+
+    auto rows = [&](std::size_t first, std::size_t last)
+    {
+        for(std::size_t i = first; i < last; i++)
+        {
+            if(progress)
+                progress->check();
+            for(unsigned int j = 0; j < n; j++)
+            {
+                unsigned int sum = 0;
+                for(unsigned int k = 0; k < n; k++)
+                {
+                    sum += static_cast<unsigned int>(m1.valueAt(i, k)) * static_cast<unsigned int>(trans[j * n + k]);
+                }
+                values[i * n + j] = static_cast<int>(sum);
+            }
+            if(progress)
+                progress->advance();
+        }
+    };
+
+    // each task gets about 2^18 multiplications
+    if(n >= parallel_multiply_threshold)
+        parallelFor(0, n, std::max<std::size_t>(1, (std::size_t(1) << 18) / (static_cast<std::size_t>(n) * n)), rows);
+    else
+        rows(0, n);
+
+    return ConcreteSquareMatrix::fromValues(n, values.data());
+}
+
+template<>
+bool ElementarySquareMatrix<IntElement>::isSquareMatrix(const std::string& s)
+{
+    std::istringstream strm(s);
+
+    try
+    {
+        *this = MatrixStreamParser<IntElement>(strm).parse();
+    }
+    catch(const std::invalid_argument& ia)
+    {
+        throw false;
+    }
+
+    if((strm >> std::ws).peek() != std::char_traits<char>::eof())
+    {
+        throw false;
+    }
+    return true;
+}
+
+template<>
+bool ElementarySquareMatrix<Element>::isSquareMatrix(const std::string& s)
+{
+    std::istringstream strm(s);
+
+    try
+    {
+        *this = MatrixStreamParser<Element>(strm).parse();
+    }
+    catch(const std::invalid_argument& ia)
+    {
+        throw false;
+    }
+
+    if((strm >> std::ws).peek() != std::char_traits<char>::eof())
+    {
+        throw false;
+    }
+    return true;
+}
+
+template<>
+ElementarySquareMatrix<IntElement> ElementarySquareMatrix<IntElement>::evaluate(const Valuation& v) const
+{
+    return *this;
+}
+
+template<>
+ElementarySquareMatrix<IntElement> ElementarySquareMatrix<Element>::evaluate(const Valuation& v) const
+{
+    return evaluateParallel(*this, v);
+}
+
+ConcreteSquareMatrix evaluateParallel(const SymbolicSquareMatrix& m, const Valuation& v, unsigned int threads, Progress* progress)
+{
+    const unsigned int n = m.getSize();
+    TaskScheduler& scheduler = TaskScheduler::global();
+    if(threads == 0)
+    {
+        threads = (n < parallel_evaluation_threshold) ? 1 : scheduler.getThreadCount();
+    }
+    threads = std::max(1u, std::min(threads, n));
+
+    // several blocks per thread, idle threads steal blocks of threads that got expensive rows
+    const unsigned int rows_per_block = std::max(1u, n / (threads * 4));
+    const std::size_t blocks = (n + rows_per_block - 1) / rows_per_block;
+    std::vector<std::vector<std::shared_ptr<IntElement>>> elems(n);
+    std::vector<std::exception_ptr> errors(blocks);
+    std::atomic<std::size_t> first_error(blocks);
+    if(progress)
+        progress->setTotal(n);
+
+    auto evaluateBlocks = [&](std::size_t first, std::size_t last)
+    {
+        ExpressionPool pool;
+        std::vector<std::uint32_t> roots;
+        std::vector<int> values;
+        for(std::size_t b = first; b < last; b++)
+        {
+            // blocks after a failed one cannot change which error is reported
+            if(b > first_error)
+                return;
+            if(progress)
+                progress->check();
+
+            unsigned int row_begin = static_cast<unsigned int>(b * rows_per_block);
+            unsigned int row_end = std::min(n, row_begin + rows_per_block);
+            pool = ExpressionPool();
+            roots.clear();
+            for(unsigned int i = row_begin; i < row_end; i++)
+            {
+                for(unsigned int j = 0; j < n; j++)
+                {
+                    roots.push_back(pool.add(m.getElement(i, j)));
+                }
+            }
+
+            try
+            {
+                pool.evaluate(v, values);
+            }
+            catch(...)
+            {
+                errors[b] = std::current_exception();
+                std::size_t expected = first_error;
+                while(b < expected && !first_error.compare_exchange_weak(expected, b))
+                {
+                }
+                return;
+            }
+
+            const std::uint32_t* root = roots.data();
+            for(unsigned int i = row_begin; i < row_end; i++)
+            {
+                elems[i].reserve(n);
+                for(unsigned int j = 0; j < n; j++)
+                {
+                    elems[i].push_back(std::make_shared<IntElement>(values[*root++]));
+                }
+            }
+            if(progress)
+                progress->advance(row_end - row_begin);
+        }
+    };
+
+    if(threads == 1)
+        evaluateBlocks(0, blocks);
+    else
+        parallelFor(0, blocks, 1, evaluateBlocks, scheduler);
+
+    // pool of each block reports its first unbound variable, so the first failed block gives the first one in row-major order
+    if(first_error < blocks)
+    {
+        std::rethrow_exception(errors[first_error]);
+    }
+
+    ConcreteSquareMatrix sq;
+    sq.setVector(std::move(elems));
+    return sq;
+}
+
+template<>
+ElementarySquareMatrix<Element> ElementarySquareMatrix<IntElement>::specialize(const Valuation&) const
+{
+    ElementarySquareMatrix<Element> sq;
+    std::vector<std::vector<std::shared_ptr<Element>>> elems(n);
+
+    for(unsigned int i = 0; i < n; i++)
+    {
+        elems[i].reserve(n);
+        for(auto iter = (*elements)[i].begin(); iter != (*elements)[i].end(); iter++)
+        {
+            elems[i].push_back(std::shared_ptr<Element>((*iter)->clone()));
+        }
+    }
+
+    sq.setVector(std::move(elems));
+    return sq;
+}
+
+template<>
+ElementarySquareMatrix<Element> ElementarySquareMatrix<Element>::specialize(const Valuation& v) const
+{
+    ElementarySquareMatrix<Element> sq;
+    std::vector<std::vector<std::shared_ptr<Element>>> elems(n);
+
+    for(unsigned int i = 0; i < n; i++)
+    {
+        elems[i].reserve(n);
+        for(auto iter = (*elements)[i].begin(); iter != (*elements)[i].end(); iter++)
+        {
+            elems[i].push_back(std::shared_ptr<Element>((*iter)->specialize(v)));
+        }
+    }
+
+    sq.setVector(std::move(elems));
+    return sq;
+}
+
+ConcreteSquareMatrix operator+(ConcreteSquareMatrix&& m1, const ConcreteSquareMatrix& m2)
+{
+    m1 += m2;
+    return std::move(m1);
+}
+
+ConcreteSquareMatrix operator+(const ConcreteSquareMatrix& m1, ConcreteSquareMatrix&& m2)
+{
+    m2 += m1;
+    return std::move(m2);
+}
+
+ConcreteSquareMatrix operator+(ConcreteSquareMatrix&& m1, ConcreteSquareMatrix&& m2)
+{
+    m1 += m2;
+    return std::move(m1);
+}
+
+ConcreteSquareMatrix operator-(ConcreteSquareMatrix&& m1, const ConcreteSquareMatrix& m2)
+{
+    m1 -= m2;
+    return std::move(m1);
+}
+
+ConcreteSquareMatrix operator-(const ConcreteSquareMatrix& m1, ConcreteSquareMatrix&& m2)
+{
+    m2 = m1 - m2;
+    return std::move(m2);
+}
+
+ConcreteSquareMatrix operator-(ConcreteSquareMatrix&& m1, ConcreteSquareMatrix&& m2)
+{
+    m1 -= m2;
+    return std::move(m1);
+}
+
+std::ostream& operator<<(std::ostream& os, const ElementarySquareMatrix<IntElement>& m)
+{
+    m.write(os);
+    return os;
+}
+
+std::ostream& operator<<(std::ostream& os, const ElementarySquareMatrix<Element>& m)
+{
+    m.write(os);
+    return os;
+}
@@ -1,307 +1,729 @@
-/**
-    \file elementarymatrix.h
-    \brief Header for ElementarySquareMatrix class
-*/
-
-#ifndef ELEMENTARYMATRIX_H_INCLUDED
-#define ELEMENTARYMATRIX_H_INCLUDED
-#include "compositeelement.h"
-#include "element.h"
-#include "squarematrix.h"
-#include <vector>
-#include <sstream>
-
-/**
-    \class ElementarySquareMatrix
-    \brief ElementarySquareMatrix template class (becomes ConcreteSquareMatrix with IntElement objects and SymbolicSquareMatrix with Element objects)
-    \tparam T Type of Element-object
-*/
-template <typename T>
-class ElementarySquareMatrix : public SquareMatrix
-{
-    private:
-        unsigned int n;
-        std::vector<std::vector<std::shared_ptr<T>>> elements;
-    public:
-
-        /**
-            \brief Default constructor
-        */
-        ElementarySquareMatrix(): n(0){};
-
-        /**
-            \brief Parametric constructor
-            \param str_m string to construct matrix from
-            \throw std::invalid_argument if string is invalid
-        */
-        ElementarySquareMatrix(const std::string& str_m)
-        {
-                try
-            {
-                isSquareMatrix(str_m);
-            }
-            catch (bool error)
-            {
-                throw std::invalid_argument("String must be in format [[a11,...,a1n]...[an1,...ann]]");
-            }
-        }
-
-        /**
-            \brief Copy constructor
-            \param m matrix to copy
-        */
-        ElementarySquareMatrix(const ElementarySquareMatrix<T>& m)
-        {
-            std::vector<std::shared_ptr<T>> row;
-            n = m.n;
-
-            for(unsigned int i = 0; i < n; i++)
-            {
-                elements.push_back(row);
-                for(auto iter = m.elements[i].begin(); iter != m.elements[i].end(); iter++)
-                {
-                    elements[i].push_back(std::shared_ptr<T>(static_cast<T*>((*(*iter)).clone())));
-                }
-            }
-        }
-
-        /**
-            \brief Move constructor
-            \param m matrix to move
-        */
-        ElementarySquareMatrix(ElementarySquareMatrix<T>&& m)
-        {
-            n = m.n;
-            elements = std::move(m.elements);
-            m.n = 0;
-        }
-
-        /**
-            \brief Assignment operator
-            \param m matrix to assign
-            \return Assigned matrix
-        */
-        ElementarySquareMatrix<T>& operator=(const ElementarySquareMatrix<T>& m)
-        {
-            if(*this == m)
-            {
-                return *this;
-            }
-
-            std::vector<std::shared_ptr<T>> row;
-            elements.clear();
-            n = m.n;
-
-            for(unsigned int i = 0; i < n; i++)
-            {
-                elements.push_back(row);
-                for(auto iter = m.elements[i].begin(); iter != m.elements[i].end(); iter++)
-                {
-                    elements[i].push_back(std::shared_ptr<T>(static_cast<T*>((*(*iter)).clone())));
-                }
-            }
-            return *this;
-        }
-
-        /**
-            \brief Move assignment operator
-            \param m matrix to move
-            \return Moved matrix
-        */
-        ElementarySquareMatrix<T>& operator=(ElementarySquareMatrix<T>&& m)
-        {
-            if(*this == m)
-            {
-                return *this;
-            }
-
-            elements = std::move(m.elements);
-            n = m.n;
-            m.n = 0;
-            return *this;
-        }
-
-        /**
-            \brief Function to get transpose of matrix
-            \return Transposed matrix
-        */
-        ElementarySquareMatrix<T> transpose() const
-        {
-            std::vector<std::vector<std::shared_ptr<T>>> trans_elements;
-            std::vector<std::shared_ptr<T>> row;
-            ElementarySquareMatrix<T> sq;
-            unsigned int i = 0;
-
-            while (i < n)
-            {
-                trans_elements.push_back(row);
-                i++;
-            }
-
-            for(auto iter1: this->elements)
-            {
-                i = 0;
-                for(auto iter2: iter1)
-                {
-                    trans_elements[i].push_back(std::shared_ptr<T>(static_cast<T*>((iter2->clone()))));
-                    i++;
-                }
-            }
-
-            sq.setVector(trans_elements);
-            return sq;
-        }
-
-        /**
-            \brief Function to set new vector to matrix
-            \param elems new vector to set
-        */
-        void setVector(std::vector<std::vector<std::shared_ptr<T>>> elems)
-        {
-            elements = elems;
-            n = elements.size();
-        }
-
-        /**
-            \brief Operator to compare two matrices
-            \param m matrix to compare with
-            \return true if matrices are same
-            \return false if matrices are not same
-        */
-        bool operator==(const ElementarySquareMatrix<T>& m) const
-        {
-            std::string matrix1 = toString();
-            std::string matrix2 = m.toString();
-            if(matrix1 == matrix2)
-                return true;
-            else
-                return false;
-        }
-
-        /**
-            \brief Function to print square matrix
-            \param os stream to print in
-        */
-        void print(std::ostream& os)
-        {
-            os << toString();
-        }
-
-        /**
-            \brief Makes a string representation of ElementarySquareMatrix
-            \return The string representation
-        */
-        std::string toString() const override
-        {
-            std::stringstream strm;
-
-            strm << "[";
-            for(auto iter1 = elements.begin(); iter1 != elements.end(); iter1++)
-            {
-                strm << "[";
-                for(auto iter2 = iter1->begin(); iter2 != iter1->end(); iter2++)
-                {
-                    strm << (*iter2)->toString();
-                    if(iter2+1 != iter1->end())
-                    {
-                        strm << ",";
-                    }
-                }
-                strm << "]";
-            }
-            strm << "]";
-            return strm.str();
-        }
-
-        /**
-            \brief Destructor
-        */
-        virtual ~ElementarySquareMatrix() = default;
-
-        /**
-            \brief Operator for ConcreteSquareMatrix addition
-            \param m ConcreteSquareMatrix to add
-            \throw std::invalid_argument if matrices are not the same size
-            \return Result of addition
-        */
-        ElementarySquareMatrix<T>& operator+=(const ElementarySquareMatrix<T>& m);
-
-        /**
-            \brief Operator for ConcreteSquareMatrix subtraction
-            \param m ConcreteSquareMatrix to subtract
-            \throw std::invalid_argument if matrices are not the same size
-            \return Result of subtraction
-        */
-        ElementarySquareMatrix<T>& operator-=(const ElementarySquareMatrix<T>& m);
-
-        /**
-            \brief Operator for ConcreteSquareMatrix multiplication
-            \param m ConcreteSquareMatrix to multiply with
-            \throw std::invalid_argument if matrices are not the same size
-            \return Result of multiplication
-        */
-        ElementarySquareMatrix<T>& operator*=(const ElementarySquareMatrix<T>& m);
-
-        /**
-            \brief Operator for ElementarySquareMatrix addition
-            \param m ElementarySquareMatrix to add
-            \throw std::invalid_argument if matrices are not the same size
-            \return Result of addition
-        */
-        ElementarySquareMatrix<T> operator+(const ElementarySquareMatrix<T>& m);
-
-        /**
-            \brief Operator for ElementarySquareMatrix subtraction
-            \param m ElementarySquareMatrix to subtract
-            \throw std::invalid_argument if matrices are not the same size
-            \return Result of subtraction
-        */
-        ElementarySquareMatrix<T> operator-(const ElementarySquareMatrix<T>& m);
-
-        /**
-            \brief Operator for ElementarySquareMatrix multiplication
-            \param m ElementarySquareMatrix to multiply with
-            \throw std::invalid_argument if matrices are not the same size
-            \return Result of multiplication
-        */
-        /* Note: Multiplication for SymbolicSquareMatrix does not work properly*/
-        ElementarySquareMatrix<T> operator*(const ElementarySquareMatrix<T>& m);
-
-        /**
-            \brief Function to check if string is a square matrix
-            \param s string to check
-            \throw false if string is not a square matrix
-            \return true if string is a square matrix
-        */
-        bool isSquareMatrix(const std::string& s);
-
-        /**
-            \brief Evaluate variables in SymbolicSquareMatrix
-            \param v map where variable values are stored
-            \throw std::invalid_argument if evaluation cannot be done
-            \return ConcreteSquareMatrix object
-        */
-        ElementarySquareMatrix<IntElement> evaluate(const Valuation& v) const;
-
-};
-
-using ConcreteSquareMatrix = ElementarySquareMatrix<IntElement>;
-using SymbolicSquareMatrix = ElementarySquareMatrix<Element>;
-
-/**
-    \brief Output operator
-    \param os stream to output in
-    \param m reference to ElementarySquareMatrix object
-*/
-std::ostream& operator<<(std::ostream& os, const ElementarySquareMatrix<IntElement>& m);
-
-/**
-    \brief Output operator
-    \param os stream to output in
-    \param m reference to ElementarySquareMatrix object
-*/
-std::ostream& operator<<(std::ostream& os, const ElementarySquareMatrix<Element>& m);
-
-
-
-#endif // ELEMENTARYMATRIX_H_INCLUDED
+/**
+    \file elementarymatrix.h
+    \brief Header for ElementarySquareMatrix class
+*/
+
+#ifndef ELEMENTARYMATRIX_H_INCLUDED
+#define ELEMENTARYMATRIX_H_INCLUDED
+#include "compositeelement.h"
+#include "element.h"
+#include "matrixexpression.h"
+#include "progress.h"
+#include "squarematrix.h"
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <sstream>
+
+/**
+    \class ElementarySquareMatrix
+    \brief ElementarySquareMatrix template class (becomes ConcreteSquareMatrix with IntElement objects and SymbolicSquareMatrix with Element objects)
+    \tparam T Type of Element-object
+*/
+template <typename T>
+class ElementarySquareMatrix : public SquareMatrix
+{
+    private:
+        using Storage = std::vector<std::vector<std::shared_ptr<T>>>;
+
+        unsigned int n;
+        std::shared_ptr<Storage> elements;
+        // results are shared between threads through the cache, so the hash is published atomically
+        mutable std::atomic<std::uint64_t> hash_value{0};
+        mutable std::atomic<bool> hash_valid{false};
+
+        /**
+            \brief Function to get the storage shared by all empty matrices
+            \return Pointer to empty storage
+        */
+        static const std::shared_ptr<Storage>& emptyStorage()
+        {
+            static const std::shared_ptr<Storage> empty = std::make_shared<Storage>();
+            return empty;
+        }
+
+        /**
+            \brief Make a private copy of the elements if storage is shared with other matrices, called before elements are modified
+        */
+        void detach()
+        {
+            if(elements.use_count() <= 1)
+            {
+                return;
+            }
+
+            std::vector<std::shared_ptr<T>> row;
+            std::shared_ptr<Storage> copy = std::make_shared<Storage>();
+            copy->reserve(n);
+            for(unsigned int i = 0; i < n; i++)
+            {
+                copy->push_back(row);
+                (*copy)[i].reserve(n);
+                for(auto iter = (*elements)[i].begin(); iter != (*elements)[i].end(); iter++)
+                {
+                    (*copy)[i].push_back(std::shared_ptr<T>(static_cast<T*>((*(*iter)).clone())));
+                }
+            }
+            elements = std::move(copy);
+        }
+
+        /**
+            \brief Copy cached hash of another matrix
+            \param m the matrix
+        */
+        void copyHash(const ElementarySquareMatrix<T>& m)
+        {
+            bool valid = m.hash_valid.load(std::memory_order_acquire);
+            hash_value.store(m.hash_value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            hash_valid.store(valid, std::memory_order_release);
+        }
+
+        /**
+            \brief Write result of an element-wise expression into matrix, existing elements are reused if size matches
+            \param e expression to calculate
+        */
+        template <typename E>
+        void assignExpression(const E& e)
+        {
+            unsigned int size = e.getSize();
+
+            if(size != n || elements.use_count() > 1)
+            {
+                Storage elems(size);
+                for(unsigned int i = 0; i < size; i++)
+                {
+                    elems[i].reserve(size);
+                    for(unsigned int j = 0; j < size; j++)
+                    {
+                        elems[i].push_back(std::make_shared<T>(e.valueAt(i, j)));
+                    }
+                }
+                elements = std::make_shared<Storage>(std::move(elems));
+                n = size;
+                hash_valid = false;
+                return;
+            }
+
+            hash_valid = false;
+
+            for(unsigned int i = 0; i < n; i++)
+            {
+                for(unsigned int j = 0; j < n; j++)
+                {
+                    (*elements)[i][j]->setVal(e.valueAt(i, j));
+                }
+            }
+        }
+    public:
+
+        /**
+            \brief Default constructor
+        */
+        ElementarySquareMatrix(): n(0), elements(emptyStorage()){};
+
+        /**
+            \brief Parametric constructor
+            \param str_m string to construct matrix from
+            \throw std::invalid_argument if string is invalid
+        */
+        ElementarySquareMatrix(const std::string& str_m): n(0), elements(emptyStorage())
+        {
+                try
+            {
+                isSquareMatrix(str_m);
+            }
+            catch (bool error)
+            {
+                throw std::invalid_argument("String must be in format [[a11,...,a1n]...[an1,...ann]]");
+            }
+        }
+
+        /**
+            \brief Constructor calculating a lazy ConcreteSquareMatrix expression in a single pass
+            \param e expression to calculate
+        */
+        template <typename L, typename R, typename Op, typename U = T, typename = typename std::enable_if<std::is_same<U, IntElement>::value>::type>
+        ElementarySquareMatrix(const MatrixBinaryExpression<L, R, Op>& e): n(0), elements(emptyStorage())
+        {
+            assignExpression(e);
+        }
+
+        /**
+            \brief Build ConcreteSquareMatrix from row-major values, elements are allocated in one contiguous block instead of one allocation per element
+            \param size number of rows and columns
+            \param values size*size values in row-major order
+            \return ConcreteSquareMatrix object
+        */
+        template <typename U = T, typename = typename std::enable_if<std::is_same<U, IntElement>::value>::type>
+        static ElementarySquareMatrix<T> fromValues(unsigned int size, const int* values)
+        {
+            ElementarySquareMatrix<T> sq;
+            std::shared_ptr<std::vector<T>> block = std::make_shared<std::vector<T>>();
+            Storage elems(size);
+            std::size_t count = static_cast<std::size_t>(size) * size;
+
+            block->reserve(count);
+            for(std::size_t k = 0; k < count; k++)
+            {
+                block->emplace_back(values[k]);
+            }
+
+            for(unsigned int i = 0; i < size; i++)
+            {
+                elems[i].reserve(size);
+                for(unsigned int j = 0; j < size; j++)
+                {
+                    elems[i].emplace_back(block, &(*block)[static_cast<std::size_t>(i) * size + j]);
+                }
+            }
+
+            sq.setVector(std::move(elems));
+            return sq;
+        }
+
+        /**
+            \brief Copy constructor, elements are shared until either matrix is modified
+            \param m matrix to copy
+        */
+        ElementarySquareMatrix(const ElementarySquareMatrix<T>& m): n(m.n), elements(m.elements)
+        {
+            copyHash(m);
+        }
+
+        /**
+            \brief Move constructor
+            \param m matrix to move
+        */
+        ElementarySquareMatrix(ElementarySquareMatrix<T>&& m)
+        {
+            n = m.n;
+            elements = std::move(m.elements);
+            copyHash(m);
+            m.elements = emptyStorage();
+            m.n = 0;
+            m.hash_valid = false;
+        }
+
+        /**
+            \brief Assignment operator, elements are shared until either matrix is modified
+            \param m matrix to assign
+            \return Assigned matrix
+        */
+        ElementarySquareMatrix<T>& operator=(const ElementarySquareMatrix<T>& m)
+        {
+            if(this == &m)
+            {
+                return *this;
+            }
+
+            elements = m.elements;
+            n = m.n;
+            copyHash(m);
+            return *this;
+        }
+
+        /**
+            \brief Move assignment operator
+            \param m matrix to move
+            \return Moved matrix
+        */
+        ElementarySquareMatrix<T>& operator=(ElementarySquareMatrix<T>&& m)
+        {
+            if(this == &m)
+            {
+                return *this;
+            }
+
+            elements = std::move(m.elements);
+            n = m.n;
+            copyHash(m);
+            m.elements = emptyStorage();
+            m.n = 0;
+            m.hash_valid = false;
+            return *this;
+        }
+
+        /**
+            \brief Assignment operator for lazy ConcreteSquareMatrix expression, result is written directly into this matrix
+            \param e expression to calculate
+            \return Assigned matrix
+        */
+        template <typename L, typename R, typename Op, typename U = T, typename = typename std::enable_if<std::is_same<U, IntElement>::value>::type>
+        ElementarySquareMatrix<T>& operator=(const MatrixBinaryExpression<L, R, Op>& e)
+        {
+            assignExpression(e);
+            return *this;
+        }
+
+        /**
+            \brief Function to get size of matrix
+            \return Number of rows and columns
+        */
+        unsigned int getSize() const
+        {
+            return n;
+        }
+
+        /**
+            \brief Function to get element of matrix
+            \param i row index
+            \param j column index
+            \return Reference to element, it cannot be modified so copies sharing the storage stay unchanged
+        */
+        const T& getElement(unsigned int i, unsigned int j) const
+        {
+            return *(*elements)[i][j];
+        }
+
+        /**
+            \brief Function to get integer value of ConcreteSquareMatrix element
+            \param i row index
+            \param j column index
+            \return Value of element
+        */
+        int valueAt(unsigned int i, unsigned int j) const
+        {
+            return (*elements)[i][j]->getVal();
+        }
+
+        /**
+            \brief Copy integer values of ConcreteSquareMatrix to contiguous row-major array
+            \param out array with room for n*n values
+        */
+        void copyValues(int* out) const
+        {
+            for(const auto& row: *elements)
+            {
+                for(const auto& elem: row)
+                {
+                    *out++ = elem->getVal();
+                }
+            }
+        }
+
+        /**
+            \brief Function to get transpose of matrix
+            \return Transposed matrix
+        */
+        ElementarySquareMatrix<T> transpose() const
+        {
+            Storage trans_elements;
+            std::vector<std::shared_ptr<T>> row;
+            ElementarySquareMatrix<T> sq;
+            unsigned int i = 0;
+
+            trans_elements.reserve(n);
+            while (i < n)
+            {
+                trans_elements.push_back(row);
+                trans_elements[i].reserve(n);
+                i++;
+            }
+
+            for(const auto& iter1: *elements)
+            {
+                i = 0;
+                for(const auto& iter2: iter1)
+                {
+                    trans_elements[i].push_back(std::shared_ptr<T>(static_cast<T*>((iter2->clone()))));
+                    i++;
+                }
+            }
+
+            sq.setVector(std::move(trans_elements));
+            return sq;
+        }
+
+        /**
+            \brief Function to set new vector to matrix
+            \param elems new vector to set
+        */
+        void setVector(std::vector<std::vector<std::shared_ptr<T>>> elems)
+        {
+            n = elems.size();
+            elements = std::make_shared<Storage>(std::move(elems));
+            hash_valid = false;
+        }
+
+        /**
+            \brief Operator to compare two matrices
+            \param m matrix to compare with
+            \return true if matrices are same
+            \return false if matrices are not same
+        */
+        bool operator==(const ElementarySquareMatrix<T>& m) const
+        {
+            if(this == &m || (n == m.n && elements == m.elements))
+                return true;
+            if(n != m.n || contentHash() != m.contentHash())
+                return false;
+
+            for(unsigned int i = 0; i < n; i++)
+            {
+                for(unsigned int j = 0; j < n; j++)
+                {
+                    if(!(*(*elements)[i][j] == *(*m.elements)[i][j]))
+                        return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+            \brief Calculate 64-bit hash of matrix content, the hash is cached until matrix is modified
+            \return The hash
+        */
+        std::uint64_t contentHash() const override
+        {
+            if(hash_valid.load(std::memory_order_acquire))
+            {
+                return hash_value.load(std::memory_order_relaxed);
+            }
+
+            std::uint64_t h = hashCombine(0, n);
+            for(const auto& row: *elements)
+            {
+                for(const auto& elem: row)
+                {
+                    h = hashCombine(h, elem->hash());
+                }
+            }
+
+            // threads hashing the same matrix at once store the same value
+            hash_value.store(h, std::memory_order_relaxed);
+            hash_valid.store(true, std::memory_order_release);
+            return h;
+        }
+
+        /**
+            \brief Copy matrix, the copy shares elements until either matrix is modified
+            \return Pointer to the copy
+        */
+        SquareMatrix* clone() const override
+        {
+            return new ElementarySquareMatrix<T>(*this);
+        }
+
+        /**
+            \brief Compare content with another matrix
+            \param m matrix to compare with
+            \return true if m is the same kind of matrix with the same elements
+        */
+        bool sameContent(const SquareMatrix& m) const override
+        {
+            const ElementarySquareMatrix<T>* em = dynamic_cast<const ElementarySquareMatrix<T>*>(&m);
+            return em != nullptr && *this == *em;
+        }
+
+        /**
+            \brief Function to print square matrix
+            \param os stream to print in
+        */
+        void print(std::ostream& os)
+        {
+            write(os, MatrixLayout::Compact);
+        }
+
+        /**
+            \brief Makes a string representation of ElementarySquareMatrix, length is estimated from the first row so string is allocated only once in the common case
+            \return The string representation
+        */
+        std::string toString() const override
+        {
+            std::string str;
+            std::size_t row_length = 2;
+
+            if(n > 0)
+            {
+                for(const auto& elem: (*elements)[0])
+                {
+                    elem->appendTo(str);
+                }
+                row_length += str.size() + n;
+                str.clear();
+            }
+            str.reserve(row_length * n + row_length * n / 8 + 2);
+
+            str += '[';
+            for(const auto& row: *elements)
+            {
+                str += '[';
+                for(unsigned int j = 0; j < row.size(); j++)
+                {
+                    if(j > 0)
+                    {
+                        str += ',';
+                    }
+                    row[j]->appendTo(str);
+                }
+                str += ']';
+            }
+            str += ']';
+            return str;
+        }
+
+        /**
+            \brief Write matrix to a stream in large chunks without building the whole string first
+            \param os stream to write in
+            \param layout layout of the output
+        */
+        void write(std::ostream& os, MatrixLayout layout = MatrixLayout::Compact) const override
+        {
+            const std::size_t chunk_size = 1 << 16;
+            std::vector<std::size_t> widths;
+            std::string buffer;
+            std::string scratch;
+            bool pretty = (layout == MatrixLayout::Pretty);
+
+            if(pretty)
+            {
+                widths.assign(n, 0);
+                for(const auto& row: *elements)
+                {
+                    for(unsigned int j = 0; j < row.size(); j++)
+                    {
+                        scratch.clear();
+                        row[j]->appendTo(scratch);
+                        widths[j] = std::max(widths[j], scratch.size());
+                    }
+                }
+            }
+
+            buffer.reserve(chunk_size + 256);
+            buffer += '[';
+            for(unsigned int i = 0; i < n; i++)
+            {
+                const auto& row = (*elements)[i];
+                if(pretty && i > 0)
+                {
+                    buffer += "\n ";
+                }
+                buffer += '[';
+                for(unsigned int j = 0; j < row.size(); j++)
+                {
+                    if(j > 0)
+                    {
+                        buffer += pretty ? ", " : ",";
+                    }
+                    if(pretty)
+                    {
+                        scratch.clear();
+                        row[j]->appendTo(scratch);
+                        buffer.append(widths[j] - scratch.size(), ' ');
+                        buffer += scratch;
+                    }
+                    else
+                    {
+                        row[j]->appendTo(buffer);
+                    }
+                    if(buffer.size() >= chunk_size)
+                    {
+                        os.write(buffer.data(), buffer.size());
+                        buffer.clear();
+                    }
+                }
+                buffer += ']';
+            }
+            buffer += ']';
+            os.write(buffer.data(), buffer.size());
+        }
+
+        /**
+            \brief Destructor
+        */
+        virtual ~ElementarySquareMatrix() = default;
+
+        /**
+            \brief Operator for ConcreteSquareMatrix addition
+            \param m ConcreteSquareMatrix to add
+            \throw std::invalid_argument if matrices are not the same size
+            \return Result of addition
+        */
+        ElementarySquareMatrix<T>& operator+=(const ElementarySquareMatrix<T>& m);
+
+        /**
+            \brief Operator for ConcreteSquareMatrix subtraction
+            \param m ConcreteSquareMatrix to subtract
+            \throw std::invalid_argument if matrices are not the same size
+            \return Result of subtraction
+        */
+        ElementarySquareMatrix<T>& operator-=(const ElementarySquareMatrix<T>& m);
+
+        /**
+            \brief Operator for ConcreteSquareMatrix multiplication
+            \param m ConcreteSquareMatrix to multiply with
+            \throw std::invalid_argument if matrices are not the same size
+            \return Result of multiplication
+        */
+        ElementarySquareMatrix<T>& operator*=(const ElementarySquareMatrix<T>& m);
+
+        /**
+            \brief Function to check if string is a square matrix
+            \param s string to check
+            \throw false if string is not a square matrix
+            \return true if string is a square matrix
+        */
+        bool isSquareMatrix(const std::string& s);
+
+        /**
+            \brief Evaluate variables in SymbolicSquareMatrix
+            \param v map where variable values are stored
+            \throw std::invalid_argument if evaluation cannot be done
+            \return ConcreteSquareMatrix object
+        */
+        ElementarySquareMatrix<IntElement> evaluate(const Valuation& v) const;
+
+        /**
+            \brief Substitute variables bound in valuation and fold constant parts of elements
+            \param v map where variable values are stored
+            \return SymbolicSquareMatrix object over the remaining variables
+        */
+        ElementarySquareMatrix<Element> specialize(const Valuation& v) const;
+
+};
+
+using ConcreteSquareMatrix = ElementarySquareMatrix<IntElement>;
+using SymbolicSquareMatrix = ElementarySquareMatrix<Element>;
+
+/**
+    \brief Operator for SymbolicSquareMatrix addition
+    \param m1 first member of addition
+    \param m2 second member of addition
+    \throw std::invalid_argument if matrices are not the same size
+    \return Result of addition
+*/
+SymbolicSquareMatrix operator+(const SymbolicSquareMatrix& m1, const SymbolicSquareMatrix& m2);
+
+/**
+    \brief Operator for SymbolicSquareMatrix subtraction
+    \param m1 first member of subtraction
+    \param m2 second member of subtraction
+    \throw std::invalid_argument if matrices are not the same size
+    \return Result of subtraction
+*/
+SymbolicSquareMatrix operator-(const SymbolicSquareMatrix& m1, const SymbolicSquareMatrix& m2);
+
+/**
+    \brief Operator for SymbolicSquareMatrix multiplication
+    \param m1 first member of product
+    \param m2 second member of product
+    \throw std::invalid_argument if matrices are not the same size
+    \return Result of multiplication
+*/
+/* Note: Multiplication for SymbolicSquareMatrix does not work properly*/
+SymbolicSquareMatrix operator*(const SymbolicSquareMatrix& m1, const SymbolicSquareMatrix& m2);
+
+/**
+    \brief SymbolicSquareMatrix multiplication that reports finished rows and can be cancelled
+    \param m1 first member of product
+    \param m2 second member of product
+    \param progress progress of the rows, nullptr if not watched
+    \throw std::invalid_argument if matrices are not the same size
+    \throw OperationCancelled if progress is cancelled
+    \return Result of multiplication
+*/
+SymbolicSquareMatrix multiply(const SymbolicSquareMatrix& m1, const SymbolicSquareMatrix& m2, Progress* progress);
+
+/**
+    \brief Evaluate SymbolicSquareMatrix with blocks of rows run as tasks of the global TaskScheduler
+    \param m matrix to evaluate
+    \param v map where variable values are stored
+    \param threads number of threads the rows are divided for, 1 evaluates in calling thread, 0 decides by size
+    \param progress progress of the rows, nullptr if not watched
+    \throw std::invalid_argument if a variable has no value, the first such entry in row-major order is reported
+    \throw OperationCancelled if progress is cancelled
+    \return ConcreteSquareMatrix object
+*/
+ConcreteSquareMatrix evaluateParallel(const SymbolicSquareMatrix& m, const Valuation& v, unsigned int threads = 0, Progress* progress = nullptr);
+
+/**
+    \brief Operator for ConcreteSquareMatrix multiplication, lazy expressions are converted to ConcreteSquareMatrix first
+    \param m1 first member of product
+    \param m2 second member of product
+    \throw std::invalid_argument if matrices are not the same size
+    \return Result of multiplication
+*/
+ConcreteSquareMatrix operator*(const ConcreteSquareMatrix& m1, const ConcreteSquareMatrix& m2);
+
+/**
+    \brief ConcreteSquareMatrix multiplication that reports finished rows and can be cancelled
+    \param m1 first member of product
+    \param m2 second member of product
+    \param progress progress of the rows, nullptr if not watched
+    \throw std::invalid_argument if matrices are not the same size
+    \throw OperationCancelled if progress is cancelled
+    \return Result of multiplication
+*/
+ConcreteSquareMatrix multiply(const ConcreteSquareMatrix& m1, const ConcreteSquareMatrix& m2, Progress* progress);
+
+/**
+    \brief Operator for ConcreteSquareMatrix addition reusing elements of a temporary first operand
+    \param m1 first member of addition, result is stored in its elements
+    \param m2 second member of addition
+    \throw std::invalid_argument if matrices are not the same size
+    \return Result of addition
+*/
+ConcreteSquareMatrix operator+(ConcreteSquareMatrix&& m1, const ConcreteSquareMatrix& m2);
+
+/**
+    \brief Operator for ConcreteSquareMatrix addition reusing elements of a temporary second operand
+    \param m1 first member of addition
+    \param m2 second member of addition, result is stored in its elements
+    \throw std::invalid_argument if matrices are not the same size
+    \return Result of addition
+*/
+ConcreteSquareMatrix operator+(const ConcreteSquareMatrix& m1, ConcreteSquareMatrix&& m2);
+
+/**
+    \brief Operator for ConcreteSquareMatrix addition of two temporaries
+    \param m1 first member of addition, result is stored in its elements
+    \param m2 second member of addition
+    \throw std::invalid_argument if matrices are not the same size
+    \return Result of addition
+*/
+ConcreteSquareMatrix operator+(ConcreteSquareMatrix&& m1, ConcreteSquareMatrix&& m2);
+
+/**
+    \brief Operator for ConcreteSquareMatrix subtraction reusing elements of a temporary first operand
+    \param m1 first member of subtraction, result is stored in its elements
+    \param m2 second member of subtraction
+    \throw std::invalid_argument if matrices are not the same size
+    \return Result of subtraction
+*/
+ConcreteSquareMatrix operator-(ConcreteSquareMatrix&& m1, const ConcreteSquareMatrix& m2);
+
+/**
+    \brief Operator for ConcreteSquareMatrix subtraction reusing elements of a temporary second operand
+    \param m1 first member of subtraction
+    \param m2 second member of subtraction, result is stored in its elements
+    \throw std::invalid_argument if matrices are not the same size
+    \return Result of subtraction
+*/
+ConcreteSquareMatrix operator-(const ConcreteSquareMatrix& m1, ConcreteSquareMatrix&& m2);
+
+/**
+    \brief Operator for ConcreteSquareMatrix subtraction of two temporaries
+    \param m1 first member of subtraction, result is stored in its elements
+    \param m2 second member of subtraction
+    \throw std::invalid_argument if matrices are not the same size
+    \return Result of subtraction
+*/
+ConcreteSquareMatrix operator-(ConcreteSquareMatrix&& m1, ConcreteSquareMatrix&& m2);
+
+/**
+    \brief Output operator
+    \param os stream to output in
+    \param m reference to ElementarySquareMatrix object
+*/
+std::ostream& operator<<(std::ostream& os, const ElementarySquareMatrix<IntElement>& m);
+
+/**
+    \brief Output operator
+    \param os stream to output in
+    \param m reference to ElementarySquareMatrix object
+*/
+std::ostream& operator<<(std::ostream& os, const ElementarySquareMatrix<Element>& m);
+
+
+
+#endif // ELEMENTARYMATRIX_H_INCLUDED
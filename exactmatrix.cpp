@@ -0,0 +1,387 @@
+/**
+    \file exactmatrix.cpp
+    \brief Code for ExactSquareMatrix class
+*/
+
+#include "exactmatrix.h"
+#include "kernels.h"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+ExactSquareMatrix::ExactSquareMatrix(const ConcreteSquareMatrix& m): n(m.getSize())
+{
+    std::vector<int> ints(static_cast<std::size_t>(n) * n);
+    m.copyValues(ints.data());
+    values.assign(ints.begin(), ints.end());
+}
+
+ExactSquareMatrix::ExactSquareMatrix(unsigned int size, std::vector<long long> vals, std::map<std::size_t, BigInt> big):
+    n(size), values(std::move(vals)), promoted(std::move(big))
+{
+    for(auto it = promoted.begin(); it != promoted.end(); )
+    {
+        // entries that fit after all are kept in the fast array
+        if(it->second.fitsLongLong())
+        {
+            values[it->first] = it->second.toLongLong();
+            it = promoted.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+BigInt ExactSquareMatrix::valueAt(unsigned int i, unsigned int j) const
+{
+    std::size_t k = static_cast<std::size_t>(i) * n + j;
+    auto found = promoted.find(k);
+    return found != promoted.end() ? found->second : BigInt(values[k]);
+}
+
+void ExactSquareMatrix::appendValue(std::string& out, std::size_t k) const
+{
+    auto found = promoted.find(k);
+    if(found != promoted.end())
+        found->second.appendTo(out);
+    else
+        out += std::to_string(values[k]);
+}
+
+std::string ExactSquareMatrix::toString() const
+{
+    std::ostringstream strm;
+    write(strm, MatrixLayout::Compact);
+    return strm.str();
+}
+
+void ExactSquareMatrix::write(std::ostream& os, MatrixLayout layout) const
+{
+    const std::size_t chunk_size = 1 << 16;
+    std::vector<std::size_t> widths;
+    std::string buffer;
+    std::string scratch;
+    bool pretty = (layout == MatrixLayout::Pretty);
+
+    if(pretty)
+    {
+        widths.assign(n, 0);
+        for(std::size_t k = 0; k < values.size(); k++)
+        {
+            scratch.clear();
+            appendValue(scratch, k);
+            widths[k % n] = std::max(widths[k % n], scratch.size());
+        }
+    }
+
+    buffer.reserve(chunk_size + 256);
+    buffer += '[';
+    for(unsigned int i = 0; i < n; i++)
+    {
+        if(pretty && i > 0)
+        {
+            buffer += "\n ";
+        }
+        buffer += '[';
+        for(unsigned int j = 0; j < n; j++)
+        {
+            std::size_t k = static_cast<std::size_t>(i) * n + j;
+            if(j > 0)
+            {
+                buffer += pretty ? ", " : ",";
+            }
+            if(pretty)
+            {
+                scratch.clear();
+                appendValue(scratch, k);
+                buffer.append(widths[j] - scratch.size(), ' ');
+                buffer += scratch;
+            }
+            else
+            {
+                appendValue(buffer, k);
+            }
+            if(buffer.size() >= chunk_size)
+            {
+                os.write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+        }
+        buffer += ']';
+    }
+    buffer += ']';
+    os.write(buffer.data(), buffer.size());
+}
+
+ConcreteSquareMatrix ExactSquareMatrix::evaluate(const Valuation&) const
+{
+    std::vector<int> ints(values.size());
+    for(std::size_t k = 0; k < values.size(); k++)
+    {
+        if(!promoted.empty() || values[k] < std::numeric_limits<int>::min() || values[k] > std::numeric_limits<int>::max())
+        {
+            throw std::invalid_argument("Value does not fit in int");
+        }
+        ints[k] = static_cast<int>(values[k]);
+    }
+    return ConcreteSquareMatrix::fromValues(n, ints.data());
+}
+
+SymbolicSquareMatrix ExactSquareMatrix::specialize(const Valuation& v) const
+{
+    return evaluate(v).specialize(v);
+}
+
+std::uint64_t ExactSquareMatrix::contentHash() const
+{
+    std::uint64_t h = hashCombine(0, n);
+    for(std::size_t k = 0; k < values.size(); k++)
+    {
+        auto found = promoted.find(k);
+        if(found != promoted.end())
+            h = hashCombine(h, found->second.hash());
+        else if(values[k] >= std::numeric_limits<int>::min() && values[k] <= std::numeric_limits<int>::max())
+            h = hashCombine(h, IntElement(static_cast<int>(values[k])).hash());
+        else
+            h = hashCombine(h, hashCombine('l', static_cast<std::uint64_t>(values[k])));
+    }
+    return h;
+}
+
+SquareMatrix* ExactSquareMatrix::clone() const
+{
+    return new ExactSquareMatrix(*this);
+}
+
+bool ExactSquareMatrix::sameContent(const SquareMatrix& m) const
+{
+    const ExactSquareMatrix* em = dynamic_cast<const ExactSquareMatrix*>(&m);
+    if(em == nullptr || em->n != n || em->promoted.size() != promoted.size())
+        return false;
+    for(std::size_t k = 0; k < values.size(); k++)
+    {
+        auto found = promoted.find(k);
+        if(found == promoted.end())
+        {
+            if(em->promoted.count(k) != 0 || em->values[k] != values[k])
+                return false;
+        }
+        else
+        {
+            auto other = em->promoted.find(k);
+            if(other == em->promoted.end() || !(other->second == found->second))
+                return false;
+        }
+    }
+    return true;
+}
+
+/**
+    \brief Add or subtract entry by entry, entries that overflow are promoted
+*/
+template <typename SmallOp, typename BigOp>
+static ExactSquareMatrix elementwise(const ExactSquareMatrix& m1, const ExactSquareMatrix& m2, SmallOp small_op, BigOp big_op)
+{
+    if(m1.getSize() != m2.getSize())
+    {
+        throw std::invalid_argument("Matrices are not the same size");
+    }
+
+    const std::vector<long long>& a = m1.getValues();
+    const std::vector<long long>& b = m2.getValues();
+    std::vector<long long> c(a.size());
+    std::map<std::size_t, BigInt> big;
+
+    for(std::size_t k = 0; k < a.size(); k++)
+    {
+        if(small_op(a[k], b[k], c[k]))
+            big.emplace(k, big_op(BigInt(a[k]), BigInt(b[k])));
+    }
+
+    // promoted operands are combined with BigInt, their 64-bit values are not valid
+    for(const auto& entry: m1.getPromoted())
+    {
+        big[entry.first] = big_op(entry.second, m2.valueAt(static_cast<unsigned int>(entry.first / m1.getSize()), static_cast<unsigned int>(entry.first % m1.getSize())));
+    }
+    for(const auto& entry: m2.getPromoted())
+    {
+        big[entry.first] = big_op(m1.valueAt(static_cast<unsigned int>(entry.first / m1.getSize()), static_cast<unsigned int>(entry.first % m1.getSize())), entry.second);
+    }
+    return ExactSquareMatrix(m1.getSize(), std::move(c), std::move(big));
+}
+
+ExactSquareMatrix exactAdd(const ExactSquareMatrix& m1, const ExactSquareMatrix& m2)
+{
+    return elementwise(m1, m2,
+        [](long long a, long long b, long long& c) { return __builtin_add_overflow(a, b, &c); },
+        [](const BigInt& a, const BigInt& b) { return a + b; });
+}
+
+ExactSquareMatrix exactSubtract(const ExactSquareMatrix& m1, const ExactSquareMatrix& m2)
+{
+    return elementwise(m1, m2,
+        [](long long a, long long b, long long& c) { return __builtin_sub_overflow(a, b, &c); },
+        [](const BigInt& a, const BigInt& b) { return a - b; });
+}
+
+ExactSquareMatrix exactMultiply(const ExactSquareMatrix& m1, const ExactSquareMatrix& m2, Progress* progress)
+{
+    unsigned int n = m1.getSize();
+    if(n != m2.getSize())
+    {
+        throw std::invalid_argument("Matrices are not the same size");
+    }
+
+    const std::vector<long long>& a = m1.getValues();
+    const std::vector<long long>& b = m2.getValues();
+    std::vector<long long> c(a.size(), 0);
+    std::vector<unsigned char> overflow(a.size(), 0);
+
+    // if no sum of n products can overflow, the kernel needs no checks
+    long long bound_a = 0;
+    long long bound_b = 0;
+    for(std::size_t k = 0; k < a.size(); k++)
+    {
+        bound_a = std::max(bound_a, a[k] == std::numeric_limits<long long>::min() ? std::numeric_limits<long long>::max() : std::llabs(a[k]));
+        bound_b = std::max(bound_b, b[k] == std::numeric_limits<long long>::min() ? std::numeric_limits<long long>::max() : std::llabs(b[k]));
+    }
+    long long bound;
+    bool checked = __builtin_mul_overflow(bound_a, bound_b, &bound) || __builtin_mul_overflow(bound, static_cast<long long>(n), &bound);
+    // rows are gone through once for every block of columns
+    if(progress)
+        progress->setTotal(static_cast<std::size_t>(n) * ((n + kernel_column_block - 1) / kernel_column_block));
+
+    if(!checked)
+    {
+        for(std::size_t j0 = 0; j0 < n; j0 += kernel_column_block)
+        {
+            std::size_t j1 = std::min<std::size_t>(n, j0 + kernel_column_block);
+            for(std::size_t i = 0; i < n; i++)
+            {
+                if(progress)
+                    progress->check();
+                long long* c_row = &c[i * n];
+                for(std::size_t k = 0; k < n; k++)
+                {
+                    const long long factor = a[i * n + k];
+                    const long long* b_row = &b[k * n];
+                    for(std::size_t j = j0; j < j1; j++)
+                    {
+                        c_row[j] += factor * b_row[j];
+                    }
+                }
+                if(progress)
+                    progress->advance();
+            }
+        }
+    }
+    else
+    {
+        // every product and sum is checked
+        for(std::size_t j0 = 0; j0 < n; j0 += kernel_column_block)
+        {
+            std::size_t j1 = std::min<std::size_t>(n, j0 + kernel_column_block);
+            for(std::size_t i = 0; i < n; i++)
+            {
+                if(progress)
+                    progress->check();
+                long long* c_row = &c[i * n];
+                unsigned char* o_row = &overflow[i * n];
+                for(std::size_t k = 0; k < n; k++)
+                {
+                    const long long factor = a[i * n + k];
+                    if(factor == 0)
+                        continue;
+
+                    const long long* b_row = &b[k * n];
+                    for(std::size_t j = j0; j < j1; j++)
+                    {
+                        long long p;
+                        bool failed = __builtin_mul_overflow(factor, b_row[j], &p);
+                        failed |= __builtin_add_overflow(c_row[j], p, &c_row[j]);
+                        o_row[j] |= failed;
+                    }
+                }
+                if(progress)
+                    progress->advance();
+            }
+        }
+    }
+
+    // entries that overflowed or use promoted values are calculated again with BigInt
+    std::vector<unsigned char> big_row(n, 0);
+    std::vector<unsigned char> big_column(n, 0);
+    for(const auto& entry: m1.getPromoted())
+        big_row[entry.first / n] = 1;
+    for(const auto& entry: m2.getPromoted())
+        big_column[entry.first % n] = 1;
+
+    std::map<std::size_t, BigInt> big;
+    std::vector<BigInt> row;
+    std::vector<BigInt> column;
+    BigInt product;
+    if(progress)
+        progress->setTotal(n);
+    for(unsigned int j = 0; j < n; j++)
+    {
+        if(progress)
+        {
+            progress->check();
+            progress->advance();
+        }
+        column.clear();
+        for(unsigned int i = 0; i < n; i++)
+        {
+            std::size_t idx = static_cast<std::size_t>(i) * n + j;
+            if(!overflow[idx] && !big_row[i] && !big_column[j])
+                continue;
+
+            // operands are converted once per column and row, not once per product
+            if(column.empty())
+            {
+                for(unsigned int k = 0; k < n; k++)
+                    column.push_back(m2.valueAt(k, j));
+            }
+            row.clear();
+            for(unsigned int k = 0; k < n; k++)
+                row.push_back(m1.valueAt(i, k));
+
+            BigInt sum;
+            for(unsigned int k = 0; k < n; k++)
+            {
+                if(row[k].isZero() || column[k].isZero())
+                    continue;
+                product = row[k];
+                product *= column[k];
+                sum += product;
+            }
+            big.emplace(idx, std::move(sum));
+        }
+    }
+    return ExactSquareMatrix(n, std::move(c), std::move(big));
+}
+
+ExactSquareMatrix exactPower(const ExactSquareMatrix& m, unsigned long long e, Progress* progress)
+{
+    unsigned int n = m.getSize();
+    std::vector<long long> identity(static_cast<std::size_t>(n) * n, 0);
+    for(unsigned int i = 0; i < n; i++)
+    {
+        identity[static_cast<std::size_t>(i) * n + i] = 1;
+    }
+
+    ExactSquareMatrix result(n, std::move(identity));
+    ExactSquareMatrix square = m;
+    for( ; e != 0; e >>= 1)
+    {
+        if(e & 1)
+            result = exactMultiply(result, square, progress);
+        if(e > 1)
+            square = exactMultiply(square, square, progress);
+    }
+    return result;
+}
@@ -0,0 +1,182 @@
+/**
+    \file exactmatrix.h
+    \brief Header for ExactSquareMatrix class
+*/
+
+#ifndef EXACTMATRIX_H_INCLUDED
+#define EXACTMATRIX_H_INCLUDED
+#include "bigint.h"
+#include "elementarymatrix.h"
+#include "progress.h"
+#include <map>
+#include <vector>
+
+/**
+    \class ExactSquareMatrix
+    \brief Integer matrix that never overflows
+
+    Values are kept in a contiguous array of 64-bit integers. Only the entries whose value
+    does not fit in 64 bits are promoted to BigInt and kept separately.
+*/
+class ExactSquareMatrix : public SquareMatrix
+{
+    private:
+        unsigned int n = 0;
+        std::vector<long long> values;
+        std::map<std::size_t, BigInt> promoted;
+
+        /**
+            \brief Append value of entry to a string
+            \param out string to append to
+            \param k index of entry in row-major order
+        */
+        void appendValue(std::string& out, std::size_t k) const;
+
+    public:
+
+        /**
+            \brief Default constructor
+        */
+        ExactSquareMatrix() = default;
+
+        /**
+            \brief Parametric constructor
+            \param m ConcreteSquareMatrix to copy
+        */
+        explicit ExactSquareMatrix(const ConcreteSquareMatrix& m);
+
+        /**
+            \brief Parametric constructor
+            \param size number of rows and columns
+            \param vals n*n values in row-major order, values of promoted entries are ignored
+            \param big promoted entries by row-major index
+        */
+        ExactSquareMatrix(unsigned int size, std::vector<long long> vals, std::map<std::size_t, BigInt> big = {});
+
+        /**
+            \brief Function to get size of matrix
+            \return Number of rows and columns
+        */
+        unsigned int getSize() const
+        {
+            return n;
+        }
+
+        /**
+            \brief Function to get value of an entry
+            \param i row
+            \param j column
+            \return The value
+        */
+        BigInt valueAt(unsigned int i, unsigned int j) const;
+
+        /**
+            \brief Function to get 64-bit values, values of promoted entries are not valid
+            \return Reference to values in row-major order
+        */
+        const std::vector<long long>& getValues() const
+        {
+            return values;
+        }
+
+        /**
+            \brief Function to get promoted entries
+            \return Reference to map from row-major index to value
+        */
+        const std::map<std::size_t, BigInt>& getPromoted() const
+        {
+            return promoted;
+        }
+
+        /**
+            \brief Returns string representation of matrix
+            \return The string representation
+        */
+        std::string toString() const override;
+
+        /**
+            \brief Write matrix to a stream in large chunks
+            \param os stream to write in
+            \param layout layout of the output
+        */
+        void write(std::ostream& os, MatrixLayout layout = MatrixLayout::Compact) const override;
+
+        /**
+            \brief Convert to ConcreteSquareMatrix, valuation is not needed
+            \param v map where variable values are stored
+            \throw std::invalid_argument if a value does not fit in int
+            \return ConcreteSquareMatrix object
+        */
+        ConcreteSquareMatrix evaluate(const Valuation& v) const override;
+
+        /**
+            \brief Convert to SymbolicSquareMatrix
+            \param v map where variable values are stored
+            \throw std::invalid_argument if a value does not fit in int
+            \return SymbolicSquareMatrix object
+        */
+        SymbolicSquareMatrix specialize(const Valuation& v) const override;
+
+        /**
+            \brief Calculate 64-bit hash of matrix content, same as hash of ConcreteSquareMatrix with the same values
+            \return The hash
+        */
+        std::uint64_t contentHash() const override;
+
+        /**
+            \brief Copy matrix
+            \return Pointer to the copy
+        */
+        SquareMatrix* clone() const override;
+
+        /**
+            \brief Compare content with another matrix
+            \param m matrix to compare with
+            \return true if m is ExactSquareMatrix with the same entries promoted to the same values
+        */
+        bool sameContent(const SquareMatrix& m) const override;
+};
+
+/**
+    \brief Add two matrices, entries that overflow are promoted to BigInt
+    \param m1 first matrix
+    \param m2 second matrix
+    \throw std::invalid_argument if matrices are not the same size
+    \return Result of addition
+*/
+ExactSquareMatrix exactAdd(const ExactSquareMatrix& m1, const ExactSquareMatrix& m2);
+
+/**
+    \brief Subtract two matrices, entries that overflow are promoted to BigInt
+    \param m1 first matrix
+    \param m2 second matrix
+    \throw std::invalid_argument if matrices are not the same size
+    \return Result of subtraction
+*/
+ExactSquareMatrix exactSubtract(const ExactSquareMatrix& m1, const ExactSquareMatrix& m2);
+
+/**
+    \brief Multiply two matrices
+
+    Product is calculated with a 64-bit kernel that checks every operation for overflow.
+    Only entries that overflowed, or that depend on promoted entries, are calculated again with BigInt.
+    \param m1 first matrix
+    \param m2 second matrix
+    \param progress progress reported by rows, then by columns calculated again, and checked for cancellation, may be nullptr
+    \throw std::invalid_argument if matrices are not the same size
+    \throw OperationCancelled if progress is cancelled
+    \return Result of multiplication
+*/
+ExactSquareMatrix exactMultiply(const ExactSquareMatrix& m1, const ExactSquareMatrix& m2, Progress* progress = nullptr);
+
+/**
+    \brief Raise matrix to a power with repeated squaring
+    \param m the matrix
+    \param e the exponent, 0 gives identity matrix
+    \param progress progress of each multiplication, checked for cancellation, may be nullptr
+    \throw OperationCancelled if progress is cancelled
+    \return Result of exponentiation
+*/
+ExactSquareMatrix exactPower(const ExactSquareMatrix& m, unsigned long long e, Progress* progress = nullptr);
+
+#endif // EXACTMATRIX_H_INCLUDED
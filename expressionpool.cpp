@@ -0,0 +1,123 @@
+/**
+    \file expressionpool.cpp
+    \brief Code for ExpressionPool class
+*/
+
+#include "expressionpool.h"
+#include <array>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+std::uint32_t ExpressionPool::add(const Element& e)
+{
+    auto found = ids.find(&e);
+    if(found != ids.end())
+        return found->second;
+
+    // explicit work stack, second is true once the operands have been pushed
+    std::vector<std::pair<const Element*, bool>> work;
+    work.emplace_back(&e, false);
+
+    while(!work.empty())
+    {
+        const Element* current = work.back().first;
+        bool expanded = work.back().second;
+        if(ids.count(current))
+        {
+            work.pop_back();
+            continue;
+        }
+
+        ExpressionNode node{};
+        if(const IntElement* ie = dynamic_cast<const IntElement*>(current))
+        {
+            node.kind = NodeKind::Int;
+            node.left = static_cast<std::uint32_t>(ie->getVal());
+        }
+        else if(const VariableElement* ve = dynamic_cast<const VariableElement*>(current))
+        {
+            node.kind = NodeKind::Variable;
+            node.symbol = ve->getVal();
+        }
+        else
+        {
+            const CompositeElement* ce = dynamic_cast<const CompositeElement*>(current);
+            if(ce == nullptr)
+            {
+                throw std::invalid_argument("Unknown element type");
+            }
+            if(!expanded)
+            {
+                work.back().second = true;
+                work.emplace_back(ce->getOperand2().get(), false);
+                work.emplace_back(ce->getOperand1().get(), false);
+                continue;
+            }
+
+            switch(ce->getOperation())
+            {
+                case Operation::Add:
+                    node.kind = NodeKind::Add;
+                    break;
+                case Operation::Subtract:
+                    node.kind = NodeKind::Subtract;
+                    break;
+                default:
+                    node.kind = NodeKind::Multiply;
+                    break;
+            }
+            node.left = ids.at(ce->getOperand1().get());
+            node.right = ids.at(ce->getOperand2().get());
+        }
+
+        if(nodes.size() >= std::numeric_limits<std::uint32_t>::max())
+        {
+            throw std::length_error("Too many expression nodes");
+        }
+        ids.emplace(current, static_cast<std::uint32_t>(nodes.size()));
+        nodes.push_back(node);
+        work.pop_back();
+    }
+    return ids.at(&e);
+}
+
+void ExpressionPool::evaluate(const Valuation& v, std::vector<int>& values) const
+{
+    std::array<int, 256> variables{};
+    std::array<bool, 256> bound{};
+    for(const auto& binding: v)
+    {
+        variables[static_cast<unsigned char>(binding.first)] = binding.second;
+        bound[static_cast<unsigned char>(binding.first)] = true;
+    }
+
+    values.resize(nodes.size());
+    for(std::size_t i = 0; i < nodes.size(); i++)
+    {
+        const ExpressionNode& node = nodes[i];
+        switch(node.kind)
+        {
+            case NodeKind::Int:
+                values[i] = static_cast<int>(node.left);
+                break;
+            case NodeKind::Variable:
+                if(!bound[static_cast<unsigned char>(node.symbol)])
+                {
+                    throw std::invalid_argument(std::string("Could not do evaluation, variable ") + node.symbol + " has no value");
+                }
+                values[i] = variables[static_cast<unsigned char>(node.symbol)];
+                break;
+            case NodeKind::Add:
+                values[i] = applyOperation(Operation::Add, values[node.left], values[node.right]);
+                break;
+            case NodeKind::Subtract:
+                values[i] = applyOperation(Operation::Subtract, values[node.left], values[node.right]);
+                break;
+            case NodeKind::Multiply:
+                values[i] = applyOperation(Operation::Multiply, values[node.left], values[node.right]);
+                break;
+        }
+    }
+}
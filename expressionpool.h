@@ -0,0 +1,87 @@
+/**
+    \file expressionpool.h
+    \brief Header for ExpressionPool class
+*/
+
+#ifndef EXPRESSIONPOOL_H_INCLUDED
+#define EXPRESSIONPOOL_H_INCLUDED
+#include "compositeelement.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+    \brief Kind of ExpressionNode
+*/
+enum class NodeKind : std::uint8_t
+{
+    Int,
+    Variable,
+    Add,
+    Subtract,
+    Multiply
+};
+
+/**
+    \brief Compact expression node, operands are indices of earlier nodes in the same pool
+*/
+struct ExpressionNode
+{
+    NodeKind kind;
+    char symbol;            ///< name of variable for Variable nodes
+    std::uint32_t left;     ///< index of first operand, value of Int nodes stored as unsigned
+    std::uint32_t right;    ///< index of second operand
+};
+
+/**
+    \class ExpressionPool
+    \brief Element trees flattened to an array of compact nodes
+
+    Nodes are stored in post-order, so operands always come before the node using them
+    and the whole pool is evaluated in one pass without recursion. Subtrees shared
+    between entries are stored once, so added Elements must outlive the pool.
+*/
+class ExpressionPool
+{
+    private:
+        std::vector<ExpressionNode> nodes;
+        std::unordered_map<const Element*, std::uint32_t> ids;
+
+    public:
+
+        /**
+            \brief Add Element tree to pool
+            \param e root of the tree
+            \throw std::length_error if pool would have more than 2^32 nodes
+            \return Index of node representing e
+        */
+        std::uint32_t add(const Element& e);
+
+        /**
+            \brief Evaluate every node of the pool
+            \param v map where variable values are stored
+            \param values evaluated value of every node
+            \throw std::invalid_argument naming the first variable in node order that has no value
+        */
+        void evaluate(const Valuation& v, std::vector<int>& values) const;
+
+        /**
+            \brief Function to get nodes
+            \return Reference to nodes in post-order
+        */
+        const std::vector<ExpressionNode>& getNodes() const
+        {
+            return nodes;
+        }
+
+        /**
+            \brief Function to get number of nodes
+            \return Number of nodes
+        */
+        std::size_t size() const
+        {
+            return nodes.size();
+        }
+};
+
+#endif // EXPRESSIONPOOL_H_INCLUDED
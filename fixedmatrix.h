@@ -0,0 +1,285 @@
+/**
+    \file fixedmatrix.h
+    \brief Header for FixedSquareMatrix class and dispatching small ConcreteSquareMatrix objects to it
+*/
+
+#ifndef FIXEDMATRIX_H_INCLUDED
+#define FIXEDMATRIX_H_INCLUDED
+#include "elementarymatrix.h"
+#include <array>
+#include <cstddef>
+#include <type_traits>
+
+/// Largest size of ConcreteSquareMatrix calculated with FixedSquareMatrix
+const unsigned int fixed_matrix_limit = 4;
+
+/**
+    \class FixedSquareMatrix
+    \brief Square matrix with size known at compile time, values are stored in place without allocations
+
+    Loops have compile time bounds, so the compiler unrolls them and small matrices are
+    kept in registers. All operations can be used in constant expressions.
+    \tparam T type of values
+    \tparam N number of rows and columns
+*/
+template <typename T, unsigned int N>
+class FixedSquareMatrix
+{
+    private:
+        std::array<T, N * N> values{};
+
+    public:
+
+        /**
+            \brief Default constructor, all values are zero
+        */
+        constexpr FixedSquareMatrix() = default;
+
+        /**
+            \brief Parametric constructor
+            \param vals N*N values in row-major order
+        */
+        constexpr explicit FixedSquareMatrix(const std::array<T, N * N>& vals): values(vals) {}
+
+        /**
+            \brief Function to get identity matrix
+            \return FixedSquareMatrix object
+        */
+        static constexpr FixedSquareMatrix<T, N> identity()
+        {
+            FixedSquareMatrix<T, N> m;
+            for(unsigned int i = 0; i < N; i++)
+                m(i, i) = T(1);
+            return m;
+        }
+
+        /**
+            \brief Function to get value
+            \param i row index
+            \param j column index
+            \return Reference to the value
+        */
+        constexpr T& operator()(unsigned int i, unsigned int j)
+        {
+            return values[i * N + j];
+        }
+
+        /**
+            \brief Function to get value
+            \param i row index
+            \param j column index
+            \return The value
+        */
+        constexpr const T& operator()(unsigned int i, unsigned int j) const
+        {
+            return values[i * N + j];
+        }
+
+        /**
+            \brief Function to get values
+            \return Row-major values
+        */
+        constexpr const std::array<T, N * N>& getValues() const
+        {
+            return values;
+        }
+
+        /**
+            \brief Convert values to another type
+            \tparam U the type
+            \return FixedSquareMatrix object
+        */
+        template <typename U>
+        constexpr FixedSquareMatrix<U, N> cast() const
+        {
+            FixedSquareMatrix<U, N> m;
+            for(unsigned int i = 0; i < N; i++)
+                for(unsigned int j = 0; j < N; j++)
+                    m(i, j) = static_cast<U>((*this)(i, j));
+            return m;
+        }
+
+        /**
+            \brief Function to get transpose of matrix
+            \return FixedSquareMatrix object
+        */
+        constexpr FixedSquareMatrix<T, N> transpose() const
+        {
+            FixedSquareMatrix<T, N> m;
+            for(unsigned int i = 0; i < N; i++)
+                for(unsigned int j = 0; j < N; j++)
+                    m(j, i) = (*this)(i, j);
+            return m;
+        }
+
+        /**
+            \brief Function to get matrix without one row and column
+            \param row index of row to remove
+            \param column index of column to remove
+            \return FixedSquareMatrix object
+        */
+        template <unsigned int M = N, typename = typename std::enable_if<(M > 1)>::type>
+        constexpr FixedSquareMatrix<T, N - 1> submatrix(unsigned int row, unsigned int column) const
+        {
+            FixedSquareMatrix<T, N - 1> m;
+            for(unsigned int i = 0; i + 1 < N; i++)
+                for(unsigned int j = 0; j + 1 < N; j++)
+                    m(i, j) = (*this)(i + (i >= row), j + (j >= column));
+            return m;
+        }
+
+        /**
+            \brief Calculate determinant with cofactor expansion along first row
+            \tparam W type used in calculation, must hold N! products of N values
+            \return The determinant, 1 for empty matrix
+        */
+        template <typename W = T>
+        constexpr W determinant() const
+        {
+            if constexpr(N == 0)
+            {
+                return W(1);
+            }
+            else if constexpr(N == 1)
+            {
+                return W(values[0]);
+            }
+            else if constexpr(N == 2)
+            {
+                return W(values[0]) * W(values[3]) - W(values[1]) * W(values[2]);
+            }
+            else
+            {
+                W det = W(0);
+                for(unsigned int j = 0; j < N; j++)
+                {
+                    W term = W((*this)(0, j)) * submatrix(0, j).template determinant<W>();
+                    det = (j % 2 == 0) ? det + term : det - term;
+                }
+                return det;
+            }
+        }
+
+        /**
+            \brief Addition operator
+            \param m1 first matrix
+            \param m2 second matrix
+            \return FixedSquareMatrix object
+        */
+        friend constexpr FixedSquareMatrix<T, N> operator+(const FixedSquareMatrix<T, N>& m1, const FixedSquareMatrix<T, N>& m2)
+        {
+            FixedSquareMatrix<T, N> m;
+            for(std::size_t k = 0; k < N * N; k++)
+                m.values[k] = m1.values[k] + m2.values[k];
+            return m;
+        }
+
+        /**
+            \brief Subtraction operator
+            \param m1 first matrix
+            \param m2 second matrix
+            \return FixedSquareMatrix object
+        */
+        friend constexpr FixedSquareMatrix<T, N> operator-(const FixedSquareMatrix<T, N>& m1, const FixedSquareMatrix<T, N>& m2)
+        {
+            FixedSquareMatrix<T, N> m;
+            for(std::size_t k = 0; k < N * N; k++)
+                m.values[k] = m1.values[k] - m2.values[k];
+            return m;
+        }
+
+        /**
+            \brief Multiplication operator
+            \param m1 first matrix
+            \param m2 second matrix
+            \return FixedSquareMatrix object
+        */
+        friend constexpr FixedSquareMatrix<T, N> operator*(const FixedSquareMatrix<T, N>& m1, const FixedSquareMatrix<T, N>& m2)
+        {
+            FixedSquareMatrix<T, N> m;
+            for(unsigned int i = 0; i < N; i++)
+                for(unsigned int j = 0; j < N; j++)
+                {
+                    T sum = T(0);
+                    for(unsigned int k = 0; k < N; k++)
+                        sum += m1(i, k) * m2(k, j);
+                    m(i, j) = sum;
+                }
+            return m;
+        }
+
+        /**
+            \brief Equality operator
+            \param m1 first matrix
+            \param m2 second matrix
+            \return true if all values are equal
+        */
+        friend constexpr bool operator==(const FixedSquareMatrix<T, N>& m1, const FixedSquareMatrix<T, N>& m2)
+        {
+            for(std::size_t k = 0; k < N * N; k++)
+                if(!(m1.values[k] == m2.values[k]))
+                    return false;
+            return true;
+        }
+};
+
+/**
+    \brief Copy values of ConcreteSquareMatrix to FixedSquareMatrix
+    \tparam N number of rows and columns, must be the size of the matrix
+    \tparam T type of values, unsigned int wraps around like the element operations do
+    \param m the matrix
+    \return FixedSquareMatrix object
+*/
+template <unsigned int N, typename T = int>
+FixedSquareMatrix<T, N> toFixed(const ConcreteSquareMatrix& m)
+{
+    FixedSquareMatrix<T, N> f;
+    for(unsigned int i = 0; i < N; i++)
+        for(unsigned int j = 0; j < N; j++)
+            f(i, j) = static_cast<T>(m.valueAt(i, j));
+    return f;
+}
+
+/**
+    \brief Build ConcreteSquareMatrix of FixedSquareMatrix
+    \param m the matrix, values are converted to int
+    \return ConcreteSquareMatrix object
+*/
+template <typename T, unsigned int N>
+ConcreteSquareMatrix toConcrete(const FixedSquareMatrix<T, N>& m)
+{
+    std::array<int, N * N> vals{};
+    for(std::size_t k = 0; k < N * N; k++)
+        vals[k] = static_cast<int>(m.getValues()[k]);
+    return ConcreteSquareMatrix::fromValues(N, vals.data());
+}
+
+/**
+    \brief Call function with the size of a small matrix as a compile time constant
+    \param n size of the matrix
+    \param f function taking std::integral_constant<unsigned int, N>, called when 1 <= n <= fixed_matrix_limit
+    \return false if n is not small enough and f was not called
+*/
+template <typename F>
+bool dispatchFixed(unsigned int n, F&& f)
+{
+    switch(n)
+    {
+        case 1:
+            f(std::integral_constant<unsigned int, 1>());
+            return true;
+        case 2:
+            f(std::integral_constant<unsigned int, 2>());
+            return true;
+        case 3:
+            f(std::integral_constant<unsigned int, 3>());
+            return true;
+        case 4:
+            f(std::integral_constant<unsigned int, 4>());
+            return true;
+        default:
+            return false;
+    }
+}
+
+#endif // FIXEDMATRIX_H_INCLUDED
@@ -0,0 +1,63 @@
+/**
+    \file kernels.h
+    \brief Cache blocked kernels for dense row-major matrices stored in contiguous arrays
+*/
+
+#ifndef KERNELS_H_INCLUDED
+#define KERNELS_H_INCLUDED
+#include <algorithm>
+#include <cstddef>
+
+/// Number of rows of B kept in cache at a time by multiplication kernels
+const std::size_t kernel_depth_block = 128;
+
+/// Number of columns of B and C kept in cache at a time by multiplication kernels
+const std::size_t kernel_column_block = 512;
+
+/**
+    \brief Calculate C -= A*B for row-major blocks of larger arrays
+
+    Loops are ordered so that the innermost one runs along contiguous rows of B and C
+    and can be vectorized, B is walked in blocks that stay in cache.
+    \param rows number of rows of A and C
+    \param columns number of columns of B and C
+    \param depth number of columns of A and rows of B
+    \param a pointer to first element of A
+    \param lda distance between rows of A
+    \param b pointer to first element of B
+    \param ldb distance between rows of B
+    \param c pointer to first element of C
+    \param ldc distance between rows of C
+*/
+template <typename T>
+void multiplySubtract(std::size_t rows, std::size_t columns, std::size_t depth,
+                      const T* a, std::size_t lda, const T* b, std::size_t ldb, T* c, std::size_t ldc)
+{
+    for(std::size_t j0 = 0; j0 < columns; j0 += kernel_column_block)
+    {
+        std::size_t j1 = std::min(columns, j0 + kernel_column_block);
+        for(std::size_t k0 = 0; k0 < depth; k0 += kernel_depth_block)
+        {
+            std::size_t k1 = std::min(depth, k0 + kernel_depth_block);
+            for(std::size_t i = 0; i < rows; i++)
+            {
+                T* c_row = c + i * ldc;
+                const T* a_row = a + i * lda;
+                for(std::size_t k = k0; k < k1; k++)
+                {
+                    const T factor = a_row[k];
+                    if(factor == T(0))
+                        continue;
+
+                    const T* b_row = b + k * ldb;
+                    for(std::size_t j = j0; j < j1; j++)
+                    {
+                        c_row[j] -= factor * b_row[j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+#endif // KERNELS_H_INCLUDED
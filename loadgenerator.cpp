@@ -0,0 +1,168 @@
+/**
+    \file loadgenerator.cpp
+    \brief Code for CalculatorClient class and load generator of CalculatorServer
+*/
+
+#include "loadgenerator.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+CalculatorClient::CalculatorClient(const std::string& path)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if(path.size() >= sizeof(address.sun_path))
+    {
+        throw std::runtime_error("Socket path is too long: " + path);
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        if(fd >= 0)
+            close(fd);
+        throw std::runtime_error("Could not connect to " + path);
+    }
+}
+
+CalculatorClient::~CalculatorClient()
+{
+    close(fd);
+}
+
+void CalculatorClient::send(const std::string& lines)
+{
+    std::size_t sent = 0;
+    while(sent < lines.size())
+    {
+        ssize_t count = ::send(fd, lines.data() + sent, lines.size() - sent, MSG_NOSIGNAL);
+        if(count < 0 && errno == EINTR)
+            continue;
+        if(count <= 0)
+            throw std::runtime_error("Connection to server was closed");
+        sent += static_cast<std::size_t>(count);
+    }
+}
+
+std::string CalculatorClient::receive()
+{
+    char buffer[1 << 16];
+    while(true)
+    {
+        // response ends with an empty line, a line giving no messages only has the empty line
+        std::size_t end = (!received.empty() && received[0] == '\n') ? 0 : received.find("\n\n");
+        if(end != std::string::npos)
+        {
+            std::size_t length = (end == 0) ? 1 : end + 2;
+            std::string response = received.substr(0, (end == 0) ? 0 : end + 1);
+            received.erase(0, length);
+            return response;
+        }
+
+        ssize_t count = read(fd, buffer, sizeof(buffer));
+        if(count < 0 && errno == EINTR)
+            continue;
+        if(count <= 0)
+            throw std::runtime_error("Connection to server was closed");
+        received.append(buffer, static_cast<std::size_t>(count));
+    }
+}
+
+LoadReport runLoadGenerator(const std::string& path, unsigned int connections, unsigned int requests, unsigned int depth)
+{
+    using Clock = std::chrono::steady_clock;
+    connections = std::max(1u, connections);
+    depth = std::max(1u, depth);
+
+    std::vector<std::vector<double>> latencies(connections);
+    std::vector<std::exception_ptr> errors(connections);
+    std::vector<std::thread> clients;
+    Clock::time_point start = Clock::now();
+
+    for(unsigned int t = 0; t < connections; t++)
+    {
+        clients.emplace_back([&, t]()
+        {
+            try
+            {
+                CalculatorClient client(path);
+                client.request("[[x,2,3][4,y,6][7,8,x]]");
+                client.request("y=" + std::to_string(t));
+                latencies[t].reserve(requests);
+
+                for(unsigned int sent = 0; sent < requests; )
+                {
+                    unsigned int group = std::min(depth, requests - sent);
+                    std::string lines;
+                    for(unsigned int i = sent; i < sent + group; i++)
+                    {
+                        switch(i % 3)
+                        {
+                            case 0:
+                                lines += "x=" + std::to_string(i) + '\n';
+                                break;
+                            case 1:
+                                lines += "=\n";
+                                break;
+                            default:
+                                lines += "det\n";
+                                break;
+                        }
+                    }
+
+                    Clock::time_point sent_at = Clock::now();
+                    client.send(lines);
+                    for(unsigned int i = 0; i < group; i++)
+                    {
+                        client.receive();
+                        latencies[t].push_back(std::chrono::duration<double, std::micro>(Clock::now() - sent_at).count());
+                    }
+                    sent += group;
+                }
+            }
+            catch(...)
+            {
+                errors[t] = std::current_exception();
+            }
+        });
+    }
+    for(auto& c: clients)
+    {
+        c.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    for(const auto& e: errors)
+    {
+        if(e != nullptr)
+            std::rethrow_exception(e);
+    }
+
+    std::vector<double> all;
+    for(const auto& l: latencies)
+    {
+        all.insert(all.end(), l.begin(), l.end());
+    }
+    std::sort(all.begin(), all.end());
+
+    LoadReport report{all.size(), seconds, 0, 0, 0};
+    if(!all.empty())
+    {
+        report.median = all[all.size() / 2];
+        report.p99 = all[std::min(all.size() - 1, all.size() * 99 / 100)];
+        report.max = all.back();
+    }
+    return report;
+}
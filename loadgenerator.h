@@ -0,0 +1,92 @@
+/**
+    \file loadgenerator.h
+    \brief Header for CalculatorClient class and load generator of CalculatorServer
+*/
+
+#ifndef LOADGENERATOR_H_INCLUDED
+#define LOADGENERATOR_H_INCLUDED
+#include <cstdint>
+#include <string>
+
+/**
+    \class CalculatorClient
+    \brief Connection to a CalculatorServer
+*/
+class CalculatorClient
+{
+    private:
+        int fd;
+        std::string received;
+
+    public:
+
+        /**
+            \brief Parametric constructor, connects to the server
+            \param path path of the Unix domain socket
+            \throw std::runtime_error if server cannot be reached
+        */
+        explicit CalculatorClient(const std::string& path);
+
+        CalculatorClient(const CalculatorClient&) = delete;
+        CalculatorClient& operator=(const CalculatorClient&) = delete;
+
+        /**
+            \brief Destructor, closes the connection
+        */
+        ~CalculatorClient();
+
+        /**
+            \brief Send lines without waiting for their responses
+            \param lines one or more lines, each ending in a newline
+            \throw std::runtime_error if connection is closed
+        */
+        void send(const std::string& lines);
+
+        /**
+            \brief Wait for the response of the oldest line sent
+            \throw std::runtime_error if connection is closed
+            \return Messages of the line without the empty line ending the response
+        */
+        std::string receive();
+
+        /**
+            \brief Send one line and wait for its response
+            \param line the line without a newline
+            \throw std::runtime_error if connection is closed
+            \return Messages of the line
+        */
+        std::string request(const std::string& line)
+        {
+            send(line + '\n');
+            return receive();
+        }
+};
+
+/**
+    \brief Results of a load test
+*/
+struct LoadReport
+{
+    std::uint64_t requests;     ///< number of lines answered
+    double seconds;             ///< wall clock time of the test
+    double median;              ///< median latency in microseconds
+    double p99;                 ///< 99th percentile of latency in microseconds
+    double max;                 ///< largest latency in microseconds
+};
+
+/**
+    \brief Measure throughput and latency of a CalculatorServer
+
+    Every connection pushes a small symbolic matrix and then repeats assignment of a
+    variable, evaluation and determinant. Latency of a line is measured from sending the
+    group of lines it belongs to until its response has arrived.
+    \param path path of the Unix domain socket
+    \param connections number of clients running in parallel
+    \param requests number of lines each client sends
+    \param depth number of lines a client sends before waiting for their responses
+    \throw std::runtime_error if server cannot be reached
+    \return Measured results
+*/
+LoadReport runLoadGenerator(const std::string& path, unsigned int connections, unsigned int requests, unsigned int depth = 1);
+
+#endif // LOADGENERATOR_H_INCLUDED
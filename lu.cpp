@@ -0,0 +1,250 @@
+/**
+    \file lu.cpp
+    \brief Code for LUFactorization class template
+*/
+
+#include "lu.h"
+#include "kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+/// Number of columns factored at a time before the trailing matrix is updated
+static const unsigned int lu_block = 64;
+
+bool RealField::betterPivot(value_type candidate, value_type current) const
+{
+    return std::fabs(candidate) > std::fabs(current);
+}
+
+void RealField::multiplySubtract(std::size_t rows, std::size_t columns, std::size_t depth,
+                                 const value_type* a, std::size_t lda, const value_type* b, std::size_t ldb,
+                                 value_type* c, std::size_t ldc) const
+{
+    ::multiplySubtract(rows, columns, depth, a, lda, b, ldb, c, ldc);
+}
+
+ModularField::ModularField(std::uint32_t modulus): mod(modulus)
+{
+    bool prime = true;
+    for(std::uint32_t d = 2; prime && static_cast<std::uint64_t>(d) * d <= modulus; d++)
+    {
+        if(modulus % d == 0)
+            prime = false;
+    }
+    if(!prime)
+    {
+        throw std::invalid_argument("Modulus must be a prime");
+    }
+}
+
+ModularField::value_type ModularField::inverse(value_type a) const
+{
+    value_type result = 1;
+    value_type base = a;
+    for(std::uint32_t e = mod.getValue() - 2; e != 0; e >>= 1)
+    {
+        if(e & 1)
+            result = multiply(result, base);
+        base = multiply(base, base);
+    }
+    return result;
+}
+
+void ModularField::multiplySubtract(std::size_t rows, std::size_t columns, std::size_t depth,
+                                    const value_type* a, std::size_t lda, const value_type* b, std::size_t ldb,
+                                    value_type* c, std::size_t ldc) const
+{
+    for(std::size_t i = 0; i < rows; i++)
+    {
+        for(std::size_t k = 0; k < depth; k++)
+        {
+            value_type factor = a[i * lda + k];
+            if(factor == 0)
+                continue;
+
+            const value_type* b_row = b + k * ldb;
+            value_type* c_row = c + i * ldc;
+            for(std::size_t j = 0; j < columns; j++)
+            {
+                c_row[j] = subtract(c_row[j], multiply(factor, b_row[j]));
+            }
+        }
+    }
+}
+
+template <typename Field>
+LUFactorization<Field>::LUFactorization(const ConcreteSquareMatrix& m, Field f): field(f), n(m.getSize())
+{
+    std::vector<int> values(static_cast<std::size_t>(n) * n);
+    m.copyValues(values.data());
+
+    lu.resize(values.size());
+    for(std::size_t i = 0; i < values.size(); i++)
+    {
+        lu[i] = field.fromInt(values[i]);
+    }
+
+    permutation.resize(n);
+    for(unsigned int i = 0; i < n; i++)
+    {
+        permutation[i] = i;
+    }
+    factor();
+}
+
+template <typename Field>
+void LUFactorization<Field>::factor()
+{
+    value_type* a = lu.data();
+
+    for(unsigned int k0 = 0; k0 < n; k0 += lu_block)
+    {
+        unsigned int k1 = std::min(n, k0 + lu_block);
+
+        // factor panel of columns k0..k1 with partial pivoting
+        for(unsigned int j = k0; j < k1; j++)
+        {
+            unsigned int p = j;
+            for(unsigned int i = j + 1; i < n; i++)
+            {
+                if(field.betterPivot(a[static_cast<std::size_t>(i) * n + j], a[static_cast<std::size_t>(p) * n + j]))
+                    p = i;
+            }
+            if(field.isZero(a[static_cast<std::size_t>(p) * n + j]))
+            {
+                throw std::invalid_argument("Matrix is singular");
+            }
+            if(p != j)
+            {
+                std::swap_ranges(a + static_cast<std::size_t>(p) * n, a + static_cast<std::size_t>(p + 1) * n, a + static_cast<std::size_t>(j) * n);
+                std::swap(permutation[p], permutation[j]);
+                odd = !odd;
+            }
+
+            const value_type* pivot_row = a + static_cast<std::size_t>(j) * n;
+            value_type inv = field.inverse(pivot_row[j]);
+            for(unsigned int i = j + 1; i < n; i++)
+            {
+                value_type* row = a + static_cast<std::size_t>(i) * n;
+                row[j] = field.multiply(row[j], inv);
+                if(field.isZero(row[j]))
+                    continue;
+                for(unsigned int c = j + 1; c < k1; c++)
+                {
+                    row[c] = field.subtract(row[c], field.multiply(row[j], pivot_row[c]));
+                }
+            }
+        }
+
+        if(k1 == n)
+            break;
+
+        // rows k0..k1 of U right of the panel, L of the panel has unit diagonal
+        for(unsigned int i = k0 + 1; i < k1; i++)
+        {
+            value_type* row = a + static_cast<std::size_t>(i) * n;
+            for(unsigned int r = k0; r < i; r++)
+            {
+                if(field.isZero(row[r]))
+                    continue;
+                const value_type* u_row = a + static_cast<std::size_t>(r) * n;
+                for(unsigned int c = k1; c < n; c++)
+                {
+                    row[c] = field.subtract(row[c], field.multiply(row[r], u_row[c]));
+                }
+            }
+        }
+
+        // trailing matrix -= L21 * U12
+        field.multiplySubtract(n - k1, n - k1, k1 - k0,
+                               a + static_cast<std::size_t>(k1) * n + k0, n,
+                               a + static_cast<std::size_t>(k0) * n + k1, n,
+                               a + static_cast<std::size_t>(k1) * n + k1, n);
+    }
+}
+
+template <typename Field>
+typename LUFactorization<Field>::value_type LUFactorization<Field>::dotSubtract(value_type x, const value_type* a, const value_type* b, unsigned int count) const
+{
+    for(unsigned int k = 0; k < count; k++)
+    {
+        x = field.subtract(x, field.multiply(a[k], b[k]));
+    }
+    return x;
+}
+
+template <typename Field>
+std::vector<typename LUFactorization<Field>::value_type> LUFactorization<Field>::solve(const std::vector<value_type>& b) const
+{
+    return solve(b, 1);
+}
+
+template <typename Field>
+std::vector<typename LUFactorization<Field>::value_type> LUFactorization<Field>::solve(const std::vector<value_type>& b, unsigned int columns) const
+{
+    if(b.size() != static_cast<std::size_t>(n) * columns)
+    {
+        throw std::invalid_argument("Right-hand side has wrong size");
+    }
+
+    std::vector<value_type> x(b.size());
+    for(unsigned int i = 0; i < n; i++)
+    {
+        std::copy_n(b.begin() + static_cast<std::size_t>(permutation[i]) * columns, columns, x.begin() + static_cast<std::size_t>(i) * columns);
+    }
+
+    // forward substitution with L, all right-hand sides of a row at once
+    for(unsigned int i = 1; i < n; i++)
+    {
+        const value_type* l_row = lu.data() + static_cast<std::size_t>(i) * n;
+        if(columns == 1)
+            x[i] = dotSubtract(x[i], l_row, x.data(), i);
+        else
+            field.multiplySubtract(1, columns, i, l_row, n, x.data(), columns, x.data() + static_cast<std::size_t>(i) * columns, columns);
+    }
+
+    // backward substitution with U
+    for(unsigned int i = n; i-- > 0; )
+    {
+        value_type* row = x.data() + static_cast<std::size_t>(i) * columns;
+        const value_type* u_row = lu.data() + static_cast<std::size_t>(i) * n;
+        if(columns == 1)
+            row[0] = dotSubtract(row[0], u_row + i + 1, row + 1, n - i - 1);
+        else
+            field.multiplySubtract(1, columns, n - i - 1, u_row + i + 1, n,
+                                   x.data() + static_cast<std::size_t>(i + 1) * columns, columns, row, columns);
+
+        value_type inv = field.inverse(u_row[i]);
+        for(unsigned int c = 0; c < columns; c++)
+        {
+            row[c] = field.multiply(row[c], inv);
+        }
+    }
+    return x;
+}
+
+template <typename Field>
+std::vector<typename LUFactorization<Field>::value_type> LUFactorization<Field>::inverse() const
+{
+    std::vector<value_type> identity(static_cast<std::size_t>(n) * n, value_type());
+    for(unsigned int i = 0; i < n; i++)
+    {
+        identity[static_cast<std::size_t>(i) * n + i] = field.one();
+    }
+    return solve(identity, n);
+}
+
+template <typename Field>
+typename LUFactorization<Field>::value_type LUFactorization<Field>::determinant() const
+{
+    value_type det = field.one();
+    for(unsigned int i = 0; i < n; i++)
+    {
+        det = field.multiply(det, lu[static_cast<std::size_t>(i) * n + i]);
+    }
+    return odd ? field.subtract(value_type(), det) : det;
+}
+
+template class LUFactorization<RealField>;
+template class LUFactorization<ModularField>;
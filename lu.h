@@ -0,0 +1,222 @@
+/**
+    \file lu.h
+    \brief Header for LUFactorization class template
+*/
+
+#ifndef LU_H_INCLUDED
+#define LU_H_INCLUDED
+#include "elementarymatrix.h"
+#include "modular.h"
+#include <cstdint>
+#include <vector>
+
+/**
+    \class RealField
+    \brief Arithmetic of LUFactorization in double precision
+*/
+class RealField
+{
+    public:
+        using value_type = double;
+
+        value_type fromInt(int v) const
+        {
+            return v;
+        }
+
+        value_type one() const
+        {
+            return 1.0;
+        }
+
+        bool isZero(value_type a) const
+        {
+            return a == 0.0;
+        }
+
+        /**
+            \brief Tell if candidate is a better pivot than current, largest absolute value is chosen
+        */
+        bool betterPivot(value_type candidate, value_type current) const;
+
+        value_type subtract(value_type a, value_type b) const
+        {
+            return a - b;
+        }
+
+        value_type multiply(value_type a, value_type b) const
+        {
+            return a * b;
+        }
+
+        value_type inverse(value_type a) const
+        {
+            return 1.0 / a;
+        }
+
+        /**
+            \brief Calculate C -= A*B for row-major blocks of larger arrays
+        */
+        void multiplySubtract(std::size_t rows, std::size_t columns, std::size_t depth,
+                              const value_type* a, std::size_t lda, const value_type* b, std::size_t ldb,
+                              value_type* c, std::size_t ldc) const;
+};
+
+/**
+    \class ModularField
+    \brief Exact arithmetic of LUFactorization modulo a prime
+*/
+class ModularField
+{
+    private:
+        Modulus mod;
+    public:
+        using value_type = std::uint32_t;
+
+        /**
+            \brief Parametric constructor
+            \param modulus prime modulus, 2^31-1 by default
+            \throw std::invalid_argument if modulus is not a prime
+        */
+        explicit ModularField(std::uint32_t modulus = 2147483647u);
+
+        /**
+            \brief Function to get modulus
+            \return The modulus
+        */
+        std::uint32_t getModulus() const
+        {
+            return mod.getValue();
+        }
+
+        value_type fromInt(int v) const
+        {
+            return mod.fromInt(v);
+        }
+
+        value_type one() const
+        {
+            return 1;
+        }
+
+        bool isZero(value_type a) const
+        {
+            return a == 0;
+        }
+
+        /**
+            \brief Tell if candidate is a better pivot than current, first non-zero value is chosen
+        */
+        bool betterPivot(value_type candidate, value_type current) const
+        {
+            return current == 0 && candidate != 0;
+        }
+
+        value_type subtract(value_type a, value_type b) const
+        {
+            return mod.subtract(a, b);
+        }
+
+        value_type multiply(value_type a, value_type b) const
+        {
+            return mod.multiply(a, b);
+        }
+
+        /**
+            \brief Calculate multiplicative inverse with Fermat's little theorem
+            \param a non-zero value
+            \return The inverse
+        */
+        value_type inverse(value_type a) const;
+
+        /**
+            \brief Calculate C -= A*B for row-major blocks of larger arrays
+        */
+        void multiplySubtract(std::size_t rows, std::size_t columns, std::size_t depth,
+                              const value_type* a, std::size_t lda, const value_type* b, std::size_t ldb,
+                              value_type* c, std::size_t ldc) const;
+};
+
+/**
+    \class LUFactorization
+    \brief Blocked LU factorization with partial pivoting, PA = LU, factors are kept for repeated solves
+
+    Field is RealField for double precision or ModularField for exact results modulo a prime.
+*/
+template <typename Field>
+class LUFactorization
+{
+    public:
+        using value_type = typename Field::value_type;
+
+    private:
+        Field field;
+        unsigned int n;
+        std::vector<value_type> lu;
+        std::vector<unsigned int> permutation;
+        bool odd = false;
+
+        /**
+            \brief Factor lu in place with right-looking blocked algorithm
+            \throw std::invalid_argument if matrix is singular
+        */
+        void factor();
+
+        /**
+            \brief Calculate x - a[0]*b[0] - ... - a[count-1]*b[count-1], used when solving one right-hand side
+        */
+        value_type dotSubtract(value_type x, const value_type* a, const value_type* b, unsigned int count) const;
+
+    public:
+
+        /**
+            \brief Parametric constructor, factors the matrix
+            \param m matrix to factor
+            \param f arithmetic to use
+            \throw std::invalid_argument if matrix is singular
+        */
+        LUFactorization(const ConcreteSquareMatrix& m, Field f = Field());
+
+        /**
+            \brief Function to get size of factored matrix
+            \return Number of rows and columns
+        */
+        unsigned int getSize() const
+        {
+            return n;
+        }
+
+        /**
+            \brief Solve Ax = b
+            \param b right-hand side with n values
+            \throw std::invalid_argument if b has wrong size
+            \return Solution x
+        */
+        std::vector<value_type> solve(const std::vector<value_type>& b) const;
+
+        /**
+            \brief Solve AX = B for many right-hand sides at once
+            \param b n rows of right-hand sides in row-major order, one right-hand side per column
+            \param columns number of right-hand sides
+            \throw std::invalid_argument if b has wrong size
+            \return Solutions X in the same layout as b
+        */
+        std::vector<value_type> solve(const std::vector<value_type>& b, unsigned int columns) const;
+
+        /**
+            \brief Calculate inverse of factored matrix
+            \return Inverse in row-major order
+        */
+        std::vector<value_type> inverse() const;
+
+        /**
+            \brief Calculate determinant of factored matrix
+            \return The determinant
+        */
+        value_type determinant() const;
+};
+
+extern template class LUFactorization<RealField>;
+extern template class LUFactorization<ModularField>;
+
+#endif // LU_H_INCLUDED
@@ -1,476 +1,2596 @@
-/**
-    \file main.cpp
-    \brief Main-function and tests for IntElement, VariableElement, CompositeElement, ConcreteSquareMatrix and SymbolicSquareMatrix classes
-*/
-
-#define CATCH_CONFIG_RUNNER
-#include "catch.hpp"
-#include "elementarymatrix.h"
-#include <stack>
-#include <iostream>
-
-TEST_CASE("IntElement constructor tests", "[value]")
-{
-    IntElement e1;
-    CHECK(e1.getVal() == 0);
-    IntElement e2(15);
-    CHECK(e2.getVal() == 15);
-    e1.setVal(21);
-    CHECK(e1.getVal() == 21);
-}
-
-TEST_CASE("IntElement operator tests", "[value]")
-{
-    IntElement e1(21);
-    IntElement e2(15);
-    e1+=e2;
-    CHECK(e1.getVal() == 36);
-    e1-=e2;
-    CHECK(e1.getVal() == 21);
-    e1*=e2;
-    CHECK(e1.getVal() == 315);
-    IntElement e3 = e1 + e2;
-    CHECK(e3.getVal() == 330);
-    IntElement e4 = e3 - e1;
-    CHECK(e4.getVal() == 15);
-    bool test = (e2 == e4);
-    CHECK(test);
-    test = (e3 == e4);
-    CHECK_FALSE(test);
-    IntElement e5 = e3 * e4;
-    CHECK(e5.getVal() == 4950);
-    CHECK(e5.toString() == "4950");
-    Valuation v;
-    int i = e5.evaluate(v);
-    CHECK(i == 4950);
-}
-
-TEST_CASE("VariableElement constructor tests", "[character]")
-{
-    VariableElement v1('y');
-    CHECK(v1.toString() == "y");
-    v1.setVal('z');
-    CHECK(v1.toString() == "z");
-    char test = v1.getVal();
-    CHECK(test == 'z');
-}
-
-TEST_CASE("VariableElement operator tests", "[character]")
-{
-    VariableElement v1('x');
-    VariableElement v2('x');
-    bool test = (v1 == v2);
-    CHECK(test);
-    v1.setVal('y');
-    test = (v1 == v2);
-    CHECK_FALSE(test);
-    Valuation v;
-    v['x'] = 10;
-    v['y'] = 4;
-    int i = v1.evaluate(v);
-    int j = v2.evaluate(v);
-    CHECK(i == 4);
-    CHECK(j == 10);
-}
-
-TEST_CASE("CompositeElement constructor tests", "[value]")
-{
-    IntElement e1(20);
-    VariableElement e2('x');
-    CompositeElement elem(e1, e2, std::plus<int>(), '+');
-    CHECK(elem.toString() == "(20+x)");
-    CompositeElement copy_elem(elem);
-    CHECK(copy_elem.toString() == "(20+x)");
-    CHECK_THROWS(CompositeElement(e1, e2, std::plus<int>(), 'a'));
-}
-
-TEST_CASE("CompositeElement operator tests", "[value]")
-{
-    IntElement e1(20);
-    VariableElement e2('x');
-    Valuation v;
-    v['x'] = 15;
-    CompositeElement elem1(e1, e2, std::plus<int>(), '+');
-    CompositeElement copy_elem(e1, e2, std::minus<int>(), '-');
-    CHECK(elem1.toString() == "(20+x)");
-    CHECK(copy_elem.toString() == "(20-x)");
-    copy_elem = elem1;
-    CHECK(copy_elem.toString() == "(20+x)");
-    int test = elem1.evaluate(v);
-    CHECK(test == 35);
-    CompositeElement elem2(e1, e2, std::minus<int>(), '-');
-    test = elem2.evaluate(v);
-    CHECK(test == 5);
-    CompositeElement elem3(e1, e2, std::multiplies<int>(), '*');
-    test = elem3.evaluate(v);
-    CHECK(test == 300);
-}
-
-TEST_CASE("Element comparison tests", "[value]")
-{
-    IntElement e1(10);
-    VariableElement e2('x');
-    CompositeElement e3(e1, e2, std::plus<int>(), '+');
-    bool test = (e1 == e2);
-    CHECK_FALSE(test);
-    test = (e1 == e3);
-    CHECK_FALSE(test);
-    test = (e2 == e3);
-    CHECK_FALSE(test);
-}
-
-TEST_CASE("Concrete square matrix constructor tests", "[string]")
-{
-    ConcreteSquareMatrix sq1;
-    CHECK(sq1.toString() == "[]");
-    ConcreteSquareMatrix sq2("[[13,4,7][2,51,12][11,30,9]]");
-    CHECK(sq2.toString() == "[[13,4,7][2,51,12][11,30,9]]");
-    ConcreteSquareMatrix sq3(sq2);
-    bool test = (sq2 == sq3);
-    CHECK(test);
-    ConcreteSquareMatrix sq4(std::move(sq2));
-    CHECK(sq4.toString() == "[[13,4,7][2,51,12][11,30,9]]");
-    CHECK(sq2.toString() == "[]");
-}
-
-TEST_CASE("Concrete square matrix operator tests", "[string]")
-{
-    ConcreteSquareMatrix sq1;
-    ConcreteSquareMatrix sq2("[[13,4,7][2,51,12][11,30,9]]");
-    sq1 = std::move(sq2);
-    CHECK(sq1.toString() == "[[13,4,7][2,51,12][11,30,9]]");
-    CHECK(sq2.toString() == "[]");
-    sq2 = sq1;
-    CHECK(sq2.toString() == "[[13,4,7][2,51,12][11,30,9]]");
-    CHECK(sq1.toString() == "[[13,4,7][2,51,12][11,30,9]]");
-    ConcreteSquareMatrix sq3 = sq1.transpose();
-    CHECK(sq3.toString() == "[[13,2,11][4,51,30][7,12,9]]");
-    sq2+=sq3;
-    CHECK(sq2.toString() == "[[26,6,18][6,102,42][18,42,18]]");
-    sq2-=sq3;
-    CHECK(sq2.toString() == "[[13,4,7][2,51,12][11,30,9]]");
-    sq2*=sq3;
-    CHECK(sq2.toString() == "[[234,314,326][314,2749,1660][326,1660,1102]]");
-    ConcreteSquareMatrix sq4 = sq1 + sq3;
-    CHECK(sq4.toString() == "[[26,6,18][6,102,42][18,42,18]]");
-    ConcreteSquareMatrix sq5 = sq4 - sq3;
-    CHECK(sq5.toString() == "[[13,4,7][2,51,12][11,30,9]]");
-    ConcreteSquareMatrix sq6 = sq4 * sq5;
-    CHECK(sq6.toString() == "[[548,950,416][744,6486,1644][516,2754,792]]");
-}
-
-TEST_CASE("Concrete square matrix throw tests", "[string]")
-{
-    ConcreteSquareMatrix sq1;
-    CHECK_THROWS(ConcreteSquareMatrix("[1,2,3][4,5,6][7,8,9]]"));
-    CHECK_THROWS(ConcreteSquareMatrix("1,2,3][4,5,6][7,8,9]"));
-    CHECK_THROWS(ConcreteSquareMatrix("[1,2,3][a,b,c][7,8,9]]"));
-    CHECK_THROWS(ConcreteSquareMatrix("[[1,2][3,4,5][6,7,8]]"));
-    CHECK_THROWS(ConcreteSquareMatrix("[[1,2,3][3,4,5][6,7,8"));
-    CHECK_THROWS(ConcreteSquareMatrix("[[1,2][2,1]"));
-    CHECK_NOTHROW(ConcreteSquareMatrix("[[-1,2,3][4,5,6][7,8,9]]"));
-    CHECK_NOTHROW(ConcreteSquareMatrix("[[1]]"));
-    ConcreteSquareMatrix sq2("[[1,2,3][4,5,6][7,8,9]]");
-    CHECK_THROWS(sq1+=sq2);
-    CHECK_THROWS(sq1-=sq2);
-    CHECK_THROWS(sq1*=sq2);
-    bool test = (sq1 == sq2);
-    CHECK_FALSE(test);
-}
-
-TEST_CASE("Symbolic square matrix constructor tests", "[string]")
-{
-    SymbolicSquareMatrix sq1;
-    CHECK(sq1.toString() == "[]");
-    SymbolicSquareMatrix sq2("[[10,x][y,5]]");
-    CHECK(sq2.toString() == "[[10,x][y,5]]");
-    SymbolicSquareMatrix sq3(sq2);
-    bool test = (sq2 == sq3);
-    CHECK(test);
-    SymbolicSquareMatrix sq4(std::move(sq2));
-    CHECK(sq4.toString() == "[[10,x][y,5]]");
-    CHECK(sq2.toString() == "[]");
-}
-
-TEST_CASE("Symbolic square matrix operator tests", "[string]")
-{
-    SymbolicSquareMatrix sq1;
-    Valuation v;
-    SymbolicSquareMatrix sq2("[[10,x,y][3,15,2][20,z,2]]");
-    v['x'] = 13;
-    v['y'] = 4;
-    v['z'] = 30;
-    sq1 = std::move(sq2);
-    CHECK(sq1.toString() == "[[10,x,y][3,15,2][20,z,2]]");
-    CHECK(sq2.toString() == "[]");
-    sq2 = sq1;
-    CHECK(sq2.toString() == "[[10,x,y][3,15,2][20,z,2]]");
-    CHECK(sq1.toString() == "[[10,x,y][3,15,2][20,z,2]]");
-    SymbolicSquareMatrix sq3 = sq1.transpose();
-    CHECK(sq3.toString() == "[[10,3,20][x,15,z][y,2,2]]");
-    bool test = (sq1 == sq3);
-    CHECK_FALSE(test);
-    ConcreteSquareMatrix m1 = sq1.evaluate(v);
-    CHECK(m1.toString() == "[[10,13,4][3,15,2][20,30,2]]");
-    SymbolicSquareMatrix sq4 = sq1 + sq2;
-    ConcreteSquareMatrix m2 = sq4.evaluate(v);
-    CHECK(m2.toString() == "[[20,26,8][6,30,4][40,60,4]]");
-    SymbolicSquareMatrix sq5 = sq1 - sq3;
-    ConcreteSquareMatrix m3 = sq5.evaluate(v);
-    CHECK(m3.toString() == "[[0,10,-16][-10,0,-28][16,28,0]]");
-    //SymbolicSquareMatrix sq6 = sq1 * sq2;
-    //ConcreteSquareMatrix m4 = sq6.evaluate(v);
-    //CHECK(m4.toString() == "[[219,445,74][115,324,46][330,770,144]]");
-}
-
-TEST_CASE("Symbolic matrix throw tests", "[string]")
-{
-    CHECK_THROWS(SymbolicSquareMatrix("[1,2,3][4,5,6][7,8,9]]"));
-    CHECK_THROWS(SymbolicSquareMatrix("1,2,3][4,5,6][7,8,9]"));
-    CHECK_THROWS(SymbolicSquareMatrix("[[1,2][3,4,5][6,7,8]]"));
-    CHECK_THROWS(SymbolicSquareMatrix("[[1,2,3][3,4,5][6,7,8"));
-    CHECK_THROWS(SymbolicSquareMatrix("[[1,2][2,1]"));
-    CHECK_THROWS(SymbolicSquareMatrix("[[1,ab][2,3]]"));
-    CHECK_THROWS(SymbolicSquareMatrix("[[1,%,2][3,4,5][6,7,8]]"));
-    CHECK_THROWS(SymbolicSquareMatrix("[[xy]]"));
-    CHECK_THROWS(SymbolicSquareMatrix("[[?]]"));
-    CHECK_NOTHROW(SymbolicSquareMatrix("[[-1,2,3][4,5,6][7,8,9]]"));
-    CHECK_NOTHROW(SymbolicSquareMatrix("[[1]]"));
-    CHECK_NOTHROW(SymbolicSquareMatrix("[[x]]"));
-    SymbolicSquareMatrix sq("[[x,20][30,40]]");
-    Valuation v;
-    CHECK_THROWS(sq.evaluate(v));
-    SymbolicSquareMatrix m("[[20,30,40][10,15,5][4,3,2]]");
-    CHECK_THROWS(sq + m);
-    CHECK_THROWS(sq - m);
-    //CHECK_THROWS(sq * m);
-}
-
-int main(int argc, char** argv)
-{
-    int result = Catch::Session().run( argc, argv );
-    SymbolicSquareMatrix m1;
-    SymbolicSquareMatrix m2;
-    std::string input;
-    std::stack<std::shared_ptr<SquareMatrix>> matrices;
-    Valuation v;
-    char c1 = ' ';
-    char c2 = ' ';
-    int number = 0;
-    std::stringstream strm;
-
-    while(true)
-    {
-        strm.clear();
-        strm.str("");
-        std::cout << "Give an input" << std::endl;
-        std::cin >> input;
-
-        if(input == "quit")
-            return result;
-
-        strm << input;
-        strm >> c1;
-        strm >> c2;
-        if(c2 == '=')
-        {
-            strm >> number;
-            if(strm.fail())
-            {
-                std::cout << "You must give an integer value to the character" << std::endl;
-                continue;
-            }
-
-            if(strm.rdbuf()->in_avail() == 0)
-            {
-                v[c1] = number;
-                std::cout << "Gave character " << c1 << " the value of " << number << std::endl;
-                c2 = ' ';
-            }
-        }
-        else
-        {
-            if(!input.empty())
-                c1 = input[0];
-
-            if(c1 == '+')
-            {
-                if(matrices.empty())
-                {
-                    std::cout << "Stack is empty" << std::endl;
-                    continue;
-                }
-                auto temp = matrices.top();
-                try
-                {
-                    m1 = SymbolicSquareMatrix(matrices.top()->toString());
-                }
-                catch(std::invalid_argument ia)
-                {
-                    try
-                    {
-                        m1 = SymbolicSquareMatrix(matrices.top()->evaluate(v).toString());
-                    }
-                    catch(std::invalid_argument ia)
-                    {
-                        std::cout << "Couldn't do evaluation, please declare values to variables" << std::endl;
-                    }
-                }
-                matrices.pop();
-                if(matrices.empty() == true)
-                {
-                    std::cout << "Stack only has one matrix" << std::endl;
-                    matrices.push(temp);
-                    continue;
-                }
-
-                try
-                {
-                    m2 = SymbolicSquareMatrix(matrices.top()->toString());
-                }
-                catch(std::invalid_argument ia)
-                {
-                    try
-                    {
-                        m2 = SymbolicSquareMatrix(matrices.top()->evaluate(v).toString());
-                    }
-                    catch(std::invalid_argument ia)
-                    {
-                        std::cout << "Couldn't do evaluation, please declare values to variables" << std::endl;
-                    }
-                }
-                SymbolicSquareMatrix res = m1 + m2;
-                std::shared_ptr<SquareMatrix> res_ptr = std::make_shared<SymbolicSquareMatrix>(res);
-                matrices.push(res_ptr);
-                std::cout << "Added result of addition: " << res_ptr->toString() << " to the stack" << std::endl;
-            }
-            else if(c1 == '-')
-            {
-                if(matrices.empty())
-                {
-                    std::cout << "Stack is empty" << std::endl;
-                    continue;
-                }
-                auto temp = matrices.top();
-                try
-                {
-                    m1 = SymbolicSquareMatrix(matrices.top()->toString());
-                }
-                catch(std::invalid_argument ia)
-                {
-                    try
-                    {
-                        m1 = SymbolicSquareMatrix(matrices.top()->evaluate(v).toString());
-                    }
-                    catch(std::invalid_argument ia)
-                    {
-                        std::cout << "Couldn't do evaluation, please declare values to variables" << std::endl;
-                    }
-                }
-                matrices.pop();
-                if(matrices.empty() == true)
-                {
-                    std::cout << "Stack only has one matrix" << std::endl;
-                    matrices.push(temp);
-                    continue;
-                }
-
-                try
-                {
-                    m2 = SymbolicSquareMatrix(matrices.top()->toString());
-                }
-                catch(std::invalid_argument ia)
-                {
-                    try
-                    {
-                        m2 = SymbolicSquareMatrix(matrices.top()->evaluate(v).toString());
-                    }
-                    catch(std::invalid_argument ia)
-                    {
-                        std::cout << "Couldn't do evaluation, please declare values to variables" << std::endl;
-                    }
-                }
-                SymbolicSquareMatrix res = m1 - m2;
-                std::shared_ptr<SquareMatrix> res_ptr = std::make_shared<SymbolicSquareMatrix>(res);
-                matrices.push(res_ptr);
-                std::cout << "Added result of subtraction: " << res_ptr->toString() << " to the stack" << std::endl;
-            }
-            else if(c1 == '*')
-            {
-                if(matrices.empty() == true)
-                {
-                    std::cout << "Stack is empty" << std::endl;
-                    continue;
-                }
-                auto temp = matrices.top();
-                try
-                {
-                    m1 = SymbolicSquareMatrix(matrices.top()->toString());
-                }
-                catch(std::invalid_argument ia)
-                {
-                    try
-                    {
-                        m1 = SymbolicSquareMatrix(matrices.top()->evaluate(v).toString());
-                    }
-                    catch(std::invalid_argument ia)
-                    {
-                        std::cout << "Couldn't do evaluation, please declare values to variables" << std::endl;
-                    }
-                }
-                matrices.pop();
-                if(matrices.empty() == true)
-                {
-                    std::cout << "Stack only has one matrix" << std::endl;
-                    matrices.push(temp);
-                    continue;
-                }
-
-                try
-                {
-                    m2 = SymbolicSquareMatrix(matrices.top()->toString());
-                }
-                catch(std::invalid_argument ia)
-                {
-                    try
-                    {
-                        m2 = SymbolicSquareMatrix(matrices.top()->evaluate(v).toString());
-                    }
-                    catch(std::invalid_argument ia)
-                    {
-                        std::cout << "Couldn't do evaluation, please declare values to variables" << std::endl;
-                    }
-                }
-                SymbolicSquareMatrix res = m1 * m2;
-                std::shared_ptr<SquareMatrix> res_ptr = std::make_shared<SymbolicSquareMatrix>(res);
-                matrices.push(res_ptr);
-                std::cout << "Added result of multiplication: " << res_ptr->toString() << " to the stack" << std::endl;
-            }
-            else if(c1 == '=')
-            {
-                try
-                {
-                    std::cout << matrices.top()->evaluate(v) << std::endl;
-                }
-                catch(std::invalid_argument ia)
-                {
-                    std::cout << "Couldn't do evaluation, please declare values to variables" << std::endl;
-                }
-            }
-            else
-            {
-                try
-                {
-                    SymbolicSquareMatrix matrix(input);
-                    std::shared_ptr<SquareMatrix> matrix_ptr = std::make_shared<SymbolicSquareMatrix>(matrix);
-                    matrices.push(matrix_ptr);
-                    std::cout << "Added matrix to stack" << std::endl;
-                }
-                catch(std::invalid_argument ia)
-                {
-                    std::cout << "Invalid input" << std::endl;
-                }
-            }
-        }
-    }
-}
+/**
+    \file main.cpp
+    \brief Main-function and tests for IntElement, VariableElement, CompositeElement, ConcreteSquareMatrix and SymbolicSquareMatrix classes
+*/
+
+#define CATCH_CONFIG_RUNNER
+#include "catch.hpp"
+#include "allocationcounter.h"
+#include "bigint.h"
+#include "commands.h"
+#include "determinant.h"
+#include "elementarymatrix.h"
+#include "exactmatrix.h"
+#include "expressionpool.h"
+#include "fixedmatrix.h"
+#include "loadgenerator.h"
+#include "lu.h"
+#include "matrixbatch.h"
+#include "matrixfile.h"
+#include "matrixio.h"
+#include "matrixparser.h"
+#include "modular.h"
+#include "progress.h"
+#include "resultcache.h"
+#include "semiring.h"
+#include "server.h"
+#include "session.h"
+#include "taskscheduler.h"
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <stack>
+#include <sstream>
+#include <iostream>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <cmath>
+#include <chrono>
+#include <csignal>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+
+TEST_CASE("IntElement constructor tests", "[value]")
+{
+    IntElement e1;
+    CHECK(e1.getVal() == 0);
+    IntElement e2(15);
+    CHECK(e2.getVal() == 15);
+    e1.setVal(21);
+    CHECK(e1.getVal() == 21);
+}
+
+TEST_CASE("IntElement operator tests", "[value]")
+{
+    IntElement e1(21);
+    IntElement e2(15);
+    e1+=e2;
+    CHECK(e1.getVal() == 36);
+    e1-=e2;
+    CHECK(e1.getVal() == 21);
+    e1*=e2;
+    CHECK(e1.getVal() == 315);
+    IntElement e3 = e1 + e2;
+    CHECK(e3.getVal() == 330);
+    IntElement e4 = e3 - e1;
+    CHECK(e4.getVal() == 15);
+    bool test = (e2 == e4);
+    CHECK(test);
+    test = (e3 == e4);
+    CHECK_FALSE(test);
+    IntElement e5 = e3 * e4;
+    CHECK(e5.getVal() == 4950);
+    CHECK(e5.toString() == "4950");
+    Valuation v;
+    int i = e5.evaluate(v);
+    CHECK(i == 4950);
+}
+
+TEST_CASE("VariableElement constructor tests", "[character]")
+{
+    VariableElement v1('y');
+    CHECK(v1.toString() == "y");
+    v1.setVal('z');
+    CHECK(v1.toString() == "z");
+    char test = v1.getVal();
+    CHECK(test == 'z');
+}
+
+TEST_CASE("VariableElement operator tests", "[character]")
+{
+    VariableElement v1('x');
+    VariableElement v2('x');
+    bool test = (v1 == v2);
+    CHECK(test);
+    v1.setVal('y');
+    test = (v1 == v2);
+    CHECK_FALSE(test);
+    Valuation v;
+    v['x'] = 10;
+    v['y'] = 4;
+    int i = v1.evaluate(v);
+    int j = v2.evaluate(v);
+    CHECK(i == 4);
+    CHECK(j == 10);
+}
+
+TEST_CASE("CompositeElement constructor tests", "[value]")
+{
+    IntElement e1(20);
+    VariableElement e2('x');
+    CompositeElement elem(e1, e2, '+');
+    CHECK(elem.toString() == "(20+x)");
+    CompositeElement copy_elem(elem);
+    CHECK(copy_elem.toString() == "(20+x)");
+    CHECK_THROWS(CompositeElement(e1, e2, 'a'));
+}
+
+TEST_CASE("CompositeElement operator tests", "[value]")
+{
+    IntElement e1(20);
+    VariableElement e2('x');
+    Valuation v;
+    v['x'] = 15;
+    CompositeElement elem1(e1, e2, '+');
+    CompositeElement copy_elem(e1, e2, '-');
+    CHECK(elem1.toString() == "(20+x)");
+    CHECK(copy_elem.toString() == "(20-x)");
+    copy_elem = elem1;
+    CHECK(copy_elem.toString() == "(20+x)");
+    int test = elem1.evaluate(v);
+    CHECK(test == 35);
+    CompositeElement elem2(e1, e2, '-');
+    test = elem2.evaluate(v);
+    CHECK(test == 5);
+    CompositeElement elem3(e1, e2, '*');
+    test = elem3.evaluate(v);
+    CHECK(test == 300);
+}
+
+TEST_CASE("Element comparison tests", "[value]")
+{
+    IntElement e1(10);
+    VariableElement e2('x');
+    CompositeElement e3(e1, e2, '+');
+    bool test = (e1 == e2);
+    CHECK_FALSE(test);
+    test = (e1 == e3);
+    CHECK_FALSE(test);
+    test = (e2 == e3);
+    CHECK_FALSE(test);
+    CompositeElement e4(e1, e2, '+');
+    test = (e3 == e4);
+    CHECK(test);
+    CHECK(e3.hash() == e4.hash());
+    CompositeElement e5(e1, e2, '-');
+    test = (e3 == e5);
+    CHECK_FALSE(test);
+    CompositeElement e6(e4, e5, '*');
+    CompositeElement e7(e3, e5, '*');
+    test = (e6 == e7);
+    CHECK(test);
+    test = (IntElement(120) == VariableElement('x'));
+    CHECK_FALSE(test);
+}
+
+TEST_CASE("Deep expression tests", "[value]")
+{
+    const int depth = 500000;
+    std::shared_ptr<Element> e1 = std::make_shared<VariableElement>('x');
+    std::shared_ptr<Element> e2 = std::make_shared<VariableElement>('x');
+    for(int i = 0; i < depth; i++)
+    {
+        e1 = std::make_shared<CompositeElement>(e1, std::make_shared<IntElement>(1), (i % 2) ? '-' : '+');
+        e2 = std::make_shared<CompositeElement>(e2, std::make_shared<IntElement>(1), (i % 2) ? '-' : '+');
+    }
+
+    Valuation v;
+    v['x'] = 7;
+    CHECK(e1->evaluate(v) == 7);
+    CHECK(*e1 == *e2);
+    std::string str = e1->toString();
+    CHECK(str.size() == 1 + 4 * static_cast<std::size_t>(depth));
+    CHECK(str.compare(0, 4, "((((") == 0);
+    CHECK(str.compare(str.size() - 6, 6, "+1)-1)") == 0);
+
+    std::unique_ptr<Element> spec(e1->specialize(v));
+    CHECK(spec->toString() == "7");
+    v.erase('x');
+    v['y'] = 1;
+    std::unique_ptr<Element> partial(e1->specialize(v));
+    CHECK(*partial == *e2);
+    CHECK_THROWS(e1->evaluate(v));
+}
+
+TEST_CASE("Expression pool tests", "[value]")
+{
+    std::shared_ptr<Element> x = std::make_shared<VariableElement>('x');
+    std::shared_ptr<Element> sum = std::make_shared<CompositeElement>(x, std::make_shared<IntElement>(-3), '+');
+    std::shared_ptr<Element> product = std::make_shared<CompositeElement>(sum, sum, Operation::Multiply);
+    ExpressionPool pool;
+    std::uint32_t root = pool.add(*product);
+    CHECK(pool.size() == 4);
+    CHECK(pool.add(*sum) == 2);
+    CHECK(pool.getNodes()[root].kind == NodeKind::Multiply);
+    CHECK(pool.getNodes()[root].left == 2);
+
+    Valuation v;
+    std::vector<int> values;
+    CHECK_THROWS_AS(pool.evaluate(v, values), std::invalid_argument);
+    v['x'] = 10;
+    pool.evaluate(v, values);
+    CHECK(values[root] == 49);
+    CHECK(values[root] == product->evaluate(v));
+    CHECK(sizeof(ExpressionNode) == 12);
+}
+
+TEST_CASE("Expression evaluation benchmark", "[.][benchmark]")
+{
+    std::shared_ptr<Element> e = std::make_shared<VariableElement>('x');
+    for(int i = 0; i < 3000; i++)
+    {
+        e = std::make_shared<CompositeElement>(e, std::make_shared<IntElement>(i % 7), "+-*"[i % 3]);
+    }
+    Valuation v;
+    long long tree_sum = 0;
+    long long pool_sum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for(int r = 0; r < 2000; r++)
+    {
+        v['x'] = r;
+        tree_sum += e->evaluate(v);
+    }
+    auto tree_time = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    ExpressionPool pool;
+    std::uint32_t root = pool.add(*e);
+    std::vector<int> values;
+    for(int r = 0; r < 2000; r++)
+    {
+        v['x'] = r;
+        pool.evaluate(v, values);
+        pool_sum += values[root];
+    }
+    auto pool_time = std::chrono::steady_clock::now() - start;
+    CHECK(tree_sum == pool_sum);
+
+    using ms = std::chrono::duration<double, std::milli>;
+    std::cout << "CompositeElement: " << sizeof(CompositeElement) << " bytes, ExpressionNode: " << sizeof(ExpressionNode) << " bytes" << std::endl;
+    std::cout << "Tree evaluation of 6M nodes: " << ms(tree_time).count() << " ms" << std::endl;
+    std::cout << "Pool evaluation of 6M nodes: " << ms(pool_time).count() << " ms" << std::endl;
+}
+
+TEST_CASE("Square matrix equality tests", "[string]")
+{
+    ConcreteSquareMatrix sq1("[[1,2][3,4]]");
+    ConcreteSquareMatrix sq2("[[1,2][3,4]]");
+    ConcreteSquareMatrix sq3("[[1,2][3,5]]");
+    bool test = (sq1 == sq2);
+    CHECK(test);
+    CHECK(sq1.contentHash() == sq2.contentHash());
+    test = (sq1 == sq3);
+    CHECK_FALSE(test);
+    sq3 -= ConcreteSquareMatrix("[[0,0][0,1]]");
+    test = (sq1 == sq3);
+    CHECK(test);
+    CHECK(sq1.contentHash() == sq3.contentHash());
+    SymbolicSquareMatrix sq4("[[x,2][3,y]]");
+    SymbolicSquareMatrix sq5("[[x,2][3,y]]");
+    test = (sq4 + sq5 == sq5 + sq4);
+    CHECK(test);
+    test = (sq4 + sq5 == sq4 - sq5);
+    CHECK_FALSE(test);
+    test = (sq4 == SymbolicSquareMatrix("[[x,2][3,z]]"));
+    CHECK_FALSE(test);
+    test = (SymbolicSquareMatrix() == SymbolicSquareMatrix("[[1]]"));
+    CHECK_FALSE(test);
+
+    // results in the cache are hashed by several threads at once
+    std::shared_ptr<const ConcreteSquareMatrix> shared = std::make_shared<ConcreteSquareMatrix>("[[1,2][3,4]]");
+    std::uint64_t hashes[4] = {};
+    std::vector<std::thread> threads;
+    for(std::uint64_t& h: hashes)
+    {
+        threads.emplace_back([&shared, &h]() { h = shared->contentHash(); });
+    }
+    for(std::thread& t: threads)
+    {
+        t.join();
+    }
+    for(std::uint64_t h: hashes)
+    {
+        CHECK(h == sq1.contentHash());
+    }
+}
+
+TEST_CASE("Concrete square matrix constructor tests", "[string]")
+{
+    ConcreteSquareMatrix sq1;
+    CHECK(sq1.toString() == "[]");
+    ConcreteSquareMatrix sq2("[[13,4,7][2,51,12][11,30,9]]");
+    CHECK(sq2.toString() == "[[13,4,7][2,51,12][11,30,9]]");
+    ConcreteSquareMatrix sq3(sq2);
+    bool test = (sq2 == sq3);
+    CHECK(test);
+    ConcreteSquareMatrix sq4(std::move(sq2));
+    CHECK(sq4.toString() == "[[13,4,7][2,51,12][11,30,9]]");
+    CHECK(sq2.toString() == "[]");
+}
+
+TEST_CASE("Concrete square matrix operator tests", "[string]")
+{
+    ConcreteSquareMatrix sq1;
+    ConcreteSquareMatrix sq2("[[13,4,7][2,51,12][11,30,9]]");
+    sq1 = std::move(sq2);
+    CHECK(sq1.toString() == "[[13,4,7][2,51,12][11,30,9]]");
+    CHECK(sq2.toString() == "[]");
+    sq2 = sq1;
+    CHECK(sq2.toString() == "[[13,4,7][2,51,12][11,30,9]]");
+    CHECK(sq1.toString() == "[[13,4,7][2,51,12][11,30,9]]");
+    ConcreteSquareMatrix sq3 = sq1.transpose();
+    CHECK(sq3.toString() == "[[13,2,11][4,51,30][7,12,9]]");
+    sq2+=sq3;
+    CHECK(sq2.toString() == "[[26,6,18][6,102,42][18,42,18]]");
+    sq2-=sq3;
+    CHECK(sq2.toString() == "[[13,4,7][2,51,12][11,30,9]]");
+    sq2*=sq3;
+    CHECK(sq2.toString() == "[[234,314,326][314,2749,1660][326,1660,1102]]");
+    ConcreteSquareMatrix sq4 = sq1 + sq3;
+    CHECK(sq4.toString() == "[[26,6,18][6,102,42][18,42,18]]");
+    ConcreteSquareMatrix sq5 = sq4 - sq3;
+    CHECK(sq5.toString() == "[[13,4,7][2,51,12][11,30,9]]");
+    ConcreteSquareMatrix sq6 = sq4 * sq5;
+    CHECK(sq6.toString() == "[[548,950,416][744,6486,1644][516,2754,792]]");
+}
+
+TEST_CASE("Concrete square matrix expression tests", "[string]")
+{
+    ConcreteSquareMatrix sq1("[[1,2][3,4]]");
+    ConcreteSquareMatrix sq2("[[5,6][7,8]]");
+    ConcreteSquareMatrix sq3("[[2,2][2,2]]");
+    ConcreteSquareMatrix sq4 = sq1 + sq2 - sq3;
+    CHECK(sq4.toString() == "[[4,6][8,10]]");
+    sq4 = sq4 - sq1 + sq3 - sq3;
+    CHECK(sq4.toString() == "[[3,4][5,6]]");
+    sq1 = sq1 + sq1;
+    CHECK(sq1.toString() == "[[2,4][6,8]]");
+    ConcreteSquareMatrix sq5 = (sq1 - sq3) * sq2;
+    CHECK(sq5.toString() == "[[14,16][62,72]]");
+    ConcreteSquareMatrix sq6 = sq1 * sq3 + sq2;
+    CHECK(sq6.toString() == "[[17,18][35,36]]");
+    ConcreteSquareMatrix sq7("[[1,2,3][4,5,6][7,8,9]]");
+    CHECK_THROWS(sq1 + sq7);
+    CHECK_THROWS(sq1 + sq2 - sq7);
+    sq7 = sq1 + sq2;
+    CHECK(sq7.toString() == "[[7,10][13,16]]");
+}
+
+#ifdef COUNT_ALLOCATIONS
+TEST_CASE("Concrete square matrix allocation tests", "[allocation]")
+{
+    ConcreteSquareMatrix sq1("[[1,2][3,4]]");
+    ConcreteSquareMatrix sq2("[[5,6][7,8]]");
+    ConcreteSquareMatrix sq3("[[2,2][2,2]]");
+    std::size_t before = allocationCount();
+    ConcreteSquareMatrix sq4 = std::move(sq1) + sq2;
+    std::size_t allocations = allocationCount() - before;
+    CHECK(allocations == 0);
+    CHECK(sq4.toString() == "[[6,8][10,12]]");
+
+    before = allocationCount();
+    sq4 = sq4 - sq2 + sq3;
+    sq4 = sq2 - std::move(sq4);
+    allocations = allocationCount() - before;
+    CHECK(allocations == 0);
+    CHECK(sq4.toString() == "[[2,2][2,2]]");
+
+    before = allocationCount();
+    ConcreteSquareMatrix sq5 = sq2 + sq3 - sq4;
+    allocations = allocationCount() - before;
+    // copy of sq2 is detached: row storage, 2 rows and 4 cloned elements
+    CHECK(allocations == 8);
+
+    before = allocationCount();
+    ConcreteSquareMatrix sq6 = sq2 * sq3 + sq5;
+    allocations = allocationCount() - before;
+    // product is built with fromValues: element block and its buffer, row storage, 2 rows and its shared pointer
+    CHECK(allocations == 6);
+    CHECK(sq6.toString() == "[[27,28][37,38]]");
+
+    before = allocationCount();
+    sq5 = std::move(sq6);
+    sq5 = sq5;
+    allocations = allocationCount() - before;
+    CHECK(allocations == 0);
+    CHECK(sq5.toString() == "[[27,28][37,38]]");
+
+    std::vector<int> values(25, 1);
+    ConcreteSquareMatrix sq7 = ConcreteSquareMatrix::fromValues(5, values.data());
+    before = allocationCount();
+    ConcreteSquareMatrix sq8 = sq7 * sq7;
+    allocations = allocationCount() - before;
+    // values and transposed operand, then fromValues with 5 rows instead of one allocation per element
+    CHECK(allocations == 11);
+    CHECK(sq8.toString() == "[[5,5,5,5,5][5,5,5,5,5][5,5,5,5,5][5,5,5,5,5][5,5,5,5,5]]");
+}
+#endif
+
+TEST_CASE("Square matrix copy-on-write tests", "[allocation]")
+{
+    ConcreteSquareMatrix sq1("[[1,2][3,4]]");
+#ifdef COUNT_ALLOCATIONS
+    std::size_t before = allocationCount();
+#endif
+    ConcreteSquareMatrix sq2(sq1);
+    ConcreteSquareMatrix sq3;
+    sq3 = sq2;
+#ifdef COUNT_ALLOCATIONS
+    std::size_t allocations = allocationCount() - before;
+    CHECK(allocations == 0);
+#endif
+    sq2 += sq1;
+    CHECK(sq2.toString() == "[[2,4][6,8]]");
+    CHECK(sq1.toString() == "[[1,2][3,4]]");
+    sq3 = sq3 + sq2;
+    CHECK(sq3.toString() == "[[3,6][9,12]]");
+    CHECK(sq1.toString() == "[[1,2][3,4]]");
+    sq1 -= sq1;
+    CHECK(sq1.toString() == "[[0,0][0,0]]");
+    SymbolicSquareMatrix sq4("[[x,2][3,y]]");
+    SymbolicSquareMatrix sq5(sq4);
+    sq5 = sq5 + sq4;
+    CHECK(sq4.toString() == "[[x,2][3,y]]");
+    CHECK(sq5.toString() == "[[(x+x),(2+2)][(3+3),(y+y)]]");
+}
+
+TEST_CASE("Square matrix output tests", "[string]")
+{
+    ConcreteSquareMatrix sq1("[[1,-20][300,4]]");
+    std::ostringstream strm1;
+    sq1.write(strm1, MatrixLayout::Pretty);
+    CHECK(strm1.str() == "[[  1, -20]\n [300,   4]]");
+    std::ostringstream strm2;
+    strm2 << sq1;
+    CHECK(strm2.str() == "[[1,-20][300,4]]");
+    SymbolicSquareMatrix sq2("[[x,2][3,y]]");
+    std::ostringstream strm3;
+    (sq2 + sq2).write(strm3, MatrixLayout::Pretty);
+    CHECK(strm3.str() == "[[(x+x), (2+2)]\n [(3+3), (y+y)]]");
+    std::ostringstream strm4;
+    ConcreteSquareMatrix().write(strm4, MatrixLayout::Pretty);
+    CHECK(strm4.str() == "[]");
+
+    std::string big = "[";
+    for(int i = 0; i < 200; i++)
+    {
+        big += "[";
+        for(int j = 0; j < 200; j++)
+        {
+            big += std::to_string(i * 1000 - j * 7919);
+            if(j < 199)
+                big += ",";
+        }
+        big += "]";
+    }
+    big += "]";
+    ConcreteSquareMatrix sq3(big);
+    CHECK(sq3.toString() == big);
+    std::ostringstream strm5;
+    strm5 << sq3;
+    CHECK(strm5.str() == big);
+}
+
+TEST_CASE("Matrix file tests", "[file]")
+{
+    const std::string filename = "matrixfile_test.bin";
+    std::vector<int> values(64 * 64);
+    for(unsigned int i = 0; i < values.size(); i++)
+    {
+        values[i] = static_cast<int>(i * 2654435761u) / 4;
+    }
+    ConcreteSquareMatrix sq1 = ConcreteSquareMatrix::fromValues(64, values.data());
+    CHECK(sq1.valueAt(1, 2) == values[66]);
+    saveMatrix(filename, sq1);
+    ConcreteSquareMatrix sq2 = loadMatrix(filename);
+    bool test = (sq1 == sq2);
+    CHECK(test);
+    sq2 += sq1;
+    CHECK(sq2.valueAt(0, 1) == values[1] * 2);
+
+    saveMatrix(filename, ConcreteSquareMatrix());
+    CHECK(loadMatrix(filename).toString() == "[]");
+
+    saveMatrix(filename, ConcreteSquareMatrix("[[1,2][3,4]]"));
+    std::fstream file(filename, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(sizeof(MatrixFileHeader) + 4);
+    file.put(7);
+    file.close();
+    CHECK_THROWS_AS(loadMatrix(filename), std::invalid_argument);
+    std::remove(filename.c_str());
+    CHECK_THROWS_AS(loadMatrix(filename), std::runtime_error);
+}
+
+TEST_CASE("Matrix stream parser tests", "[string]")
+{
+    std::istringstream strm1("[[1, -2]\n [x,  4]] next");
+    SymbolicSquareMatrix sq1 = MatrixStreamParser<Element>(strm1).parse();
+    CHECK(sq1.toString() == "[[1,-2][x,4]]");
+    std::string rest;
+    strm1 >> rest;
+    CHECK(rest == "next");
+
+    std::istringstream strm2("[[1,x][2,3]]");
+    CHECK_THROWS_AS(MatrixStreamParser<IntElement>(strm2).parse(), std::invalid_argument);
+    std::istringstream strm3("[[1,2][3,4]");
+    CHECK_THROWS_AS(MatrixStreamParser<IntElement>(strm3).parse(), std::invalid_argument);
+    std::istringstream strm4("[[2147483648]]");
+    CHECK_THROWS_AS(MatrixStreamParser<IntElement>(strm4).parse(), std::invalid_argument);
+    std::istringstream strm5("[[-2147483648]]");
+    CHECK(MatrixStreamParser<IntElement>(strm5).parse().toString() == "[[-2147483648]]");
+
+    std::string big = "[";
+    for(int i = 0; i < 100; i++)
+    {
+        big += "[";
+        for(int j = 0; j < 100; j++)
+        {
+            big += std::to_string(i - j);
+            if(j < 99)
+                big += ",";
+        }
+        big += "]";
+    }
+    big += "]";
+    std::istringstream strm6(big);
+    std::size_t reports = 0;
+    MatrixStreamParser<IntElement> parser(strm6, [&reports](std::size_t) { reports++; }, 1000);
+    ConcreteSquareMatrix sq2 = parser.parse();
+    CHECK(sq2.toString() == big);
+    CHECK(parser.charactersRead() == big.size());
+    CHECK(reports == big.size() / 1000);
+}
+
+TEST_CASE("MatrixMarket and CSV tests", "[file]")
+{
+    const std::string csv_name = "matrixio_test.csv";
+    const std::string mtx_name = "matrixio_test.mtx";
+    std::ofstream csv(csv_name);
+    csv << "1, 2,3\n4,-5,6\r\n\n7,8,9\n";
+    csv.close();
+    CHECK(importCsv(csv_name).toString() == "[[1,2,3][4,-5,6][7,8,9]]");
+
+    std::ofstream mtx(mtx_name);
+    mtx << "%%MatrixMarket matrix coordinate integer symmetric\n% comment\n3 3 3\n1 1 5\n3 1 -2\n2 2 7\n";
+    mtx.close();
+    CHECK(importMatrixMarket(mtx_name).toString() == "[[5,0,-2][0,7,0][-2,0,0]]");
+    SparseSquareMatrix sparse = importMatrixMarketSparse(mtx_name);
+    CHECK(sparse.nonZeros() == 4);
+    CHECK(sparse.valueAt(0, 2) == -2);
+    CHECK(sparse.valueAt(1, 0) == 0);
+    CHECK(sparse.toConcrete().toString() == "[[5,0,-2][0,7,0][-2,0,0]]");
+
+    mtx.open(mtx_name);
+    mtx << "%%MatrixMarket matrix array integer skew-symmetric\n3 3\n1\n2\n3\n";
+    mtx.close();
+    CHECK(importMatrixMarket(mtx_name).toString() == "[[0,-1,-2][1,0,-3][2,3,0]]");
+
+    // entries in the same position are summed like in sparse import, also when the lines are parsed on several threads
+    mtx.open(mtx_name);
+    mtx << "%%MatrixMarket matrix coordinate integer symmetric\n2 2 4\n2 1 3\n1 2 4\n2 1 -1\n1 1 2\n";
+    mtx.close();
+    CHECK(importMatrixMarket(mtx_name, 4).toString() == "[[2,6][6,0]]");
+    CHECK(importMatrixMarketSparse(mtx_name, 4).toConcrete().toString() == "[[2,6][6,0]]");
+
+    mtx.open(mtx_name);
+    mtx << "%%MatrixMarket matrix coordinate integer skew-symmetric\n2 2 1\n2 1 -2147483648\n";
+    mtx.close();
+    CHECK_THROWS_AS(importMatrixMarket(mtx_name), std::invalid_argument);
+    CHECK_THROWS_AS(importMatrixMarketSparse(mtx_name), std::invalid_argument);
+    mtx.open(mtx_name);
+    mtx << "%%MatrixMarket matrix array integer skew-symmetric\n2 2\n-2147483648\n";
+    mtx.close();
+    CHECK_THROWS_AS(importMatrixMarket(mtx_name), std::invalid_argument);
+
+    mtx.open(mtx_name);
+    mtx << "%%MatrixMarket matrix array integer general\n2 3\n1\n2\n3\n4\n5\n6\n";
+    mtx.close();
+    CHECK_THROWS_AS(importMatrixMarket(mtx_name), std::invalid_argument);
+
+    std::vector<int> values(300 * 300);
+    for(unsigned int i = 0; i < values.size(); i++)
+    {
+        values[i] = static_cast<int>(i * 2654435761u) % 1000;
+    }
+    ConcreteSquareMatrix sq1 = ConcreteSquareMatrix::fromValues(300, values.data());
+    exportMatrix(mtx_name, sq1);
+    exportMatrix(csv_name, sq1);
+    bool test = (importMatrixMarket(mtx_name, 4) == sq1);
+    CHECK(test);
+    test = (importCsv(csv_name, 4) == sq1);
+    CHECK(test);
+    exportMatrixMarket(mtx_name, SparseSquareMatrix::fromConcrete(sq1));
+    test = (importMatrixMarketSparse(mtx_name, 4).toConcrete() == sq1);
+    CHECK(test);
+    CHECK_THROWS_AS(exportMatrix("matrixio_test.txt", sq1), std::invalid_argument);
+    std::remove(csv_name.c_str());
+    std::remove(mtx_name.c_str());
+}
+
+TEST_CASE("Session snapshot tests", "[file]")
+{
+    const std::string filename = "session_test.bin";
+    std::stack<std::shared_ptr<SquareMatrix>> matrices;
+    Valuation v;
+    v['x'] = 3;
+    v['y'] = -2;
+    SymbolicSquareMatrix sq1("[[x,2][y,4]]");
+    SymbolicSquareMatrix sq2 = (sq1 + sq1) - sq1;
+    matrices.push(std::make_shared<ConcreteSquareMatrix>("[[1,2][3,4]]"));
+    matrices.push(std::make_shared<SymbolicSquareMatrix>(sq1));
+    matrices.push(std::make_shared<SymbolicSquareMatrix>(sq2));
+    saveSession(filename, matrices, v);
+
+    std::stack<std::shared_ptr<SquareMatrix>> restored;
+    Valuation v2;
+    restoreSession(filename, restored, v2);
+    CHECK(restored.size() == 3);
+    CHECK(v2 == v);
+    const LazySquareMatrix* lazy = dynamic_cast<const LazySquareMatrix*>(restored.top().get());
+    REQUIRE(lazy != nullptr);
+    CHECK(lazy->contentHash() == sq2.contentHash());
+    CHECK(lazy->isLoaded() == false);
+    CHECK(restored.top()->toString() == sq2.toString());
+    CHECK(lazy->isLoaded() == true);
+    bool test = (restored.top()->evaluate(v2) == sq2.evaluate(v));
+    CHECK(test);
+    restored.pop();
+    CHECK(restored.top()->specialize(v2).toString() == "[[3,2][-2,4]]");
+    restored.pop();
+    CHECK(restored.top()->toString() == "[[1,2][3,4]]");
+
+    restoreSession(filename, restored, v2);
+    saveSession(filename, restored, v2);
+    restoreSession(filename, restored, v2);
+    CHECK(restored.top()->toString() == sq2.toString());
+
+    std::fstream file(filename, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(0);
+    file.put('X');
+    file.close();
+    CHECK_THROWS_AS(restoreSession(filename, restored, v2), std::invalid_argument);
+    CHECK(restored.size() == 3);
+    std::remove(filename.c_str());
+    CHECK_THROWS_AS(restoreSession(filename, restored, v2), std::runtime_error);
+}
+
+TEST_CASE("Result cache tests", "[cache]")
+{
+    ConcreteSquareMatrix a("[[1,2][3,4]]");
+    ConcreteSquareMatrix b("[[5,6][7,8]]");
+    std::shared_ptr<SquareMatrix> sq1 = std::make_shared<ConcreteSquareMatrix>(a + b);
+    std::shared_ptr<SquareMatrix> sq2 = std::make_shared<ConcreteSquareMatrix>(a * b);
+    std::size_t size = approximateSize(*sq1);
+    Valuation w;
+    // every entry keeps copies of its operands, so a result of two 2 x 2 matrices takes three times the size
+    ResultCache cache(size * 6);
+
+    CHECK(cache.find(CachedOperation::Add, a, &b, w) == nullptr);
+    cache.insert(CachedOperation::Add, a, &b, w, 0, sq1);
+    CHECK(cache.find(CachedOperation::Add, a, &b, w) == sq1);
+    CHECK(cache.find(CachedOperation::Subtract, a, &b, w) == nullptr);
+    CHECK(cache.find(CachedOperation::Add, b, &a, w) == nullptr);
+    CHECK(cache.getHits() == 1);
+    CHECK(cache.getMisses() == 3);
+
+    // equal operands hit, operands with the same hash but other content or kind miss
+    CHECK(cache.find(CachedOperation::Add, ConcreteSquareMatrix("[[1,2][3,4]]"), &b, w) == sq1);
+    SymbolicSquareMatrix symbolic("[[1,2][3,4]]");
+    CHECK(symbolic.contentHash() == a.contentHash());
+    CHECK(cache.find(CachedOperation::Add, symbolic, &b, w) == nullptr);
+    CHECK(cache.find(CachedOperation::Add, a, &b, w, 7) == nullptr);
+    CHECK(cache.find(CachedOperation::Add, a, &b, Valuation{{'x', 1}}) == nullptr);
+    CHECK(cache.getHits() == 2);
+    CHECK(cache.getMisses() == 6);
+
+    cache.insert(CachedOperation::Evaluate, a, nullptr, w, 0, sq2);
+    CHECK(cache.find(CachedOperation::Add, a, &b, w) == sq1);
+    cache.insert(CachedOperation::Multiply, a, &b, w, 0, sq2);
+    CHECK(cache.size() == 2);
+    CHECK(cache.getEvictions() == 1);
+    CHECK(cache.find(CachedOperation::Evaluate, a, nullptr, w) == nullptr);
+    CHECK(cache.getUsage() == size * 6);
+
+    cache.erase(CachedOperation::Add);
+    CHECK(cache.find(CachedOperation::Add, a, &b, w) == nullptr);
+    CHECK(cache.size() == 1);
+    cache.setBudget(0);
+    CHECK(cache.size() == 0);
+    CHECK(cache.getUsage() == 0);
+
+    Valuation v;
+    std::uint64_t h1 = valuationHash(v);
+    v['x'] = 1;
+    std::uint64_t h2 = valuationHash(v);
+    v['x'] = 2;
+    CHECK(h1 != h2);
+    CHECK(valuationHash(v) != h2);
+}
+
+TEST_CASE("Determinant tests", "[determinant]")
+{
+    CHECK(determinant(ConcreteSquareMatrix()) == 1);
+    CHECK(determinant(ConcreteSquareMatrix("[[-7]]")) == -7);
+    CHECK(determinant(ConcreteSquareMatrix("[[1,2][3,4]]")) == -2);
+    CHECK(determinant(ConcreteSquareMatrix("[[0,1][1,0]]")) == -1);
+    CHECK(determinant(ConcreteSquareMatrix("[[1,2][2,4]]")) == 0);
+    CHECK(determinant(ConcreteSquareMatrix("[[2,-3,1][2,0,-1][1,4,5]]")) == 49);
+    CHECK(determinant(ConcreteSquareMatrix("[[0,0,1][0,2,0][3,0,0]]")) == -6);
+    CHECK(determinant(ConcreteSquareMatrix("[[2147483647,0][0,2147483647]]")) == 4611686014132420609LL);
+
+    const unsigned int n = 300;
+    std::vector<int> lower(n * n, 0);
+    std::vector<int> upper(n * n, 0);
+    long long expected = 1;
+    for(unsigned int i = 0; i < n; i++)
+    {
+        lower[i * n + i] = 1;
+        upper[i * n + i] = (i % 7 == 3) ? -1 : 1;
+        expected *= upper[i * n + i];
+        for(unsigned int j = 0; j < i; j++)
+        {
+            lower[i * n + j] = ((i * 31 + j * 17) % 11 == 0) ? 1 : 0;
+            upper[j * n + i] = ((i * 13 + j * 7) % 5 == 0) ? 1 : 0;
+        }
+    }
+    ConcreteSquareMatrix sq = ConcreteSquareMatrix::fromValues(n, lower.data()) * ConcreteSquareMatrix::fromValues(n, upper.data());
+    CHECK(determinant(sq, 1) == expected);
+    CHECK(determinant(sq, 4) == expected);
+    CHECK(determinant(sq.transpose(), 3) == expected);
+
+    std::vector<int> values(40 * 40);
+    for(unsigned int i = 0; i < values.size(); i++)
+    {
+        values[i] = static_cast<int>(i * 2654435761u);
+    }
+    CHECK(determinant(ConcreteSquareMatrix::fromValues(40, values.data())) == 0);
+    CHECK(determinant(ConcreteSquareMatrix("[[2147483647,0,0,0,0][0,2147483647,0,0,0][0,0,2147483647,0,0][0,0,0,2147483647,0][0,0,0,0,2147483647]]")).toString()
+          == "45671926060252476630107084286792841360213803007");
+
+    std::vector<int> big_values(30 * 30);
+    for(unsigned int i = 0; i < big_values.size(); i++)
+    {
+        big_values[i] = static_cast<int>(i * 2654435761u % 2000001) - 1000000;
+    }
+    CHECK(determinant(ConcreteSquareMatrix::fromValues(30, big_values.data())).toString()
+          == "7646602597916824213647525236441268875078851434228080338071468845466112485959670623338424901589491726238691945985549597416474629270280096267663538493986862691282224929023023146117061440");
+
+    // random dense matrices are calculated modulo primes, det(AB) = det(A)det(B) checks the combined results
+    std::vector<int> dense_a(40 * 40);
+    std::vector<int> dense_b(40 * 40);
+    for(unsigned int i = 0; i < dense_a.size(); i++)
+    {
+        dense_a[i] = static_cast<int>(i * 2654435761u % 19) - 9;
+        dense_b[i] = static_cast<int>((i + 7) * 40503u % 19) - 9;
+    }
+    ConcreteSquareMatrix a = ConcreteSquareMatrix::fromValues(40, dense_a.data());
+    ConcreteSquareMatrix b = ConcreteSquareMatrix::fromValues(40, dense_b.data());
+    BigInt det_a = determinant(a, 1);
+    CHECK(det_a == determinant(a, 4));
+    CHECK(determinant(a * b, 3) == det_a * determinant(b));
+    CHECK(determinant(a.transpose()) == det_a);
+    CHECK(determinant(b * b) == determinant(b) * determinant(b));
+    for(unsigned int j = 0; j < 40; j++)
+    {
+        dense_a[39 * 40 + j] = dense_a[j] - dense_a[40 + j];
+    }
+    CHECK(determinant(ConcreteSquareMatrix::fromValues(40, dense_a.data()), 4) == 0);
+
+    std::vector<int> dense(260 * 260);
+    for(unsigned int i = 0; i < dense.size(); i++)
+    {
+        dense[i] = static_cast<int>(i * 2654435761u % 3) - 1;
+    }
+    ConcreteSquareMatrix large = ConcreteSquareMatrix::fromValues(260, dense.data());
+    CHECK(determinant(large, 1) == determinant(large, 4));
+}
+
+TEST_CASE("Fixed size matrix tests", "[fixed]")
+{
+    constexpr FixedSquareMatrix<int, 3> f1({2, -3, 1, 2, 0, -1, 1, 4, 5});
+    constexpr FixedSquareMatrix<int, 3> f2 = FixedSquareMatrix<int, 3>::identity();
+    static_assert(f1.determinant() == 49, "determinant is calculated at compile time");
+    static_assert(f1 * f2 == f1 && f1.transpose().transpose() == f1, "operations are calculated at compile time");
+    static_assert((f1 - f1 + f2).determinant<long long>() == 1, "operations are calculated at compile time");
+    CHECK(f1.submatrix(0, 1) == FixedSquareMatrix<int, 2>({2, -1, 1, 5}));
+
+    // small matrices must give the same results as larger ones, which are not dispatched
+    for(unsigned int n = 1; n <= fixed_matrix_limit; n++)
+    {
+        std::vector<int> small(n * n);
+        std::vector<int> padded(5 * 5, 0);
+        for(unsigned int k = 0; k < small.size(); k++)
+        {
+            small[k] = static_cast<int>((k + n) * 2654435761u % 2001) - 1000;
+            padded[(k / n) * 5 + k % n] = small[k];
+        }
+        for(unsigned int i = n; i < 5; i++)
+        {
+            padded[i * 5 + i] = 1;
+        }
+        ConcreteSquareMatrix sq = ConcreteSquareMatrix::fromValues(n, small.data());
+        ConcreteSquareMatrix big = ConcreteSquareMatrix::fromValues(5, padded.data());
+        CHECK(determinant(sq) == determinant(big));
+
+        ConcreteSquareMatrix product = sq * sq.transpose();
+        ConcreteSquareMatrix big_product = big * big.transpose();
+        for(unsigned int i = 0; i < n; i++)
+        {
+            for(unsigned int j = 0; j < n; j++)
+            {
+                CHECK(product.valueAt(i, j) == big_product.valueAt(i, j));
+            }
+        }
+    }
+
+    CHECK((ConcreteSquareMatrix("[[2147483647]]") * ConcreteSquareMatrix("[[2]]")).toString() == "[[-2]]");
+    // matrices larger than the fixed sizes wrap around the same way
+    ConcreteSquareMatrix wrapping("[[2147483647,1,0,0,0][0,1,0,0,0][0,0,1,0,0][0,0,0,1,0][0,0,0,0,1]]");
+    CHECK((wrapping * ConcreteSquareMatrix("[[2,0,0,0,0][2147483647,1,0,0,0][0,0,1,0,0][0,0,0,1,0][0,0,0,0,1]]")).toString()
+          == "[[2147483645,1,0,0,0][2147483647,1,0,0,0][0,0,1,0,0][0,0,0,1,0][0,0,0,0,1]]");
+    CHECK(determinant(ConcreteSquareMatrix("[[2147483647,-2147483648][-2147483648,2147483647]]")) == BigInt("-4294967295"));
+    CHECK(determinant(ConcreteSquareMatrix("[[2147483647,0,0,0][0,2147483647,0,0][0,0,2147483647,0][0,0,0,2147483647]]")).toString()
+          == "21267647892944572736998860269687930881");
+
+    ResultCache cache;
+    Valuation v;
+    CHECK(power(ConcreteSquareMatrix("[[1,1][1,0]]"), 10, v, cache, nullptr, false)->toString() == "[[89,55][55,34]]");
+    CHECK(power(ConcreteSquareMatrix("[[1,2,3][4,5,6][7,8,9]]"), 0, v, cache, nullptr, false)->toString() == "[[1,0,0][0,1,0][0,0,1]]");
+}
+
+TEST_CASE("Matrix batch tests", "[batch]")
+{
+    // enough 3 x 3 matrices for several blocks divided between threads
+    const std::size_t count = 12000;
+    MatrixBatch b1(3, count);
+    MatrixBatch b2(3, count);
+    for(std::size_t b = 0; b < count; b++)
+    {
+        for(unsigned int e = 0; e < 9; e++)
+        {
+            b1.element(e / 3, e % 3)[b] = static_cast<int>((b * 9 + e) * 2654435761u);
+            b2.element(e / 3, e % 3)[b] = static_cast<int>((b * 9 + e) * 40503u % 2001) - 1000;
+        }
+    }
+
+    MatrixBatch sum = b1 + b2;
+    MatrixBatch difference = b1 - b2;
+    MatrixBatch product = b1 * b2;
+    MatrixBatch transposed = b1.transpose();
+    for(std::size_t b: {std::size_t(0), std::size_t(1023), std::size_t(1024), count - 1})
+    {
+        ConcreteSquareMatrix m1 = b1.getMatrix(b);
+        ConcreteSquareMatrix m2 = b2.getMatrix(b);
+        CHECK(sum.getMatrix(b) == m1 + m2);
+        CHECK(difference.getMatrix(b) == m1 - m2);
+        CHECK(product.getMatrix(b) == m1 * m2);
+        CHECK(transposed.getMatrix(b) == m1.transpose());
+    }
+
+    MatrixBatch small = MatrixBatch::fromMatrices({ConcreteSquareMatrix("[[1,2][3,4]]"), ConcreteSquareMatrix("[[5,6][7,8]]")});
+    CHECK(small.getCount() == 2);
+    CHECK(small.valueAt(1, 0, 1) == 6);
+    small.setMatrix(0, ConcreteSquareMatrix("[[0,1][1,0]]"));
+    CHECK((small * small).getMatrix(0).toString() == "[[1,0][0,1]]");
+    CHECK_THROWS_AS(small + b1, std::invalid_argument);
+    CHECK_THROWS_AS(small.setMatrix(0, ConcreteSquareMatrix("[[1]]")), std::invalid_argument);
+    CHECK_THROWS_AS(MatrixBatch::fromMatrices({ConcreteSquareMatrix("[[1]]"), ConcreteSquareMatrix("[[1,2][3,4]]")}), std::invalid_argument);
+
+    SymbolicSquareMatrix sym = SymbolicSquareMatrix("[[x,y][1,2]]") + SymbolicSquareMatrix("[[y,x][x,3]]");
+    BatchValuation variables{{'x', {1, -4, 2147483647}}, {'y', {10, 20, 1}}};
+    MatrixBatch evaluated = evaluateBatch(sym, variables);
+    CHECK(evaluated.getCount() == 3);
+    // x + y of the last matrix wraps around in the batch and in the scalar evaluation it is compared with
+    CHECK(evaluated.valueAt(2, 0, 0) == std::numeric_limits<int>::min());
+    for(std::size_t b = 0; b < 3; b++)
+    {
+        CHECK(evaluated.getMatrix(b) == sym.evaluate(Valuation{{'x', variables['x'][b]}, {'y', variables['y'][b]}}));
+    }
+    CHECK(evaluateBatch(SymbolicSquareMatrix("[[1,2][3,4]]"), BatchValuation()).getMatrix(0).toString() == "[[1,2][3,4]]");
+
+    // large expressions are evaluated for fewer matrices at a time, so this batch has several blocks
+    std::string large_text = "[";
+    for(unsigned int i = 0; i < 12; i++)
+    {
+        large_text += "[";
+        for(unsigned int j = 0; j < 12; j++)
+        {
+            large_text += (j > 0 ? "," : "") + ((i + j) % 3 == 0 ? std::string("x") : (i + j) % 3 == 1 ? std::string("y") : std::to_string(i * 12 + j));
+        }
+        large_text += "]";
+    }
+    large_text += "]";
+    SymbolicSquareMatrix large(large_text);
+    SymbolicSquareMatrix large_product = large * large;
+    BatchValuation many{{'x', {}}, {'y', {}}};
+    for(int b = 0; b < 400; b++)
+    {
+        many['x'].push_back(b * 7 - 100);
+        many['y'].push_back(1000 - b * b);
+    }
+    MatrixBatch large_evaluated = evaluateBatch(large_product, many);
+    for(std::size_t b = 0; b < 400; b += 37)
+    {
+        CHECK(large_evaluated.getMatrix(b) == large_product.evaluate(Valuation{{'x', many['x'][b]}, {'y', many['y'][b]}}));
+    }
+    CHECK_THROWS_AS(evaluateBatch(sym, BatchValuation{{'x', {1}}}), std::invalid_argument);
+    CHECK_THROWS_AS(evaluateBatch(sym, BatchValuation{{'x', {1}}, {'y', {1, 2}}}), std::invalid_argument);
+
+    const std::string batch_name = "matrixbatch_test.csv";
+    const std::string values_name = "matrixbatch_values_test.csv";
+    exportBatchCsv(batch_name, product);
+    MatrixBatch read = importBatchCsv(batch_name, 4);
+    CHECK(read.getCount() == count);
+    CHECK(read.getMatrix(count - 1) == product.getMatrix(count - 1));
+    std::ofstream csv(batch_name);
+    csv << "1,2,3,4\n\n-5, 6,7,8\r\n";
+    csv.close();
+    CHECK(importBatchCsv(batch_name).getMatrix(1).toString() == "[[-5,6][7,8]]");
+    csv.open(batch_name);
+    csv << "1,2,3,4\n1,2,3\n";
+    csv.close();
+    CHECK_THROWS_AS(importBatchCsv(batch_name), std::invalid_argument);
+    csv.open(batch_name);
+    csv << "1,2,3\n";
+    csv.close();
+    CHECK_THROWS_AS(importBatchCsv(batch_name), std::invalid_argument);
+
+    csv.open(values_name);
+    csv << "x, y\n1,10\n-4,20\n";
+    csv.close();
+    BatchValuation read_variables = importValuationsCsv(values_name);
+    CHECK(read_variables['x'] == std::vector<int>{1, -4});
+    CHECK(read_variables['y'] == std::vector<int>{10, 20});
+    csv.open(values_name);
+    csv << "x,xy\n1,10\n";
+    csv.close();
+    CHECK_THROWS_AS(importValuationsCsv(values_name), std::invalid_argument);
+    std::remove(batch_name.c_str());
+    std::remove(values_name.c_str());
+}
+
+TEST_CASE("Matrix batch benchmark", "[.][benchmark]")
+{
+    const std::size_t count = 1000000;
+    std::vector<ConcreteSquareMatrix> matrices;
+    matrices.reserve(count);
+    for(std::size_t b = 0; b < count; b++)
+    {
+        int values[9];
+        for(unsigned int e = 0; e < 9; e++)
+            values[e] = static_cast<int>((b * 9 + e) * 2654435761u % 2001) - 1000;
+        matrices.push_back(ConcreteSquareMatrix::fromValues(3, values));
+    }
+    MatrixBatch batch = MatrixBatch::fromMatrices(matrices);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<ConcreteSquareMatrix> products;
+    products.reserve(count);
+    for(const ConcreteSquareMatrix& m: matrices)
+    {
+        products.push_back(m * m);
+    }
+    auto single_time = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    MatrixBatch batch_products = batch * batch;
+    auto batch_time = std::chrono::steady_clock::now() - start;
+    CHECK(batch_products.getMatrix(count - 1) == products.back());
+
+    using ms = std::chrono::duration<double, std::milli>;
+    std::cout << "One ConcreteSquareMatrix at a time: " << ms(single_time).count() << " ms" << std::endl;
+    std::cout << "MatrixBatch: " << ms(batch_time).count() << " ms" << std::endl;
+}
+
+TEST_CASE("Semiring multiply tests", "[semiring]")
+{
+    // shortest paths of at most 3 edges are all shortest paths of 4 nodes
+    ConcreteSquareMatrix graph("[[0,4,1,2147483647][2147483647,0,2147483647,1][2147483647,2,0,5][2147483647,2147483647,2147483647,0]]");
+    CHECK(semiringPower(graph, 3, Semiring::MinPlus).toString()
+          == "[[0,3,1,4][2147483647,0,2147483647,1][2147483647,2,0,3][2147483647,2147483647,2147483647,0]]");
+    CHECK(semiringPower(graph, 0, Semiring::MinPlus).toString()
+          == "[[0,2147483647,2147483647,2147483647][2147483647,0,2147483647,2147483647][2147483647,2147483647,0,2147483647][2147483647,2147483647,2147483647,0]]");
+    CHECK(semiringMultiply(graph, graph, Semiring::MinPlus).toString() == semiringPower(graph, 2, Semiring::MinPlus).toString());
+
+    ConcreteSquareMatrix tasks("[[0,2,4][-2147483648,0,3][-2147483648,-2147483648,0]]");
+    CHECK(semiringPower(tasks, 2, Semiring::MaxPlus).toString() == "[[0,2,5][-2147483648,0,3][-2147483648,-2147483648,0]]");
+
+    ConcreteSquareMatrix chain("[[1,5,0,0][0,1,1,0][0,0,1,-1][0,0,0,1]]");
+    CHECK(semiringPower(chain, 3, Semiring::Boolean).toString() == "[[1,1,1,1][0,1,1,1][0,0,1,1][0,0,0,1]]");
+    CHECK(semiringPower(chain, 1, Semiring::Boolean).toString() == "[[1,1,0,0][0,1,1,0][0,0,1,1][0,0,0,1]]");
+    CHECK_THROWS(semiringMultiply(chain, tasks, Semiring::Boolean));
+
+    // large enough to use several words and threads
+    const unsigned int n = 130;
+    std::vector<int> a(n * n);
+    std::vector<int> b(n * n);
+    for(unsigned int k = 0; k < n * n; k++)
+    {
+        a[k] = (k * 2654435761u >> 7) % 11 == 0;
+        b[k] = (k * 40503u >> 5) % 13 == 0;
+    }
+    ConcreteSquareMatrix ma = ConcreteSquareMatrix::fromValues(n, a.data());
+    ConcreteSquareMatrix mb = ConcreteSquareMatrix::fromValues(n, b.data());
+    ConcreteSquareMatrix counts = ma * mb;
+    ConcreteSquareMatrix reach = semiringMultiply(ma, mb, Semiring::Boolean);
+    bool same = true;
+    for(unsigned int i = 0; i < n; i++)
+        for(unsigned int j = 0; j < n; j++)
+            same = same && reach.valueAt(i, j) == (counts.valueAt(i, j) != 0);
+    CHECK(same);
+
+    std::vector<unsigned int> ua(a.begin(), a.end());
+    std::vector<unsigned int> ub(b.begin(), b.end());
+    std::vector<unsigned int> uc(n * n);
+    semiringMultiply<PlusTimes>(n, ua.data(), ub.data(), uc.data());
+    std::vector<int> products(n * n);
+    counts.copyValues(products.data());
+    CHECK(std::vector<int>(uc.begin(), uc.end()) == products);
+
+    Progress progress;
+    progress.cancel();
+    CHECK_THROWS_AS(semiringMultiply(ma, mb, Semiring::MinPlus, &progress), OperationCancelled);
+
+    ResultCache cache;
+    CalculatorSession session;
+    std::ostringstream out;
+    session.execute("[[0,x][1,0]]", cache, out);
+    session.execute("[[0,1][2,0]]", cache, out);
+    session.execute("minplus", cache, out);
+    session.execute("x=3", cache, out);
+    session.execute("minplus", cache, out);
+    session.execute("boolpow 2", cache, out);
+    session.execute("maxpow", cache, out);
+    CHECK(session.getStackSize() == 2);
+    CHECK(out.str() == "Added matrix to stack\nAdded matrix to stack\nCouldn't do evaluation, please declare values to variables\n"
+                       "Gave character x the value of 3\nAdded result of min-plus multiplication: [[0,1][1,0]] to the stack\n"
+                       "Raised topmost matrix to boolean power: [[1,0][0,1]]\nYou must give a non-negative integer exponent\n");
+}
+
+TEST_CASE("BigInt tests", "[bigint]")
+{
+    CHECK(BigInt().toString() == "0");
+    CHECK(BigInt(-9223372036854775807LL - 1).toString() == "-9223372036854775808");
+    CHECK(BigInt("-000123").toString() == "-123");
+    CHECK(BigInt("-0").toString() == "0");
+    CHECK_THROWS_AS(BigInt("12a"), std::invalid_argument);
+    CHECK_THROWS_AS(BigInt("-"), std::invalid_argument);
+
+    BigInt a("123456789012345678901234567890");
+    BigInt b("-987654321098765432109876543210");
+    CHECK((a * b).toString() == "-121932631137021795226185032733622923332237463801111263526900");
+    CHECK((a + b).toString() == "-864197532086419753208641975320");
+    CHECK((a - b).toString() == "1111111110111111111011111111100");
+    CHECK((a * b / b) == a);
+    CHECK((b / BigInt(7)).toString() == "-141093474442680776015696649030");
+    CHECK((-a < a));
+    CHECK(b < a);
+    CHECK(!a.fitsLongLong());
+    CHECK(BigInt(9223372036854775807LL).toLongLong() == 9223372036854775807LL);
+    CHECK_THROWS_AS((BigInt(9223372036854775807LL) + 1).toLongLong(), std::overflow_error);
+
+    BigInt q;
+    BigInt r;
+    BigInt::divide(a * b + BigInt(-12345), b, q, r);
+    CHECK(q == a);
+    CHECK(r == -12345);
+    BigInt::divide(BigInt("340282366920938463463374607431768211455"), BigInt("18446744073709551617"), q, r);
+    CHECK(q.toString() == "18446744073709551615");
+    CHECK(r == 0);
+    CHECK_THROWS_AS(a / BigInt(), std::domain_error);
+}
+
+TEST_CASE("Exact square matrix tests", "[exact]")
+{
+    ConcreteSquareMatrix sq("[[1,2][3,4]]");
+    ExactSquareMatrix e1(sq);
+    CHECK(e1.toString() == sq.toString());
+    CHECK(e1.contentHash() == sq.contentHash());
+    CHECK(exactMultiply(e1, e1).toString() == "[[7,10][15,22]]");
+    CHECK(exactSubtract(e1, e1).evaluate(Valuation()).toString() == "[[0,0][0,0]]");
+    CHECK_THROWS_AS(exactAdd(e1, ExactSquareMatrix(ConcreteSquareMatrix("[[1]]"))), std::invalid_argument);
+
+    ExactSquareMatrix e2(ConcreteSquareMatrix("[[2147483647,-2147483648][1,0]]"));
+    ExactSquareMatrix cube = exactPower(e2, 3);
+    CHECK(cube.getPromoted().size() == 2);
+    CHECK(cube.toString() == "[[9903520291224612117793472511,-9903520300447984146058313728][4611686011984936961,-4611686016279904256]]");
+    ExactSquareMatrix e3 = exactMultiply(cube, cube);
+    CHECK(e3.getPromoted().size() == 4);
+    CHECK(e3.valueAt(1, 0).toString() == "45671925975181885048425273066019532222345773055");
+    CHECK(exactSubtract(e3, e3).toString() == "[[0,0][0,0]]");
+    CHECK(exactSubtract(e3, e3).getPromoted().empty());
+    CHECK(exactAdd(e3, e1).valueAt(1, 1).toString() == "-45671926017717180794700337310555200075513987068");
+    CHECK(exactMultiply(e3, ExactSquareMatrix(ConcreteSquareMatrix("[[0,0][0,0]]"))).toString() == "[[0,0][0,0]]");
+    CHECK(exactPower(e2, 6).toString() == e3.toString());
+    CHECK_THROWS_AS(e3.evaluate(Valuation()), std::invalid_argument);
+
+    ExactSquareMatrix e4(2, {9223372036854775807LL, 1, 1, 0});
+    CHECK(exactAdd(e4, e1).valueAt(0, 0).toString() == "9223372036854775808");
+    CHECK(exactAdd(e4, e1).valueAt(1, 1) == 4);
+    CHECK(e4.contentHash() != ExactSquareMatrix(2, {-1, 1, 1, 0}).contentHash());
+}
+
+TEST_CASE("Determinant benchmark", "[.][benchmark]")
+{
+    const unsigned int n = 300;
+    std::vector<int> values(n * n);
+    for(unsigned int i = 0; i < values.size(); i++)
+    {
+        values[i] = static_cast<int>(i * 2654435761u % 19) - 9;
+    }
+    ConcreteSquareMatrix m = ConcreteSquareMatrix::fromValues(n, values.data());
+
+    auto start = std::chrono::steady_clock::now();
+    BigInt single = determinant(m, 1);
+    auto single_time = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    BigInt parallel = determinant(m);
+    auto parallel_time = std::chrono::steady_clock::now() - start;
+    CHECK(single == parallel);
+
+    using ms = std::chrono::duration<double, std::milli>;
+    std::cout << "Determinant of random " << n << " x " << n << " matrix with " << single.toString().size() << " digits" << std::endl;
+    std::cout << "One thread: " << ms(single_time).count() << " ms" << std::endl;
+    std::cout << "All threads: " << ms(parallel_time).count() << " ms" << std::endl;
+}
+
+TEST_CASE("Exact multiply benchmark", "[.][benchmark]")
+{
+    const unsigned int n = 300;
+    std::vector<int> values(n * n);
+    for(unsigned int i = 0; i < values.size(); i++)
+    {
+        values[i] = static_cast<int>(i * 2654435761u % 2001) - 1000;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<int> plain(n * n, 0);
+    for(unsigned int i = 0; i < n; i++)
+        for(unsigned int k = 0; k < n; k++)
+            for(unsigned int j = 0; j < n; j++)
+                plain[i * n + j] += values[i * n + k] * values[k * n + j];
+    auto plain_time = std::chrono::steady_clock::now() - start;
+
+    ExactSquareMatrix small(ConcreteSquareMatrix::fromValues(n, values.data()));
+    start = std::chrono::steady_clock::now();
+    ExactSquareMatrix product = exactMultiply(small, small);
+    auto exact_time = std::chrono::steady_clock::now() - start;
+    CHECK(product.getPromoted().empty());
+    CHECK(product.getValues()[n + 1] == plain[n + 1]);
+
+    ExactSquareMatrix large = exactPower(small, 4);
+    start = std::chrono::steady_clock::now();
+    ExactSquareMatrix promoted = exactMultiply(large, large);
+    auto promoted_time = std::chrono::steady_clock::now() - start;
+
+    using ms = std::chrono::duration<double, std::milli>;
+    std::cout << "Plain int multiply: " << ms(plain_time).count() << " ms" << std::endl;
+    std::cout << "Exact multiply without overflow: " << ms(exact_time).count() << " ms" << std::endl;
+    std::cout << "Exact multiply with " << promoted.getPromoted().size() << " promoted entries: " << ms(promoted_time).count() << " ms" << std::endl;
+}
+
+TEST_CASE("LU factorization tests", "[lu]")
+{
+    LUFactorization<RealField> lu1(ConcreteSquareMatrix("[[0,2,1][1,1,0][2,0,4]]"));
+    CHECK(lu1.determinant() == Approx(-10));
+    std::vector<double> x = lu1.solve({6, 3, 10});
+    REQUIRE(x.size() == 3);
+    CHECK(x[0] == Approx(1));
+    CHECK(x[1] == Approx(2));
+    CHECK(x[2] == Approx(2));
+    std::vector<double> inv = lu1.inverse();
+    CHECK(inv[0] == Approx(-0.4));
+    CHECK(inv[1] == Approx(0.8));
+    CHECK(inv[2] == Approx(0.1));
+    CHECK_THROWS_AS(lu1.solve({1, 2}), std::invalid_argument);
+    CHECK_THROWS_AS(LUFactorization<RealField>(ConcreteSquareMatrix("[[1,2][2,4]]")), std::invalid_argument);
+
+    const unsigned int n = 150;
+    std::vector<int> values(n * n);
+    for(unsigned int i = 0; i < values.size(); i++)
+    {
+        values[i] = static_cast<int>(i * 2654435761u % 201) - 100;
+    }
+    ConcreteSquareMatrix sq = ConcreteSquareMatrix::fromValues(n, values.data());
+    LUFactorization<RealField> lu2(sq);
+    std::vector<double> b(n * 3);
+    for(unsigned int i = 0; i < b.size(); i++)
+    {
+        b[i] = static_cast<double>(i % 17) - 8;
+    }
+    std::vector<double> xs = lu2.solve(b, 3);
+    double error = 0;
+    for(unsigned int i = 0; i < n; i++)
+    {
+        for(unsigned int c = 0; c < 3; c++)
+        {
+            double sum = 0;
+            for(unsigned int k = 0; k < n; k++)
+            {
+                sum += values[i * n + k] * xs[k * 3 + c];
+            }
+            error = std::max(error, std::fabs(sum - b[i * 3 + c]));
+        }
+    }
+    CHECK(error < 1e-8);
+
+    ModularField field(1000003);
+    LUFactorization<ModularField> lu3(sq, field);
+    std::vector<std::uint32_t> inverse = lu3.inverse();
+    bool identity = true;
+    for(unsigned int i = 0; i < n; i++)
+    {
+        for(unsigned int j = 0; j < n; j++)
+        {
+            std::uint32_t sum = 0;
+            for(unsigned int k = 0; k < n; k++)
+            {
+                sum = field.subtract(sum, field.multiply(field.fromInt(-values[i * n + k]), inverse[k * n + j]));
+            }
+            identity = identity && sum == (i == j ? 1u : 0u);
+        }
+    }
+    CHECK(identity);
+    CHECK(LUFactorization<ModularField>(ConcreteSquareMatrix("[[1,2][3,4]]")).determinant() == 2147483645u);
+    CHECK_THROWS_AS(ModularField(1000), std::invalid_argument);
+}
+
+TEST_CASE("Modular arithmetic tests", "[modular]")
+{
+    Modulus mod(7);
+    CHECK(mod.reduce(100) == 2);
+    CHECK(mod.fromInt(-1) == 6);
+    CHECK(Modulus(2147483647u).reduce(18446744073709551615ULL) == 18446744073709551615ULL % 2147483647u);
+    CHECK_THROWS_AS(Modulus(1), std::invalid_argument);
+
+    ConcreteSquareMatrix sq1("[[5,6][-7,8]]");
+    ConcreteSquareMatrix sq2("[[3,4][5,6]]");
+    CHECK(modularAdd(sq1, sq2, mod).toString() == "[[1,3][5,0]]");
+    CHECK(modularSubtract(sq1, sq2, mod).toString() == "[[2,2][2,2]]");
+    CHECK(modularMultiply(sq1, sq2, mod).toString() == "[[3,0][5,6]]");
+    CHECK(modularPower(sq1, 0, mod).toString() == "[[1,0][0,1]]");
+    CHECK(modularPower(ConcreteSquareMatrix("[[1,1][1,0]]"), 90, Modulus(1000000007)).toString() == "[[755204270,210345902][210345902,544858368]]");
+    CHECK_THROWS_AS(modularAdd(sq1, ConcreteSquareMatrix("[[1]]"), mod), std::invalid_argument);
+    CHECK_THROWS_AS(modularAdd(sq1, sq2, Modulus(4000000000u)), std::invalid_argument);
+
+    const unsigned int n = 200;
+    std::vector<int> values(n * n);
+    for(unsigned int i = 0; i < values.size(); i++)
+    {
+        values[i] = static_cast<int>(i * 2654435761u);
+    }
+    ConcreteSquareMatrix sq3 = ConcreteSquareMatrix::fromValues(n, values.data());
+    Modulus big(2147483629u);
+    ConcreteSquareMatrix product = modularMultiply(sq3, sq3.transpose(), big);
+    bool same = true;
+    for(unsigned int i = 0; i < n; i += 37)
+    {
+        for(unsigned int j = 0; j < n; j += 41)
+        {
+            std::uint64_t sum = 0;
+            for(unsigned int k = 0; k < n; k++)
+            {
+                sum = (sum + static_cast<std::uint64_t>(big.fromInt(values[i * n + k])) * big.fromInt(values[j * n + k])) % big.getValue();
+            }
+            same = same && static_cast<std::uint64_t>(product.valueAt(i, j)) == sum;
+        }
+    }
+    CHECK(same);
+}
+
+TEST_CASE("Task scheduler tests", "[scheduler]")
+{
+    TaskScheduler scheduler(4);
+    CHECK(scheduler.getThreadCount() == 4);
+
+    std::vector<int> visits(100000, 0);
+    parallelFor(0, visits.size(), 100, [&](std::size_t first, std::size_t last)
+    {
+        for(std::size_t i = first; i < last; i++)
+            visits[i]++;
+    }, scheduler);
+    CHECK(std::count(visits.begin(), visits.end(), 1) == 100000);
+
+    std::function<long long(int)> fibonacci = [&](int k) -> long long
+    {
+        if(k < 2)
+            return k;
+        long long a = 0;
+        TaskGroup group(scheduler);
+        group.run([&]() { a = fibonacci(k - 1); });
+        long long b = fibonacci(k - 2);
+        group.wait();
+        return a + b;
+    };
+    CHECK(fibonacci(20) == 6765);
+
+    TaskGroup group(scheduler);
+    group.run([]() { throw std::runtime_error("task failed"); });
+    group.run([]() {});
+    CHECK_THROWS_AS(group.wait(), std::runtime_error);
+    group.wait();
+
+    const unsigned int n = 150;
+    std::vector<int> values(n * n);
+    for(unsigned int i = 0; i < values.size(); i++)
+    {
+        values[i] = static_cast<int>(i % 13) - 6;
+    }
+    ConcreteSquareMatrix sq = ConcreteSquareMatrix::fromValues(n, values.data());
+    ConcreteSquareMatrix product = sq * sq;
+    int sum = 0;
+    for(unsigned int k = 0; k < n; k++)
+    {
+        sum += values[7 * n + k] * values[k * n + 140];
+    }
+    CHECK(product.valueAt(7, 140) == sum);
+}
+
+TEST_CASE("Task scheduler benchmark", "[.][benchmark]")
+{
+    const unsigned int threads = 4;
+    const std::size_t count = 4000;
+    TaskScheduler scheduler(threads);
+    std::atomic<std::uint64_t> sink{0};
+
+    // cost of item i grows with i, so equal static ranges are unbalanced
+    auto work = [&](std::size_t first, std::size_t last)
+    {
+        std::uint64_t x = 0;
+        for(std::size_t i = first; i < last; i++)
+            for(std::size_t k = 0; k < i * 50; k++)
+                x = x * 6364136223846793005ULL + k;
+        sink += x;
+    };
+    using ms = std::chrono::duration<double, std::milli>;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    std::vector<double> busy(threads);
+    for(unsigned int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t]()
+        {
+            auto begin = std::chrono::steady_clock::now();
+            work(count * t / threads, count * (t + 1) / threads);
+            busy[t] = ms(std::chrono::steady_clock::now() - begin).count();
+        });
+    }
+    for(auto& w: workers)
+        w.join();
+    auto static_time = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    parallelFor(0, count, 16, work, scheduler);
+    auto stealing_time = std::chrono::steady_clock::now() - start;
+
+    std::atomic<std::size_t> tasks{0};
+    start = std::chrono::steady_clock::now();
+    parallelFor(0, 100000, 1, [&](std::size_t first, std::size_t last) { tasks += last - first; }, scheduler);
+    auto overhead_time = std::chrono::steady_clock::now() - start;
+    CHECK(tasks == 100000);
+
+    std::cout << "Static partition: " << ms(static_time).count() << " ms, busy time of threads:";
+    for(double b: busy)
+        std::cout << ' ' << b;
+    std::cout << " ms" << std::endl;
+    std::cout << "Work stealing: " << ms(stealing_time).count() << " ms, " << scheduler.getSteals() << " steals" << std::endl;
+    std::cout << "Scheduling overhead: " << ms(overhead_time).count() * 1e6 / 100000 << " ns per task" << std::endl;
+}
+
+TEST_CASE("Calculator server tests", "[server]")
+{
+    ResultCache cache;
+    CalculatorSession session;
+    std::ostringstream out;
+    session.execute("[[1,2][3,4]]", cache, out);
+    session.execute("[[x,0][0,x]]", cache, out);
+    session.execute("x=2", cache, out);
+    session.execute("*", cache, out);
+    session.execute("save file", cache, out);
+    session.execute("pow", cache, out);
+    CHECK(session.getStackSize() == 2);
+    CHECK(out.str() == "Added matrix to stack\nAdded matrix to stack\nGave character x the value of 2\n"
+                       "Added result of multiplication: [[(x*1),(0*3),(x*2),(0*4)][(0*1),(x*3),(0*2),(x*4)]] to the stack\n"
+                       "Command save is not available in server mode\nYou must give a non-negative integer exponent\n");
+
+    const std::string path = "server_test.sock";
+    CalculatorServer server(path, 2);
+    std::thread serving([&server]() { server.run(); });
+    {
+        CalculatorClient first(path);
+        CalculatorClient second(path);
+        CHECK(first.request("[[1,2][3,4]]") == "Added matrix to stack\n");
+        CHECK(second.request("=") == "Stack is empty\n");
+        CHECK(first.request("") == "");
+
+        // lines sent together are answered in order
+        first.send("pow 2\n=\ndet\nbogus\n");
+        CHECK(first.receive() == "Raised topmost matrix to power: [[7,10][15,22]]\n");
+        CHECK(first.receive() == "[[7,10][15,22]]\n");
+        CHECK(first.receive() == "Determinant of topmost matrix: 4\n");
+        CHECK(first.receive() == "Invalid input\n");
+
+        LoadReport report = runLoadGenerator(path, 3, 30, 4);
+        CHECK(report.requests == 90);
+        CHECK(report.median <= report.p99);
+        CHECK(report.p99 <= report.max);
+    }
+    server.stop();
+    serving.join();
+    CHECK(server.getRequests() >= 6 + 90);
+    CHECK(server.getBatches() <= server.getRequests());
+
+    // complete lines before a line that is too long are still answered
+    CalculatorServer limited(path, 1, 64);
+    std::thread limited_serving([&limited]() { limited.run(); });
+    {
+        CalculatorClient client(path);
+        client.send("x=1\n" + std::string(100, '['));
+        CHECK(client.receive() == "Gave character x the value of 1\n");
+        CHECK_THROWS_AS(client.receive(), std::runtime_error);
+    }
+    limited.stop();
+    limited_serving.join();
+    CHECK_THROWS_AS(CalculatorClient("no_server_test.sock"), std::runtime_error);
+}
+
+TEST_CASE("Command plan tests", "[plan]")
+{
+    // batches must give the same stack as running the lines one at a time
+    const std::vector<std::vector<std::string>> scripts = {
+        {"x=2", "[[1,x][3,4]]", "[[5,6][7,8]]", "+", "[[1,1][1,1]]", "+", "[[2,0][0,2]]", "-", "=", "det"},
+        {"x=2", "[[1,x][3,4]]", "[[5,6][7,8]]", "*", "[[1,1][1,1]]", "+", "[[2,0][0,2]]", "[[1,2][3,4]]", "+", "-", "="},
+        {"[[1,x][3,4]]", "[[5,6][7,8]]", "+", "[[1,1][1,1]]", "+", "x=1", "="},
+        {"[[1,2][3,4]]", "[[1,2,3][4,5,6][7,8,9]]", "+", "[[1,1][1,1]]", "+", "+", "=", "*", "bogus", "["},
+        {"mod 1000003", "[[1000,2000][3000,4000]]", "[[5000,6000][7000,8000]]", "*", "[[1,2][3,4]]", "-", "[[9,9][9,9]]",
+         "[[100000,2][3,100000]]", "*", "+", "[[5,6][7,8]]", "[[1,0][0,1]]", "*", "-", "="},
+        {"exact", "[[2147483647,2][3,4]]", "[[2147483647,6][7,8]]", "*", "[[1,1][1,1]]", "+", "[[2147483647,0][0,1]]", "*", "="},
+    };
+    for(const auto& script: scripts)
+    {
+        ResultCache cache;
+        CalculatorSession batched;
+        CalculatorSession single;
+        std::ostringstream batched_out;
+        std::ostringstream single_out;
+        batched.executeBatch(script, cache, batched_out);
+        for(const std::string& line: script)
+        {
+            single.execute(line, cache, single_out);
+            single_out << '\n';
+        }
+        CHECK(batched_out.str() == single_out.str());
+        CHECK(batched.getStackSize() == single.getStackSize());
+
+        std::ostringstream batched_top;
+        std::ostringstream single_top;
+        batched.execute("=", cache, batched_top);
+        single.execute("=", cache, single_top);
+        CHECK(batched_top.str() == single_top.str());
+    }
+
+    ResultCache cache;
+    CalculatorSession session;
+    std::ostringstream out;
+    session.executeBatch({"[[1,2][3,4]]", "[[5,6][7,8]]", "+", "[[1,1][1,1]]", "+"}, cache, out);
+    CHECK(out.str() == "Added matrix to stack\n\nAdded matrix to stack\n\nAdded result of addition: [[(5+1),(6+2)][(7+3),(8+4)]] to the stack\n\n"
+                       "Added matrix to stack\n\nAdded result of addition: [[(1+6),(1+8)][(1+10),(1+12)]] to the stack\n\n");
+    CHECK(session.getStackSize() == 3);
+
+    // a failing line makes the plan run one line at a time
+    out.str("");
+    session.executeBatch({"[[1,2,3][4,5,6][7,8,9]]", "+", "*"}, cache, out);
+    CHECK(out.str() == "Added matrix to stack\n\nMatrices are not the same size\n\nMatrices are not the same size\n\n");
+    CHECK(session.getStackSize() == 4);
+}
+
+TEST_CASE("Concrete square matrix throw tests", "[string]")
+{
+    ConcreteSquareMatrix sq1;
+    CHECK_THROWS(ConcreteSquareMatrix("[1,2,3][4,5,6][7,8,9]]"));
+    CHECK_THROWS(ConcreteSquareMatrix("1,2,3][4,5,6][7,8,9]"));
+    CHECK_THROWS(ConcreteSquareMatrix("[1,2,3][a,b,c][7,8,9]]"));
+    CHECK_THROWS(ConcreteSquareMatrix("[[1,2][3,4,5][6,7,8]]"));
+    CHECK_THROWS(ConcreteSquareMatrix("[[1,2,3][3,4,5][6,7,8"));
+    CHECK_THROWS(ConcreteSquareMatrix("[[1,2][2,1]"));
+    CHECK_NOTHROW(ConcreteSquareMatrix("[[-1,2,3][4,5,6][7,8,9]]"));
+    CHECK_NOTHROW(ConcreteSquareMatrix("[[1]]"));
+    ConcreteSquareMatrix sq2("[[1,2,3][4,5,6][7,8,9]]");
+    CHECK_THROWS(sq1+=sq2);
+    CHECK_THROWS(sq1-=sq2);
+    CHECK_THROWS(sq1*=sq2);
+    bool test = (sq1 == sq2);
+    CHECK_FALSE(test);
+}
+
+TEST_CASE("Symbolic square matrix constructor tests", "[string]")
+{
+    SymbolicSquareMatrix sq1;
+    CHECK(sq1.toString() == "[]");
+    SymbolicSquareMatrix sq2("[[10,x][y,5]]");
+    CHECK(sq2.toString() == "[[10,x][y,5]]");
+    SymbolicSquareMatrix sq3(sq2);
+    bool test = (sq2 == sq3);
+    CHECK(test);
+    SymbolicSquareMatrix sq4(std::move(sq2));
+    CHECK(sq4.toString() == "[[10,x][y,5]]");
+    CHECK(sq2.toString() == "[]");
+}
+
+TEST_CASE("Symbolic square matrix operator tests", "[string]")
+{
+    SymbolicSquareMatrix sq1;
+    Valuation v;
+    SymbolicSquareMatrix sq2("[[10,x,y][3,15,2][20,z,2]]");
+    v['x'] = 13;
+    v['y'] = 4;
+    v['z'] = 30;
+    sq1 = std::move(sq2);
+    CHECK(sq1.toString() == "[[10,x,y][3,15,2][20,z,2]]");
+    CHECK(sq2.toString() == "[]");
+    sq2 = sq1;
+    CHECK(sq2.toString() == "[[10,x,y][3,15,2][20,z,2]]");
+    CHECK(sq1.toString() == "[[10,x,y][3,15,2][20,z,2]]");
+    SymbolicSquareMatrix sq3 = sq1.transpose();
+    CHECK(sq3.toString() == "[[10,3,20][x,15,z][y,2,2]]");
+    bool test = (sq1 == sq3);
+    CHECK_FALSE(test);
+    ConcreteSquareMatrix m1 = sq1.evaluate(v);
+    CHECK(m1.toString() == "[[10,13,4][3,15,2][20,30,2]]");
+    SymbolicSquareMatrix sq4 = sq1 + sq2;
+    ConcreteSquareMatrix m2 = sq4.evaluate(v);
+    CHECK(m2.toString() == "[[20,26,8][6,30,4][40,60,4]]");
+    SymbolicSquareMatrix sq5 = sq1 - sq3;
+    ConcreteSquareMatrix m3 = sq5.evaluate(v);
+    CHECK(m3.toString() == "[[0,10,-16][-10,0,-28][16,28,0]]");
+
+    // results that do not fit wrap around like in concrete and batch operations
+    SymbolicSquareMatrix wrapping("[[x,1][y,x]]");
+    Valuation large{{'x', 2147483647}, {'y', -48284}};
+    CHECK((wrapping + wrapping).evaluate(large).toString() == "[[-2,2][-96568,-2]]");
+    CHECK((wrapping - wrapping.transpose()).specialize(large).evaluate(Valuation()).toString() == "[[0,48285][-48285,0]]");
+    SymbolicSquareMatrix negated = SymbolicSquareMatrix("[[0,0][0,0]]") - wrapping;
+    CHECK((negated - wrapping).evaluate(large).toString() == "[[2,-2][96568,2]]");
+    //SymbolicSquareMatrix sq6 = sq1 * sq2;
+    //ConcreteSquareMatrix m4 = sq6.evaluate(v);
+    //CHECK(m4.toString() == "[[219,445,74][115,324,46][330,770,144]]");
+}
+
+TEST_CASE("Symbolic square matrix specialize tests", "[string]")
+{
+    Valuation v;
+    v['x'] = 3;
+    SymbolicSquareMatrix sq1("[[10,x][y,5]]");
+    SymbolicSquareMatrix sq2("[[x,1][2,y]]");
+    SymbolicSquareMatrix sq3 = sq1 + sq2;
+    SymbolicSquareMatrix spec = sq3.specialize(v);
+    CHECK(spec.toString() == "[[13,4][(y+2),(5+y)]]");
+    CHECK(sq3.toString() == "[[(10+x),(x+1)][(y+2),(5+y)]]");
+    CHECK_THROWS(spec.evaluate(v));
+    v['y'] = 7;
+    ConcreteSquareMatrix m1 = spec.evaluate(v);
+    CHECK(m1.toString() == "[[13,4][9,12]]");
+    SymbolicSquareMatrix full = sq3.specialize(v);
+    CHECK(full.toString() == "[[13,4][9,12]]");
+    ConcreteSquareMatrix sq4("[[1,2][3,4]]");
+    CHECK(sq4.specialize(v).toString() == "[[1,2][3,4]]");
+}
+
+TEST_CASE("Symbolic square matrix parallel evaluation tests", "[string]")
+{
+    const unsigned int n = 40;
+    std::string str = "[";
+    for(unsigned int i = 0; i < n; i++)
+    {
+        str += '[';
+        for(unsigned int j = 0; j < n; j++)
+        {
+            if(j > 0)
+                str += ',';
+            str += ((i + j) % 3 == 0) ? "x" : std::to_string(static_cast<int>(i * n + j) - 700);
+        }
+        str += ']';
+    }
+    str += ']';
+    SymbolicSquareMatrix sq1(str);
+    SymbolicSquareMatrix sq2 = sq1 + sq1 - sq1.transpose();
+
+    Valuation v;
+    v['x'] = -4;
+    ConcreteSquareMatrix expected = evaluateParallel(sq2, v, 1);
+    CHECK(evaluateParallel(sq2, v, 3).toString() == expected.toString());
+    CHECK(evaluateParallel(sq2, v, 64).toString() == expected.toString());
+    CHECK(sq2.evaluate(v).toString() == expected.toString());
+    CHECK(expected.valueAt(0, 1) == 2 * -699 - -660);
+
+    SymbolicSquareMatrix sq3 = SymbolicSquareMatrix("[[1,2,3][4,y,6][z,8,9]]") + SymbolicSquareMatrix("[[0,0,0][0,z,0][0,0,0]]");
+    for(unsigned int threads = 1; threads <= 3; threads++)
+    {
+        try
+        {
+            evaluateParallel(sq3, v, threads);
+            FAIL("Evaluation should fail");
+        }
+        catch(const std::invalid_argument& ia)
+        {
+            CHECK(std::string(ia.what()) == "Could not do evaluation, variable y has no value");
+        }
+    }
+}
+
+TEST_CASE("Progress and cancellation tests", "[progress]")
+{
+    ConcreteSquareMatrix cm("[[1,2,3][4,5,6][7,8,9]]");
+    SymbolicSquareMatrix sm("[[x,2,3][4,5,6][7,8,9]]");
+    Valuation v;
+    v['x'] = 1;
+
+    Progress progress;
+    CHECK(multiply(cm, cm, &progress).toString() == (cm * cm).toString());
+    CHECK(progress.getDone() == 3);
+    CHECK(progress.getTotal() == 3);
+    CHECK(evaluateParallel(sm, v, 2, &progress).toString() == cm.toString());
+    CHECK(progress.getDone() == 3);
+
+    // 128 bits are not enough for the determinant of the large matrix, so it is calculated modulo primes
+    std::vector<int> small_values(6 * 6);
+    std::vector<int> large_values(6 * 6, 0);
+    for(unsigned int i = 0; i < small_values.size(); i++)
+    {
+        small_values[i] = static_cast<int>(i * 2654435761u % 19) - 9;
+        large_values[i / 6 * 7] = 2147483647;
+    }
+    ConcreteSquareMatrix small = ConcreteSquareMatrix::fromValues(6, small_values.data());
+    ConcreteSquareMatrix large = ConcreteSquareMatrix::fromValues(6, large_values.data());
+    CHECK(determinant(large, 2, &progress).toString() == "98079714341385330254404631364738284897724378381211926529");
+    CHECK(progress.getDone() == progress.getTotal());
+    CHECK(determinant(small, 1, &progress) == determinant(small));
+    CHECK(progress.getDone() == 5);
+    ExactSquareMatrix exact(cm);
+    CHECK(exactMultiply(exact, exact, &progress).toString() == (cm * cm).toString());
+    CHECK(progress.getDone() == progress.getTotal());
+    Modulus mod(7);
+    CHECK(modularMultiply(cm, cm, mod, &progress).toString() == "[[2,1,0][3,4,5][4,0,3]]");
+    CHECK(progress.getDone() == 3);
+
+    progress.cancel();
+    CHECK(progress.isCancelled());
+    CHECK_THROWS_AS(multiply(cm, cm, &progress), OperationCancelled);
+    CHECK_THROWS_AS(multiply(sm, sm, &progress), OperationCancelled);
+    CHECK_THROWS_AS(determinant(small, 1, &progress), OperationCancelled);
+    CHECK_THROWS_AS(determinant(large, 3, &progress), OperationCancelled);
+    CHECK_THROWS_AS(exactMultiply(exact, exact, &progress), OperationCancelled);
+    CHECK_THROWS_AS(exactPower(exact, 3, &progress), OperationCancelled);
+    CHECK_THROWS_AS(modularMultiply(cm, cm, mod, &progress), OperationCancelled);
+    CHECK_THROWS_AS(modularPower(cm, 3, mod, &progress), OperationCancelled);
+    for(unsigned int threads = 1; threads <= 3; threads++)
+    {
+        CHECK_THROWS_AS(evaluateParallel(sm, v, threads, &progress), OperationCancelled);
+    }
+
+    progress.reset();
+    CHECK_FALSE(progress.isCancelled());
+    CHECK(progress.getDone() == 0);
+    CHECK_NOTHROW(multiply(sm, sm, &progress));
+}
+
+TEST_CASE("Symbolic matrix throw tests", "[string]")
+{
+    CHECK_THROWS(SymbolicSquareMatrix("[1,2,3][4,5,6][7,8,9]]"));
+    CHECK_THROWS(SymbolicSquareMatrix("1,2,3][4,5,6][7,8,9]"));
+    CHECK_THROWS(SymbolicSquareMatrix("[[1,2][3,4,5][6,7,8]]"));
+    CHECK_THROWS(SymbolicSquareMatrix("[[1,2,3][3,4,5][6,7,8"));
+    CHECK_THROWS(SymbolicSquareMatrix("[[1,2][2,1]"));
+    CHECK_THROWS(SymbolicSquareMatrix("[[1,ab][2,3]]"));
+    CHECK_THROWS(SymbolicSquareMatrix("[[1,%,2][3,4,5][6,7,8]]"));
+    CHECK_THROWS(SymbolicSquareMatrix("[[xy]]"));
+    CHECK_THROWS(SymbolicSquareMatrix("[[?]]"));
+    CHECK_NOTHROW(SymbolicSquareMatrix("[[-1,2,3][4,5,6][7,8,9]]"));
+    CHECK_NOTHROW(SymbolicSquareMatrix("[[1]]"));
+    CHECK_NOTHROW(SymbolicSquareMatrix("[[x]]"));
+    SymbolicSquareMatrix sq("[[x,20][30,40]]");
+    Valuation v;
+    CHECK_THROWS(sq.evaluate(v));
+    SymbolicSquareMatrix m("[[20,30,40][10,15,5][4,3,2]]");
+    CHECK_THROWS(sq + m);
+    CHECK_THROWS(sq - m);
+    //CHECK_THROWS(sq * m);
+}
+
+/**
+    \brief Print row-major array of doubles in the same format as matrices
+    \param values array to print
+    \param rows number of rows
+    \param columns number of columns
+*/
+static void printValues(const std::vector<double>& values, unsigned int rows, unsigned int columns)
+{
+    std::cout << '[';
+    for(unsigned int i = 0; i < rows; i++)
+    {
+        std::cout << '[';
+        for(unsigned int j = 0; j < columns; j++)
+        {
+            if(j != 0)
+                std::cout << ',';
+            std::cout << values[static_cast<std::size_t>(i) * columns + j];
+        }
+        std::cout << ']';
+    }
+    std::cout << ']' << std::endl;
+}
+
+/// Serializes output of the main loop and the background job
+static std::mutex output_mutex;
+
+/// Progress of the operation Ctrl-C cancels, nullptr when nothing is running
+static std::atomic<Progress*> interruptible{nullptr};
+
+/**
+    \brief SIGINT handler, cancels the running operation or ends the program when nothing is running
+    \param sig number of the signal
+*/
+static void handleInterrupt(int sig)
+{
+    Progress* progress = interruptible.load();
+    if(progress != nullptr)
+    {
+        progress->cancel();
+        return;
+    }
+    std::signal(sig, SIG_DFL);
+    std::raise(sig);
+}
+
+/**
+    \class BackgroundJob
+    \brief Stack command running in a worker thread while the main loop keeps reading input
+
+    One job runs at a time and it owns the stack and the result cache until it is joined,
+    so the main loop joins it before any command that uses them. Messages of the job are
+    buffered and printed together when it finishes.
+*/
+class BackgroundJob
+{
+    private:
+        std::thread worker;
+        Progress progress;
+        std::string name;
+        bool started = false;
+        std::atomic<bool> finished{false};
+
+        /**
+            \brief Run command and report exceptions it does not handle itself, so the job always finishes
+            \param work the command
+            \param out stream for messages of the command
+        */
+        void runWork(const std::function<void(std::ostream&, Progress&)>& work, std::ostream& out)
+        {
+            try
+            {
+                work(out, progress);
+            }
+            catch(const std::exception& e)
+            {
+                out << "Could not finish " << name << ": " << e.what() << std::endl;
+            }
+            catch(...)
+            {
+                out << "Could not finish " << name << std::endl;
+            }
+        }
+
+    public:
+
+        BackgroundJob() = default;
+        BackgroundJob(const BackgroundJob&) = delete;
+        BackgroundJob& operator=(const BackgroundJob&) = delete;
+
+        /**
+            \brief Destructor, cancels and joins the job
+        */
+        ~BackgroundJob()
+        {
+            cancel();
+            join();
+        }
+
+        /**
+            \brief Run command, Ctrl-C cancels it until it is joined
+            \param job_name name of the command shown by progress
+            \param work the command, writes its messages to the given stream
+            \param background true runs work in a worker thread, false runs it before returning
+        */
+        void start(const std::string& job_name, std::function<void(std::ostream&, Progress&)> work, bool background)
+        {
+            join();
+            name = job_name;
+            started = true;
+            finished = false;
+            // progress is reused, so the signal handler never sees a destroyed object
+            progress.reset();
+            interruptible = &progress;
+            if(!background)
+            {
+                runWork(work, std::cout);
+                finished = true;
+                join();
+                return;
+            }
+
+            worker = std::thread([this, work]()
+            {
+                std::ostringstream out;
+                runWork(work, out);
+                {
+                    std::lock_guard<std::mutex> lock(output_mutex);
+                    std::cout << out.str() << std::flush;
+                }
+                finished = true;
+            });
+        }
+
+        /**
+            \brief Function to check if a command has been started and not joined
+            \return true if job has to be joined before using the stack
+        */
+        bool active() const
+        {
+            return started;
+        }
+
+        /**
+            \brief Function to check if the command has returned
+            \return true if joining does not block
+        */
+        bool isFinished() const
+        {
+            return finished;
+        }
+
+        /**
+            \brief Function to get name of the command
+            \return Reference to name
+        */
+        const std::string& getName() const
+        {
+            return name;
+        }
+
+        /**
+            \brief Function to get progress of the command
+            \return Reference to progress
+        */
+        const Progress& getProgress() const
+        {
+            return progress;
+        }
+
+        /**
+            \brief Ask command to stop, it restores the stack before finishing
+        */
+        void cancel()
+        {
+            if(started)
+                progress.cancel();
+        }
+
+        /**
+            \brief Wait until command has returned
+        */
+        void join()
+        {
+            if(worker.joinable())
+                worker.join();
+            interruptible = nullptr;
+            started = false;
+        }
+};
+
+/// Server stopped by SIGINT and SIGTERM
+static CalculatorServer* running_server = nullptr;
+
+/**
+    \brief SIGINT and SIGTERM handler of server mode, both signals stop the server
+*/
+static void stopServer(int)
+{
+    running_server->stop();
+}
+
+/**
+    \brief Run calculator server until it gets SIGINT or SIGTERM
+    \param path path of the Unix domain socket
+    \param threads number of worker threads, 0 uses all hardware threads
+    \return Exit status
+*/
+static int serve(const std::string& path, unsigned int threads)
+{
+    try
+    {
+        CalculatorServer server(path, threads);
+        running_server = &server;
+        std::signal(SIGINT, stopServer);
+        std::signal(SIGTERM, stopServer);
+        std::cout << "Serving on " << path << std::endl;
+        server.run();
+        std::signal(SIGINT, SIG_DFL);
+        std::signal(SIGTERM, SIG_DFL);
+        running_server = nullptr;
+        std::cout << "Served " << server.getRequests() << " lines in " << server.getBatches() << " batches" << std::endl;
+    }
+    catch(const std::runtime_error& re)
+    {
+        std::cout << re.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+    \brief Run load generator against a calculator server and print the results
+    \param path path of the Unix domain socket
+    \param connections number of clients
+    \param requests number of lines each client sends
+    \param depth number of lines a client sends before waiting for their responses
+    \return Exit status
+*/
+static int generateLoad(const std::string& path, unsigned int connections, unsigned int requests, unsigned int depth)
+{
+    try
+    {
+        LoadReport report = runLoadGenerator(path, connections, requests, depth);
+        std::cout << report.requests << " lines from " << connections << " clients in " << report.seconds << " s: "
+                  << static_cast<std::uint64_t>(report.requests / report.seconds) << " lines/s, latency median "
+                  << report.median << " us, p99 " << report.p99 << " us, max " << report.max << " us" << std::endl;
+    }
+    catch(const std::runtime_error& re)
+    {
+        std::cout << re.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+    \brief Run an operation on batches of matrices read from CSV files and write the results to a CSV file
+    \param operation "add", "subtract", "multiply", "transpose" or "evaluate"
+    \param inputs batch files, for "evaluate" a matrix and a CSV file of variable values
+    \param output name of the file for the results
+    \return Exit status
+*/
+static int runBatch(const std::string& operation, const std::vector<std::string>& inputs, const std::string& output)
+{
+    const bool binary = (operation == "add" || operation == "subtract" || operation == "multiply");
+    const std::size_t needed = (binary || operation == "evaluate") ? 2 : (operation == "transpose") ? 1 : 0;
+    if(needed == 0 || inputs.size() != needed)
+    {
+        std::cout << "Usage: --batch add|subtract|multiply a.csv b.csv out.csv, --batch transpose a.csv out.csv"
+                  << " or --batch evaluate matrix values.csv out.csv" << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        MatrixBatch result;
+        if(operation == "evaluate")
+        {
+            result = evaluateBatch(SymbolicSquareMatrix(inputs[0]), importValuationsCsv(inputs[1]));
+        }
+        else if(operation == "transpose")
+        {
+            result = importBatchCsv(inputs[0]).transpose();
+        }
+        else
+        {
+            MatrixBatch b1 = importBatchCsv(inputs[0]);
+            MatrixBatch b2 = importBatchCsv(inputs[1]);
+            result = (operation == "add") ? b1 + b2 : (operation == "subtract") ? b1 - b2 : b1 * b2;
+        }
+        exportBatchCsv(output, result);
+        std::cout << "Wrote " << result.getCount() << " matrices of size " << result.getSize() << " to " << output << " in "
+                  << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s" << std::endl;
+    }
+    catch(const std::exception& e)
+    {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+    \brief Read count given as command line argument
+    \param arg the argument
+    \param count variable to read into, unchanged if argument is not valid
+    \return false if argument is not a non-negative integer that fits in unsigned int
+*/
+static bool readCount(const char* arg, unsigned int& count)
+{
+    std::istringstream strm(arg);
+    unsigned int value = 0;
+    // extraction of unsigned numbers would accept and negate a minus sign
+    if(strm.peek() == '-' || !(strm >> value) || !(strm >> std::ws).eof())
+        return false;
+    count = value;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    // server, load generator and batches skip the tests, their arguments are "--server path [threads]",
+    // "--load path [clients] [lines per client] [lines in flight]" and "--batch operation inputs... output"
+    if(argc >= 3 && std::string(argv[1]) == "--server")
+    {
+        unsigned int threads = 0;
+        if(argc >= 4 && !readCount(argv[3], threads))
+        {
+            std::cout << "Usage: --server path [threads]" << std::endl;
+            return 1;
+        }
+        return serve(argv[2], threads);
+    }
+    if(argc >= 3 && std::string(argv[1]) == "--load")
+    {
+        unsigned int counts[3] = {8, 10000, 1};
+        for(int k = 3; k < argc && k < 6; k++)
+        {
+            if(!readCount(argv[k], counts[k - 3]) || counts[k - 3] == 0)
+            {
+                std::cout << "Usage: --load path [clients] [lines per client] [lines in flight], all positive integers" << std::endl;
+                return 1;
+            }
+        }
+        return generateLoad(argv[2], counts[0], counts[1], counts[2]);
+    }
+
+    if(argc >= 3 && std::string(argv[1]) == "--batch")
+    {
+        return runBatch(argv[2], std::vector<std::string>(argv + 3, argv + std::max(3, argc - 1)), argc >= 4 ? argv[argc - 1] : "");
+    }
+
+    int result = Catch::Session().run( argc, argv );
+    std::string input;
+    std::stack<std::shared_ptr<SquareMatrix>> matrices;
+    Valuation v;
+    ResultCache cache;
+    std::shared_ptr<const LUFactorization<RealField>> factors;
+    std::shared_ptr<const Modulus> modulus;
+    bool exact = false;
+    char c1 = ' ';
+    char c2 = ' ';
+    int number = 0;
+    std::stringstream strm;
+    MatrixLayout layout = MatrixLayout::Compact;
+    std::ios::sync_with_stdio(false);
+
+    // input from a pipe or file runs in the foreground, so output keeps the order of the input
+    bool background = isatty(STDIN_FILENO);
+    BackgroundJob job;
+    std::signal(SIGINT, handleInterrupt);
+    if(background)
+        std::cin.tie(nullptr);
+
+    auto waitForJob = [&job]()
+    {
+        if(job.active() && !job.isFinished())
+        {
+            std::lock_guard<std::mutex> lock(output_mutex);
+            std::cout << "Waiting for " << job.getName() << " to finish, Ctrl-C cancels it" << std::endl;
+        }
+        job.join();
+    };
+
+    while(true)
+    {
+        strm.clear();
+        strm.str("");
+        if(job.active() && job.isFinished())
+            job.join();
+        {
+            std::lock_guard<std::mutex> lock(output_mutex);
+            std::cout << "Give an input" << std::endl;
+        }
+        if((std::cin >> std::ws).peek() == '[')
+        {
+            // parsing is not run in the background, but Ctrl-C cancels it instead of the job
+            Progress parsing;
+            Progress* job_progress = interruptible.exchange(&parsing);
+            try
+            {
+                MatrixStreamParser<Element> parser(std::cin, [&parsing](std::size_t chars)
+                {
+                    parsing.check();
+                    if(chars % (std::size_t(1) << 24) == 0)
+                    {
+                        std::lock_guard<std::mutex> lock(output_mutex);
+                        std::cerr << "Read " << (chars >> 20) << " MB of matrix" << std::endl;
+                    }
+                }, std::size_t(1) << 20);
+                std::shared_ptr<SquareMatrix> matrix_ptr = std::make_shared<SymbolicSquareMatrix>(parser.parse());
+                interruptible = job_progress;
+                waitForJob();
+                matrices.push(matrix_ptr);
+                std::cout << "Added matrix to stack" << std::endl;
+            }
+            catch(const std::invalid_argument& ia)
+            {
+                interruptible = job_progress;
+                std::lock_guard<std::mutex> lock(output_mutex);
+                std::cout << "Invalid input" << std::endl;
+                std::cin.clear();
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            }
+            catch(const OperationCancelled& oc)
+            {
+                interruptible = job_progress;
+                std::lock_guard<std::mutex> lock(output_mutex);
+                std::cout << "Cancelled reading matrix" << std::endl;
+                std::cin.clear();
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            }
+            continue;
+        }
+        std::cin >> input;
+
+        if(!std::cin || input == "quit")
+            return result;
+
+        strm << input;
+        strm >> c1;
+        strm >> c2;
+        if(c2 == '=')
+        {
+            // the job copied the valuation when it started, so assignments do not wait for it
+            std::lock_guard<std::mutex> lock(output_mutex);
+            strm >> number;
+            if(strm.fail())
+            {
+                std::cout << "You must give an integer value to the character" << std::endl;
+                continue;
+            }
+
+            if(strm.rdbuf()->in_avail() == 0)
+            {
+                v[c1] = number;
+                std::cout << "Gave character " << c1 << " the value of " << number << std::endl;
+                c2 = ' ';
+            }
+        }
+        else
+        {
+            if(!input.empty())
+                c1 = input[0];
+
+            if(input == "progress" || input == "cancel")
+            {
+                std::lock_guard<std::mutex> lock(output_mutex);
+                if(!job.active() || job.isFinished())
+                {
+                    std::cout << "Nothing is running" << std::endl;
+                }
+                else if(input == "cancel")
+                {
+                    job.cancel();
+                    std::cout << "Cancelling " << job.getName() << std::endl;
+                }
+                else if(job.getProgress().getTotal() == 0)
+                {
+                    std::cout << "Running " << job.getName() << std::endl;
+                }
+                else
+                {
+                    std::cout << "Running " << job.getName() << ": " << job.getProgress().getDone() << " of "
+                              << job.getProgress().getTotal() << " rows done" << std::endl;
+                }
+                continue;
+            }
+            waitForJob();
+
+            if(c1 == '+' || c1 == '-' || c1 == '*')
+            {
+                const char* name = (c1 == '+') ? "addition" : (c1 == '-') ? "subtraction" : "multiplication";
+                std::shared_ptr<const Modulus> mod = modulus;
+                job.start(name, [&matrices, &cache, v, op = c1, mod, exact](std::ostream& out, Progress& progress)
+                {
+                    stackOperation(matrices, v, cache, op, mod.get(), exact, out, &progress);
+                }, background);
+            }
+            else if(c1 == '=')
+            {
+                if(matrices.empty())
+                {
+                    std::cout << "Stack is empty" << std::endl;
+                    continue;
+                }
+                job.start("evaluation", [&matrices, &cache, v, layout](std::ostream& out, Progress& progress)
+                {
+                    try
+                    {
+                        if(const ExactSquareMatrix* em = dynamic_cast<const ExactSquareMatrix*>(matrices.top().get()))
+                            em->write(out, layout);
+                        else
+                            evaluateCached(*matrices.top(), v, cache, &progress)->write(out, layout);
+                        out << std::endl;
+                    }
+                    catch(const std::invalid_argument& ia)
+                    {
+                        out << "Couldn't do evaluation, please declare values to variables" << std::endl;
+                    }
+                    catch(const OperationCancelled& oc)
+                    {
+                        out << "Cancelled evaluation" << std::endl;
+                    }
+                }, background);
+            }
+            else if(input == "pretty")
+            {
+                layout = MatrixLayout::Pretty;
+                std::cout << "Matrices are printed one row per line" << std::endl;
+            }
+            else if(input == "compact")
+            {
+                layout = MatrixLayout::Compact;
+                std::cout << "Matrices are printed on one line" << std::endl;
+            }
+            else if(input == "save")
+            {
+                std::string filename;
+                std::cin >> filename;
+                if(matrices.empty())
+                {
+                    std::cout << "Stack is empty" << std::endl;
+                    continue;
+                }
+                try
+                {
+                    saveMatrix(filename, *evaluateCached(*matrices.top(), v, cache));
+                    std::cout << "Saved topmost matrix to " << filename << std::endl;
+                }
+                catch(const std::invalid_argument& ia)
+                {
+                    std::cout << "Couldn't do evaluation, please declare values to variables" << std::endl;
+                }
+                catch(const std::runtime_error& re)
+                {
+                    std::cout << re.what() << std::endl;
+                }
+            }
+            else if(input == "load")
+            {
+                std::string filename;
+                std::cin >> filename;
+                try
+                {
+                    std::shared_ptr<SquareMatrix> matrix_ptr = std::make_shared<ConcreteSquareMatrix>(loadMatrix(filename));
+                    matrices.push(matrix_ptr);
+                    std::cout << "Added matrix from " << filename << " to stack" << std::endl;
+                }
+                catch(const std::exception& e)
+                {
+                    std::cout << e.what() << std::endl;
+                }
+            }
+            else if(input == "import")
+            {
+                std::string filename;
+                std::cin >> filename;
+                try
+                {
+                    std::shared_ptr<SquareMatrix> matrix_ptr = std::make_shared<ConcreteSquareMatrix>(importMatrix(filename));
+                    matrices.push(matrix_ptr);
+                    std::cout << "Added matrix from " << filename << " to stack" << std::endl;
+                }
+                catch(const std::exception& e)
+                {
+                    std::cout << e.what() << std::endl;
+                }
+            }
+            else if(input == "export")
+            {
+                std::string filename;
+                std::cin >> filename;
+                if(matrices.empty())
+                {
+                    std::cout << "Stack is empty" << std::endl;
+                    continue;
+                }
+                try
+                {
+                    exportMatrix(filename, *evaluateCached(*matrices.top(), v, cache));
+                    std::cout << "Exported topmost matrix to " << filename << std::endl;
+                }
+                catch(const std::invalid_argument& ia)
+                {
+                    std::cout << ia.what() << std::endl;
+                }
+                catch(const std::runtime_error& re)
+                {
+                    std::cout << re.what() << std::endl;
+                }
+            }
+            else if(input == "snapshot")
+            {
+                std::string filename;
+                std::cin >> filename;
+                try
+                {
+                    saveSession(filename, matrices, v);
+                    std::cout << "Saved session to " << filename << std::endl;
+                }
+                catch(const std::exception& e)
+                {
+                    std::cout << e.what() << std::endl;
+                }
+            }
+            else if(input == "restore")
+            {
+                std::string filename;
+                std::cin >> filename;
+                try
+                {
+                    restoreSession(filename, matrices, v);
+                    std::cout << "Restored " << matrices.size() << " matrices and " << v.size() << " variables from " << filename << std::endl;
+                }
+                catch(const std::exception& e)
+                {
+                    std::cout << e.what() << std::endl;
+                }
+            }
+            else if(input == "transpose")
+            {
+                if(matrices.empty())
+                {
+                    std::cout << "Stack is empty" << std::endl;
+                    continue;
+                }
+                std::shared_ptr<SquareMatrix> res_ptr = transposeCached(*matrices.top(), v, cache);
+                if(res_ptr == nullptr)
+                    continue;
+                matrices.pop();
+                matrices.push(res_ptr);
+                std::cout << "Transposed topmost matrix: " << res_ptr->toString() << std::endl;
+            }
+            else if(input == "det")
+            {
+                if(matrices.empty())
+                {
+                    std::cout << "Stack is empty" << std::endl;
+                    continue;
+                }
+                job.start("determinant", [&matrices, &cache, v](std::ostream& out, Progress& progress)
+                {
+                    try
+                    {
+                        out << "Determinant of topmost matrix: " << determinant(*evaluateCached(*matrices.top(), v, cache, &progress), 0, &progress) << std::endl;
+                    }
+                    catch(const std::invalid_argument& ia)
+                    {
+                        if(dynamic_cast<const ExactSquareMatrix*>(matrices.top().get()) != nullptr)
+                            out << ia.what() << std::endl;
+                        else
+                            out << "Couldn't do evaluation, please declare values to variables" << std::endl;
+                    }
+                    catch(const OperationCancelled& oc)
+                    {
+                        out << "Cancelled determinant" << std::endl;
+                    }
+                }, background);
+            }
+            else if(input == "lu")
+            {
+                if(matrices.empty())
+                {
+                    std::cout << "Stack is empty" << std::endl;
+                    continue;
+                }
+                try
+                {
+                    factors = std::make_shared<LUFactorization<RealField>>(*evaluateCached(*matrices.top(), v, cache));
+                    std::cout << "Factored topmost matrix" << std::endl;
+                }
+                catch(const std::invalid_argument& ia)
+                {
+                    std::cout << ia.what() << std::endl;
+                }
+            }
+            else if(input == "solve" || input == "inverse")
+            {
+                if(factors == nullptr)
+                {
+                    std::cout << "No factored matrix, use lu first" << std::endl;
+                    continue;
+                }
+                unsigned int n = factors->getSize();
+                if(input == "inverse")
+                {
+                    printValues(factors->inverse(), n, n);
+                    continue;
+                }
+                if(matrices.empty())
+                {
+                    std::cout << "Stack is empty" << std::endl;
+                    continue;
+                }
+                try
+                {
+                    std::shared_ptr<const ConcreteSquareMatrix> rhs = evaluateCached(*matrices.top(), v, cache);
+                    if(rhs->getSize() != n)
+                    {
+                        std::cout << "Matrices are not the same size" << std::endl;
+                        continue;
+                    }
+                    std::vector<int> values(static_cast<std::size_t>(n) * n);
+                    rhs->copyValues(values.data());
+                    printValues(factors->solve(std::vector<double>(values.begin(), values.end()), n), n, n);
+                }
+                catch(const std::invalid_argument& ia)
+                {
+                    std::cout << "Couldn't do evaluation, please declare values to variables" << std::endl;
+                }
+            }
+            else if(input == "mod")
+            {
+                unsigned long long p = 0;
+                if(!(std::cin >> p) || p == 1 || p > 2147483648ULL)
+                {
+                    std::cin.clear();
+                    std::cout << "Modulus must be between 2 and 2147483648, or 0 to turn modular mode off" << std::endl;
+                    continue;
+                }
+                if(p == 0)
+                {
+                    modulus.reset();
+                    std::cout << "Modular mode is off" << std::endl;
+                }
+                else
+                {
+                    modulus = std::make_shared<Modulus>(static_cast<std::uint32_t>(p));
+                    exact = false;
+                    std::cout << "Calculating modulo " << p << std::endl;
+                }
+            }
+            else if(input == "exact")
+            {
+                exact = !exact;
+                if(exact)
+                {
+                    modulus.reset();
+                    std::cout << "Exact mode is on" << std::endl;
+                }
+                else
+                {
+                    std::cout << "Exact mode is off" << std::endl;
+                }
+            }
+            else if(input == "pow")
+            {
+                unsigned long long e = 0;
+                if(!(std::cin >> e))
+                {
+                    std::cin.clear();
+                    std::cout << "You must give a non-negative integer exponent" << std::endl;
+                    continue;
+                }
+                if(matrices.empty())
+                {
+                    std::cout << "Stack is empty" << std::endl;
+                    continue;
+                }
+                std::shared_ptr<const Modulus> mod = modulus;
+                job.start("power", [&matrices, &cache, v, e, mod, exact](std::ostream& out, Progress& progress)
+                {
+                    try
+                    {
+                        std::shared_ptr<SquareMatrix> res_ptr = power(*matrices.top(), e, v, cache, mod.get(), exact, &progress);
+                        matrices.pop();
+                        matrices.push(res_ptr);
+                        out << "Raised topmost matrix to power: " << res_ptr->toString() << std::endl;
+                    }
+                    catch(const std::invalid_argument& ia)
+                    {
+                        out << "Couldn't do evaluation, please declare values to variables" << std::endl;
+                    }
+                    catch(const OperationCancelled& oc)
+                    {
+                        out << "Cancelled power" << std::endl;
+                    }
+                }, background);
+            }
+            else if(input == "minplus" || input == "maxplus" || input == "boolean")
+            {
+                Semiring sr = (input == "minplus") ? Semiring::MinPlus : (input == "maxplus") ? Semiring::MaxPlus : Semiring::Boolean;
+                job.start(std::string(semiringName(sr)) + " multiplication", [&matrices, &cache, v, sr](std::ostream& out, Progress& progress)
+                {
+                    semiringOperation(matrices, v, cache, sr, out, &progress);
+                }, background);
+            }
+            else if(input == "minpow" || input == "maxpow" || input == "boolpow")
+            {
+                Semiring sr = (input == "minpow") ? Semiring::MinPlus : (input == "maxpow") ? Semiring::MaxPlus : Semiring::Boolean;
+                unsigned long long e = 0;
+                if(!(std::cin >> e))
+                {
+                    std::cin.clear();
+                    std::cout << "You must give a non-negative integer exponent" << std::endl;
+                    continue;
+                }
+                if(matrices.empty())
+                {
+                    std::cout << "Stack is empty" << std::endl;
+                    continue;
+                }
+                job.start(std::string(semiringName(sr)) + " power", [&matrices, &cache, v, e, sr](std::ostream& out, Progress& progress)
+                {
+                    try
+                    {
+                        std::shared_ptr<SquareMatrix> res_ptr = std::make_shared<ConcreteSquareMatrix>(
+                            semiringPower(*evaluateCached(*matrices.top(), v, cache, &progress), e, sr, &progress));
+                        matrices.pop();
+                        matrices.push(res_ptr);
+                        out << "Raised topmost matrix to " << semiringName(sr) << " power: " << res_ptr->toString() << std::endl;
+                    }
+                    catch(const std::invalid_argument& ia)
+                    {
+                        out << "Couldn't do evaluation, please declare values to variables" << std::endl;
+                    }
+                    catch(const OperationCancelled& oc)
+                    {
+                        out << "Cancelled " << semiringName(sr) << " power" << std::endl;
+                    }
+                }, background);
+            }
+            else if(input == "cache")
+            {
+                std::cout << "Result cache: " << cache.getHits() << " hits, " << cache.getMisses() << " misses, "
+                          << cache.getEvictions() << " evictions, " << cache.size() << " results using "
+                          << (cache.getUsage() >> 10) << " of " << (cache.getBudget() >> 10) << " kB" << std::endl;
+            }
+            else if(input == "cachelimit")
+            {
+                std::size_t kilobytes = 0;
+                if(!(std::cin >> kilobytes))
+                {
+                    std::cin.clear();
+                    std::cout << "You must give the limit in kilobytes" << std::endl;
+                    continue;
+                }
+                cache.setBudget(kilobytes << 10);
+                std::cout << "Result cache is limited to " << kilobytes << " kB" << std::endl;
+            }
+            else if(input == "specialize")
+            {
+                if(matrices.empty())
+                {
+                    std::cout << "Stack is empty" << std::endl;
+                    continue;
+                }
+                std::shared_ptr<SquareMatrix> spec_ptr = std::make_shared<SymbolicSquareMatrix>(matrices.top()->specialize(v));
+                matrices.pop();
+                matrices.push(spec_ptr);
+                std::cout << "Specialized topmost matrix: " << spec_ptr->toString() << std::endl;
+            }
+            else
+            {
+                try
+                {
+                    SymbolicSquareMatrix matrix(input);
+                    std::shared_ptr<SquareMatrix> matrix_ptr = std::make_shared<SymbolicSquareMatrix>(std::move(matrix));
+                    matrices.push(matrix_ptr);
+                    std::cout << "Added matrix to stack" << std::endl;
+                }
+                catch(std::invalid_argument ia)
+                {
+                    std::cout << "Invalid input" << std::endl;
+                }
+            }
+        }
+    }
+}
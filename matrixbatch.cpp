@@ -0,0 +1,270 @@
+/**
+    \file matrixbatch.cpp
+    \brief Code for MatrixBatch class
+*/
+
+#include "matrixbatch.h"
+#include "expressionpool.h"
+#include "taskscheduler.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    /// Number of matrices handled at a time, one block of every element of a 4 x 4 product stays in cache
+    const std::size_t batch_block = 1024;
+
+    /// Bytes of node values evaluated at a time for one block of the batch, fits in the L2 cache of a core
+    const std::size_t evaluation_block_bytes = std::size_t(1) << 18;
+
+    /// Smallest number of matrices evaluated at a time, keeps the loops over a block vectorized for large expressions
+    const std::size_t evaluation_min_block = 8;
+
+    /// Batches with less work than this are calculated in one thread
+    const std::size_t parallel_batch_threshold = 1 << 18;
+
+    /**
+        \brief Call function for blocks of the batch, large batches are divided between threads
+        \param count number of matrices
+        \param work amount of work for each matrix, used to decide whether to use threads
+        \param fn function called with first and last index of each block
+        \param block number of matrices in a block
+    */
+    template <typename Fn>
+    void forBlocks(std::size_t count, std::size_t work, const Fn& fn, std::size_t block = batch_block)
+    {
+        const std::size_t blocks = (count + block - 1) / block;
+        auto run = [&](std::size_t first, std::size_t last)
+        {
+            for(std::size_t k = first; k < last; k++)
+            {
+                fn(k * block, std::min(count, (k + 1) * block));
+            }
+        };
+
+        if(count * work < parallel_batch_threshold)
+            run(0, blocks);
+        else
+            parallelFor(0, blocks, 1, run);
+    }
+
+    /**
+        \brief Values of element of every matrix as unsigned numbers, which wrap around
+        \param p pointer to values
+        \return The pointer
+    */
+    inline unsigned int* lanes(int* p)
+    {
+        return reinterpret_cast<unsigned int*>(p);
+    }
+
+    inline const unsigned int* lanes(const int* p)
+    {
+        return reinterpret_cast<const unsigned int*>(p);
+    }
+}
+
+MatrixBatch::MatrixBatch(unsigned int size, std::size_t matrices):
+    n(size), count(matrices), values(static_cast<std::size_t>(size) * size * matrices, 0) {}
+
+void MatrixBatch::checkShape(const MatrixBatch& b) const
+{
+    if(n != b.n || count != b.count)
+    {
+        throw std::invalid_argument("Batches are not the same size");
+    }
+}
+
+MatrixBatch MatrixBatch::fromMatrices(const std::vector<ConcreteSquareMatrix>& matrices)
+{
+    MatrixBatch batch(matrices.empty() ? 0 : matrices[0].getSize(), matrices.size());
+    for(std::size_t b = 0; b < matrices.size(); b++)
+    {
+        batch.setMatrix(b, matrices[b]);
+    }
+    return batch;
+}
+
+ConcreteSquareMatrix MatrixBatch::getMatrix(std::size_t b) const
+{
+    std::vector<int> vals(static_cast<std::size_t>(n) * n);
+    for(std::size_t e = 0; e < vals.size(); e++)
+    {
+        vals[e] = values[e * count + b];
+    }
+    return ConcreteSquareMatrix::fromValues(n, vals.data());
+}
+
+void MatrixBatch::setMatrix(std::size_t b, const ConcreteSquareMatrix& m)
+{
+    if(m.getSize() != n)
+    {
+        throw std::invalid_argument("Matrices are not the same size");
+    }
+    for(unsigned int i = 0; i < n; i++)
+    {
+        for(unsigned int j = 0; j < n; j++)
+        {
+            element(i, j)[b] = m.valueAt(i, j);
+        }
+    }
+}
+
+MatrixBatch MatrixBatch::transpose() const
+{
+    // every element is one contiguous array, so transposing moves whole arrays
+    MatrixBatch result(n, count);
+    for(unsigned int i = 0; i < n; i++)
+    {
+        for(unsigned int j = 0; j < n; j++)
+        {
+            std::copy_n(element(i, j), count, result.element(j, i));
+        }
+    }
+    return result;
+}
+
+MatrixBatch operator+(const MatrixBatch& b1, const MatrixBatch& b2)
+{
+    b1.checkShape(b2);
+    MatrixBatch result(b1.n, b1.count);
+    const unsigned int* x = lanes(b1.values.data());
+    const unsigned int* y = lanes(b2.values.data());
+    unsigned int* z = lanes(result.values.data());
+    for(std::size_t k = 0; k < result.values.size(); k++)
+    {
+        z[k] = x[k] + y[k];
+    }
+    return result;
+}
+
+MatrixBatch operator-(const MatrixBatch& b1, const MatrixBatch& b2)
+{
+    b1.checkShape(b2);
+    MatrixBatch result(b1.n, b1.count);
+    const unsigned int* x = lanes(b1.values.data());
+    const unsigned int* y = lanes(b2.values.data());
+    unsigned int* z = lanes(result.values.data());
+    for(std::size_t k = 0; k < result.values.size(); k++)
+    {
+        z[k] = x[k] - y[k];
+    }
+    return result;
+}
+
+MatrixBatch operator*(const MatrixBatch& b1, const MatrixBatch& b2)
+{
+    b1.checkShape(b2);
+    const unsigned int n = b1.n;
+    MatrixBatch result(n, b1.count);
+
+    forBlocks(b1.count, static_cast<std::size_t>(n) * n * n, [&](std::size_t first, std::size_t last)
+    {
+        for(unsigned int i = 0; i < n; i++)
+        {
+            for(unsigned int j = 0; j < n; j++)
+            {
+                unsigned int* c = lanes(result.element(i, j));
+                for(unsigned int k = 0; k < n; k++)
+                {
+                    const unsigned int* a = lanes(b1.element(i, k));
+                    const unsigned int* b = lanes(b2.element(k, j));
+                    for(std::size_t m = first; m < last; m++)
+                    {
+                        c[m] += a[m] * b[m];
+                    }
+                }
+            }
+        }
+    });
+    return result;
+}
+
+MatrixBatch evaluateBatch(const SymbolicSquareMatrix& m, const BatchValuation& variables)
+{
+    const unsigned int n = m.getSize();
+    std::size_t count = variables.empty() ? 1 : variables.begin()->second.size();
+    for(const auto& variable: variables)
+    {
+        if(variable.second.size() != count)
+        {
+            throw std::invalid_argument("Variables do not have the same number of values");
+        }
+    }
+
+    ExpressionPool pool;
+    std::vector<std::uint32_t> roots;
+    for(unsigned int i = 0; i < n; i++)
+    {
+        for(unsigned int j = 0; j < n; j++)
+        {
+            roots.push_back(pool.add(m.getElement(i, j)));
+        }
+    }
+
+    const std::vector<ExpressionNode>& nodes = pool.getNodes();
+    std::vector<const unsigned int*> sources(nodes.size(), nullptr);
+    for(std::size_t k = 0; k < nodes.size(); k++)
+    {
+        if(nodes[k].kind != NodeKind::Variable)
+            continue;
+        auto found = variables.find(nodes[k].symbol);
+        if(found == variables.end())
+        {
+            throw std::invalid_argument(std::string("Could not do evaluation, variable ") + nodes[k].symbol + " has no value");
+        }
+        sources[k] = lanes(found->second.data());
+    }
+
+    // every thread keeps the values of all nodes for its block, so the block shrinks as the expressions grow
+    const std::size_t block_bytes = std::max<std::size_t>(1, nodes.size()) * sizeof(unsigned int);
+    const std::size_t block_size = std::min(batch_block, std::max(evaluation_min_block, evaluation_block_bytes / block_bytes));
+    MatrixBatch result(n, count);
+    forBlocks(count, nodes.size(), [&](std::size_t first, std::size_t last)
+    {
+        // values of every node for one block of the batch
+        const std::size_t width = last - first;
+        std::vector<unsigned int> block(nodes.size() * width);
+        for(std::size_t k = 0; k < nodes.size(); k++)
+        {
+            const ExpressionNode& node = nodes[k];
+            unsigned int* out = block.data() + k * width;
+            if(node.kind == NodeKind::Int)
+            {
+                std::fill(out, out + width, node.left);
+                continue;
+            }
+            if(node.kind == NodeKind::Variable)
+            {
+                std::copy_n(sources[k] + first, width, out);
+                continue;
+            }
+
+            const unsigned int* x = block.data() + static_cast<std::size_t>(node.left) * width;
+            const unsigned int* y = block.data() + static_cast<std::size_t>(node.right) * width;
+            if(node.kind == NodeKind::Add)
+            {
+                for(std::size_t b = 0; b < width; b++)
+                    out[b] = x[b] + y[b];
+            }
+            else if(node.kind == NodeKind::Subtract)
+            {
+                for(std::size_t b = 0; b < width; b++)
+                    out[b] = x[b] - y[b];
+            }
+            else
+            {
+                for(std::size_t b = 0; b < width; b++)
+                    out[b] = x[b] * y[b];
+            }
+        }
+
+        for(std::size_t e = 0; e < roots.size(); e++)
+        {
+            int* out = result.element(static_cast<unsigned int>(e / n), static_cast<unsigned int>(e % n));
+            std::copy_n(block.data() + static_cast<std::size_t>(roots[e]) * width, width, lanes(out) + first);
+        }
+    }, block_size);
+    return result;
+}
@@ -0,0 +1,174 @@
+/**
+    \file matrixbatch.h
+    \brief Header for MatrixBatch class
+*/
+
+#ifndef MATRIXBATCH_H_INCLUDED
+#define MATRIXBATCH_H_INCLUDED
+#include "elementarymatrix.h"
+#include <cstddef>
+#include <map>
+#include <vector>
+
+/// Values of each variable for every matrix of a batch
+using BatchValuation = std::map<char, std::vector<int>>;
+
+/**
+    \class MatrixBatch
+    \brief Many integer matrices of the same size stored as structure of arrays
+
+    Values of the same element of every matrix are next to each other, element (i, j) of
+    matrix b is at (i*n + j)*count + b. Operations work on pairs of matrices with the same
+    index and their innermost loops run across the batch, so they are vectorized however
+    small the matrices are. Arithmetic wraps around like IntElement does.
+*/
+class MatrixBatch
+{
+    private:
+        unsigned int n = 0;
+        std::size_t count = 0;
+        std::vector<int> values;
+
+        /**
+            \brief Check that batches have the same number of matrices of the same size
+            \param b the other batch
+            \throw std::invalid_argument if they do not
+        */
+        void checkShape(const MatrixBatch& b) const;
+
+    public:
+
+        /**
+            \brief Default constructor, empty batch
+        */
+        MatrixBatch() = default;
+
+        /**
+            \brief Parametric constructor, all values are zero
+            \param size number of rows and columns of each matrix
+            \param matrices number of matrices
+        */
+        MatrixBatch(unsigned int size, std::size_t matrices);
+
+        /**
+            \brief Build batch of matrices
+            \param matrices the matrices, all of the same size
+            \throw std::invalid_argument if matrices are not the same size
+            \return MatrixBatch object
+        */
+        static MatrixBatch fromMatrices(const std::vector<ConcreteSquareMatrix>& matrices);
+
+        /**
+            \brief Function to get size of matrices
+            \return Number of rows and columns
+        */
+        unsigned int getSize() const
+        {
+            return n;
+        }
+
+        /**
+            \brief Function to get number of matrices
+            \return The number
+        */
+        std::size_t getCount() const
+        {
+            return count;
+        }
+
+        /**
+            \brief Function to get value of element of every matrix
+            \param i row index
+            \param j column index
+            \return Pointer to count values, one for each matrix
+        */
+        int* element(unsigned int i, unsigned int j)
+        {
+            return values.data() + (static_cast<std::size_t>(i) * n + j) * count;
+        }
+
+        /**
+            \brief Function to get value of element of every matrix
+            \param i row index
+            \param j column index
+            \return Pointer to count values, one for each matrix
+        */
+        const int* element(unsigned int i, unsigned int j) const
+        {
+            return values.data() + (static_cast<std::size_t>(i) * n + j) * count;
+        }
+
+        /**
+            \brief Function to get value of element of one matrix
+            \param b index of matrix
+            \param i row index
+            \param j column index
+            \return The value
+        */
+        int valueAt(std::size_t b, unsigned int i, unsigned int j) const
+        {
+            return element(i, j)[b];
+        }
+
+        /**
+            \brief Function to get one matrix of the batch
+            \param b index of matrix
+            \return ConcreteSquareMatrix object
+        */
+        ConcreteSquareMatrix getMatrix(std::size_t b) const;
+
+        /**
+            \brief Replace one matrix of the batch
+            \param b index of matrix
+            \param m matrix of the same size
+            \throw std::invalid_argument if m is not the same size
+        */
+        void setMatrix(std::size_t b, const ConcreteSquareMatrix& m);
+
+        /**
+            \brief Function to get transposes of the matrices
+            \return MatrixBatch object
+        */
+        MatrixBatch transpose() const;
+
+        /**
+            \brief Addition operator, adds matrices with the same index
+            \param b1 first batch
+            \param b2 second batch
+            \throw std::invalid_argument if batches are not the same shape
+            \return MatrixBatch object
+        */
+        friend MatrixBatch operator+(const MatrixBatch& b1, const MatrixBatch& b2);
+
+        /**
+            \brief Subtraction operator, subtracts matrices with the same index
+            \param b1 first batch
+            \param b2 second batch
+            \throw std::invalid_argument if batches are not the same shape
+            \return MatrixBatch object
+        */
+        friend MatrixBatch operator-(const MatrixBatch& b1, const MatrixBatch& b2);
+
+        /**
+            \brief Multiplication operator, multiplies matrices with the same index
+            \param b1 first batch
+            \param b2 second batch
+            \throw std::invalid_argument if batches are not the same shape
+            \return MatrixBatch object
+        */
+        friend MatrixBatch operator*(const MatrixBatch& b1, const MatrixBatch& b2);
+};
+
+/**
+    \brief Evaluate matrix once for each set of variable values
+
+    Elements are flattened to an ExpressionPool once and every node is evaluated for a
+    block of the batch at a time.
+    \param m matrix to evaluate
+    \param variables values of variables, all with the same number of values
+    \throw std::invalid_argument if a variable of m has no values or variables have different numbers of values
+    \return MatrixBatch object with one matrix for each set of values
+*/
+MatrixBatch evaluateBatch(const SymbolicSquareMatrix& m, const BatchValuation& variables);
+
+#endif // MATRIXBATCH_H_INCLUDED
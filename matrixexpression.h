@@ -0,0 +1,125 @@
+/**
+    \file matrixexpression.h
+    \brief Header for lazy element-wise expressions of ConcreteSquareMatrix objects
+*/
+
+#ifndef MATRIXEXPRESSION_H_INCLUDED
+#define MATRIXEXPRESSION_H_INCLUDED
+#include "element.h"
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+
+template <typename T>
+class ElementarySquareMatrix;
+
+template <typename L, typename R, typename Op>
+class MatrixBinaryExpression;
+
+/**
+    \brief Trait telling if type can be an operand of a lazy concrete expression
+    \tparam E Type to check
+*/
+template <typename E>
+struct IsConcreteOperand : std::false_type {};
+
+template <>
+struct IsConcreteOperand<ElementarySquareMatrix<IntElement>> : std::true_type {};
+
+template <typename L, typename R, typename Op>
+struct IsConcreteOperand<MatrixBinaryExpression<L, R, Op>> : std::true_type {};
+
+/**
+    \brief Trait for storing operands, matrices are stored by reference and nested expressions by value
+    \tparam E Type of operand
+*/
+template <typename E>
+struct ExpressionOperand
+{
+    using type = E;
+};
+
+template <>
+struct ExpressionOperand<ElementarySquareMatrix<IntElement>>
+{
+    using type = const ElementarySquareMatrix<IntElement>&;
+};
+
+/**
+    \class MatrixBinaryExpression
+    \brief Unevaluated element-wise operation of two concrete operands, the whole expression is calculated in one loop when it is assigned to a ConcreteSquareMatrix
+    \tparam L Type of left operand
+    \tparam R Type of right operand
+    \tparam Op Function object type used for integer operations
+*/
+/* Note: Expression refers to the matrices it was built from, so it must not outlive them*/
+template <typename L, typename R, typename Op>
+class MatrixBinaryExpression
+{
+    private:
+        typename ExpressionOperand<L>::type lhs;
+        typename ExpressionOperand<R>::type rhs;
+    public:
+
+        /**
+            \brief Parametric constructor
+            \param l left operand
+            \param r right operand
+            \throw std::invalid_argument if operands are not the same size
+        */
+        MatrixBinaryExpression(const L& l, const R& r): lhs(l), rhs(r)
+        {
+            if(l.getSize() != r.getSize())
+            {
+                throw std::invalid_argument("Matrices are not the same size");
+            }
+        }
+
+        /**
+            \brief Function to get size of the result
+            \return Number of rows and columns
+        */
+        unsigned int getSize() const
+        {
+            return lhs.getSize();
+        }
+
+        /**
+            \brief Calculate one element of the result
+            \param i row index
+            \param j column index
+            \return Value of the element
+        */
+        int valueAt(unsigned int i, unsigned int j) const
+        {
+            return Op()(lhs.valueAt(i, j), rhs.valueAt(i, j));
+        }
+};
+
+/**
+    \brief Operator for lazy ConcreteSquareMatrix addition
+    \param l first member of addition
+    \param r second member of addition
+    \throw std::invalid_argument if matrices are not the same size
+    \return Expression object representing the addition
+*/
+template <typename L, typename R, typename = typename std::enable_if<IsConcreteOperand<L>::value && IsConcreteOperand<R>::value>::type>
+MatrixBinaryExpression<L, R, std::plus<int>> operator+(const L& l, const R& r)
+{
+    return MatrixBinaryExpression<L, R, std::plus<int>>(l, r);
+}
+
+/**
+    \brief Operator for lazy ConcreteSquareMatrix subtraction
+    \param l first member of subtraction
+    \param r second member of subtraction
+    \throw std::invalid_argument if matrices are not the same size
+    \return Expression object representing the subtraction
+*/
+template <typename L, typename R, typename = typename std::enable_if<IsConcreteOperand<L>::value && IsConcreteOperand<R>::value>::type>
+MatrixBinaryExpression<L, R, std::minus<int>> operator-(const L& l, const R& r)
+{
+    return MatrixBinaryExpression<L, R, std::minus<int>>(l, r);
+}
+
+#endif // MATRIXEXPRESSION_H_INCLUDED
@@ -0,0 +1,168 @@
+/**
+    \file matrixfile.cpp
+    \brief Code for reading and writing ConcreteSquareMatrix objects in binary file format
+*/
+
+#include "matrixfile.h"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MATRIXFILE_USE_MMAP
+#endif
+
+static const char matrix_file_magic[4] = {'M', 'X', 'C', 'B'};
+static const std::uint16_t matrix_file_version = 1;
+static const std::uint8_t matrix_file_int32 = 1;
+static const std::uint32_t matrix_file_byte_order = 0x01020304;
+
+MappedFile::MappedFile(const std::string& path)
+{
+#ifdef MATRIXFILE_USE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        throw std::runtime_error("Could not open file " + path);
+    }
+
+    struct stat info;
+    if(::fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("Could not read file " + path);
+    }
+
+    length = static_cast<std::size_t>(info.st_size);
+    if(length > 0)
+    {
+        void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(mapping == MAP_FAILED)
+        {
+            ::close(fd);
+            throw std::runtime_error("Could not map file " + path);
+        }
+        ::madvise(mapping, length, MADV_SEQUENTIAL);
+        ptr = static_cast<const char*>(mapping);
+    }
+    ::close(fd);
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if(!file)
+    {
+        throw std::runtime_error("Could not open file " + path);
+    }
+
+    length = static_cast<std::size_t>(file.tellg());
+    buffer.resize(length);
+    file.seekg(0);
+    if(!file.read(buffer.data(), length))
+    {
+        throw std::runtime_error("Could not read file " + path);
+    }
+    ptr = buffer.data();
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef MATRIXFILE_USE_MMAP
+    if(ptr != nullptr)
+    {
+        ::munmap(const_cast<char*>(ptr), length);
+    }
+#endif
+}
+
+std::uint64_t matrixChecksum(const void* data, std::size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    std::uint64_t h = 0xcbf29ce484222325ULL;
+    std::size_t i = 0;
+
+    for( ; i + 8 <= size; i += 8)
+    {
+        std::uint64_t word;
+        std::memcpy(&word, bytes + i, 8);
+        h = (h ^ word) * 0x100000001b3ULL;
+    }
+    for( ; i < size; i++)
+    {
+        h = (h ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+void saveMatrix(const std::string& path, const ConcreteSquareMatrix& m)
+{
+    std::size_t count = static_cast<std::size_t>(m.getSize()) * m.getSize();
+    std::vector<int> values(count);
+    MatrixFileHeader header;
+
+    m.copyValues(values.data());
+    std::memcpy(header.magic, matrix_file_magic, sizeof(header.magic));
+    header.version = matrix_file_version;
+    header.element_type = matrix_file_int32;
+    header.reserved = 0;
+    header.byte_order = matrix_file_byte_order;
+    header.n = m.getSize();
+    header.data_offset = sizeof(MatrixFileHeader);
+    header.checksum = matrixChecksum(values.data(), count * sizeof(int));
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if(!file)
+    {
+        throw std::runtime_error("Could not open file " + path);
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(values.data()), count * sizeof(int));
+    if(!file)
+    {
+        throw std::runtime_error("Could not write file " + path);
+    }
+}
+
+ConcreteSquareMatrix loadMatrix(const std::string& path)
+{
+    static_assert(sizeof(int) == 4, "Matrix files store 32-bit integers");
+    MappedFile file(path);
+    MatrixFileHeader header;
+
+    if(file.size() < sizeof(header))
+    {
+        throw std::invalid_argument("File is not a matrix file");
+    }
+
+    std::memcpy(&header, file.data(), sizeof(header));
+    if(std::memcmp(header.magic, matrix_file_magic, sizeof(header.magic)) != 0)
+    {
+        throw std::invalid_argument("File is not a matrix file");
+    }
+    if(header.version != matrix_file_version || header.element_type != matrix_file_int32)
+    {
+        throw std::invalid_argument("Unsupported matrix file version");
+    }
+    if(header.byte_order != matrix_file_byte_order)
+    {
+        throw std::invalid_argument("Matrix file was written with different byte order");
+    }
+
+    std::size_t count = static_cast<std::size_t>(header.n) * header.n;
+    if(header.data_offset < sizeof(header) || header.data_offset % alignof(int) != 0 || header.data_offset > file.size() || (file.size() - header.data_offset) / sizeof(int) < count)
+    {
+        throw std::invalid_argument("Matrix file is truncated");
+    }
+
+    const char* data = file.data() + header.data_offset;
+    if(matrixChecksum(data, count * sizeof(int)) != header.checksum)
+    {
+        throw std::invalid_argument("Matrix file checksum does not match");
+    }
+
+    return ConcreteSquareMatrix::fromValues(header.n, reinterpret_cast<const int*>(data));
+}
@@ -0,0 +1,103 @@
+/**
+    \file matrixfile.h
+    \brief Header for reading and writing ConcreteSquareMatrix objects in binary file format
+*/
+
+#ifndef MATRIXFILE_H_INCLUDED
+#define MATRIXFILE_H_INCLUDED
+#include "elementarymatrix.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+    \brief Header at the start of a binary matrix file
+
+    File starts with this header, followed by n*n 32-bit integers in row-major order
+    starting at data_offset. Numbers are stored in the byte order of the machine
+    that wrote the file, byte_order tells which one it was.
+*/
+struct MatrixFileHeader
+{
+    char magic[4];              ///< always "MXCB"
+    std::uint16_t version;      ///< format version, currently 1
+    std::uint8_t element_type;  ///< 1 for 32-bit integers
+    std::uint8_t reserved;      ///< always 0
+    std::uint32_t byte_order;   ///< 0x01020304 written in native byte order
+    std::uint32_t n;            ///< number of rows and columns
+    std::uint64_t data_offset;  ///< offset of first element from start of file
+    std::uint64_t checksum;     ///< checksum of the element data
+};
+
+/**
+    \class MappedFile
+    \brief Read-only view to the contents of a file, memory-mapped when the system supports it
+*/
+class MappedFile
+{
+    private:
+        const char* ptr = nullptr;
+        std::size_t length = 0;
+        std::vector<char> buffer;
+    public:
+
+        /**
+            \brief Parametric constructor
+            \param path name of the file
+            \throw std::runtime_error if file cannot be read
+        */
+        MappedFile(const std::string& path);
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /**
+            \brief Destructor, unmaps the file
+        */
+        ~MappedFile();
+
+        /**
+            \brief Function to get contents of file
+            \return Pointer to first byte
+        */
+        const char* data() const
+        {
+            return ptr;
+        }
+
+        /**
+            \brief Function to get size of file
+            \return Size in bytes
+        */
+        std::size_t size() const
+        {
+            return length;
+        }
+};
+
+/**
+    \brief Calculate checksum used in binary matrix files
+    \param data pointer to start of data
+    \param size size of data in bytes
+    \return The checksum
+*/
+std::uint64_t matrixChecksum(const void* data, std::size_t size);
+
+/**
+    \brief Write ConcreteSquareMatrix to binary file
+    \param path name of the file
+    \param m matrix to write
+    \throw std::runtime_error if file cannot be written
+*/
+void saveMatrix(const std::string& path, const ConcreteSquareMatrix& m);
+
+/**
+    \brief Read ConcreteSquareMatrix from binary file, file is memory-mapped when the system supports it
+    \param path name of the file
+    \throw std::runtime_error if file cannot be read
+    \throw std::invalid_argument if file is not a valid matrix file
+    \return ConcreteSquareMatrix object
+*/
+ConcreteSquareMatrix loadMatrix(const std::string& path);
+
+#endif // MATRIXFILE_H_INCLUDED
@@ -0,0 +1,921 @@
+/**
+    \file matrixio.cpp
+    \brief Code for MatrixMarket and CSV import and export, and SparseSquareMatrix class
+*/
+
+#include "matrixio.h"
+#include "matrixfile.h"
+#include "taskscheduler.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+/**
+    \brief Part of a text file starting and ending at line boundaries
+*/
+struct TextChunk
+{
+    const char* begin;
+    const char* end;
+    std::size_t first_line;     ///< index of first non-blank line of chunk in the whole text
+    std::size_t lines;          ///< number of non-blank lines in chunk
+};
+
+static const std::size_t min_chunk_size = 1 << 20;
+static const std::size_t write_chunk_size = 1 << 16;
+
+static const char* skipSpaces(const char* p, const char* end)
+{
+    while(p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+    {
+        p++;
+    }
+    return p;
+}
+
+static const char* lineEnd(const char* p, const char* end)
+{
+    const void* newline = std::memchr(p, '\n', end - p);
+    return newline == nullptr ? end : static_cast<const char*>(newline);
+}
+
+static const char* readInteger(const char* p, const char* end, long long& value)
+{
+    p = skipSpaces(p, end);
+    if(p < end && *p == '+')
+    {
+        p++;
+    }
+
+    auto result = std::from_chars(p, end, value);
+    if(result.ec != std::errc())
+    {
+        throw std::invalid_argument("Invalid number in matrix file");
+    }
+    return result.ptr;
+}
+
+static const char* readValue(const char* p, const char* end, int& value)
+{
+    long long number;
+    p = readInteger(p, end, number);
+    if(number < std::numeric_limits<int>::min() || number > std::numeric_limits<int>::max())
+    {
+        throw std::invalid_argument("Number in matrix file is too large");
+    }
+    value = static_cast<int>(number);
+    return p;
+}
+
+static const char* readIndex(const char* p, const char* end, unsigned int n, unsigned int& index)
+{
+    long long number;
+    p = readInteger(p, end, number);
+    if(number < 1 || number > n)
+    {
+        throw std::invalid_argument("Index in matrix file is outside the matrix");
+    }
+    index = static_cast<unsigned int>(number - 1);
+    return p;
+}
+
+static void expectLineEnd(const char* p, const char* end)
+{
+    if(skipSpaces(p, end) != end)
+    {
+        throw std::invalid_argument("Unexpected characters in matrix file");
+    }
+}
+
+/**
+    \brief Call function for each non-blank line of chunk
+    \param chunk chunk to go through
+    \param fn function called with start and end of line and index of line in the whole text
+*/
+template <typename Fn>
+static void forEachLine(const TextChunk& chunk, Fn fn)
+{
+    std::size_t line = chunk.first_line;
+    const char* p = chunk.begin;
+
+    while(p < chunk.end)
+    {
+        const char* e = lineEnd(p, chunk.end);
+        if(skipSpaces(p, e) != e)
+        {
+            fn(p, e, line);
+            line++;
+        }
+        p = e + 1;
+    }
+}
+
+/**
+    \brief Call function for each chunk, chunks after the first one are tasks of the global task scheduler
+    \param chunks chunks to go through
+    \param fn function called with each chunk
+    \throw exception thrown by fn for the earliest chunk
+*/
+template <typename Fn>
+static void runParallel(std::vector<TextChunk>& chunks, Fn fn)
+{
+    // errors are kept per chunk so that the one of the earliest line is thrown, not the one that happened first
+    std::vector<std::exception_ptr> errors(chunks.size());
+    auto runChunk = [&chunks, &errors, &fn](std::size_t k)
+    {
+        try
+        {
+            fn(chunks[k]);
+        }
+        catch(...)
+        {
+            errors[k] = std::current_exception();
+        }
+    };
+
+    {
+        TaskGroup group;
+        for(std::size_t k = 1; k < chunks.size(); k++)
+        {
+            group.run([&runChunk, k]() { runChunk(k); });
+        }
+        if(!chunks.empty())
+        {
+            runChunk(0);
+        }
+        group.wait();
+    }
+    for(const auto& error: errors)
+    {
+        if(error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+/**
+    \brief Split text to chunks at line boundaries and count non-blank lines of each chunk
+    \param begin start of text
+    \param end end of text
+    \param threads number of chunks parsed in parallel, 0 uses the thread count of the global task scheduler
+    \return Chunks in order
+*/
+static std::vector<TextChunk> splitLines(const char* begin, const char* end, unsigned int threads)
+{
+    std::size_t size = end - begin;
+    std::vector<TextChunk> chunks;
+
+    if(threads == 0)
+    {
+        threads = TaskScheduler::global().getThreadCount();
+    }
+    std::size_t parts = std::max<std::size_t>(1, std::min<std::size_t>(threads, size / min_chunk_size));
+
+    const char* p = begin;
+    for(std::size_t k = 1; k <= parts && p < end; k++)
+    {
+        const char* e = (k == parts) ? end : std::max(p, begin + size * k / parts);
+        if(e < end)
+        {
+            e = std::min(end, lineEnd(e, end) + 1);
+        }
+        chunks.push_back(TextChunk{p, e, 0, 0});
+        p = e;
+    }
+
+    runParallel(chunks, [](TextChunk& chunk)
+    {
+        forEachLine(chunk, [&chunk](const char*, const char*, std::size_t)
+        {
+            chunk.lines++;
+        });
+    });
+
+    std::size_t line = 0;
+    for(auto& chunk: chunks)
+    {
+        chunk.first_line = line;
+        line += chunk.lines;
+    }
+    return chunks;
+}
+
+static std::size_t countLines(const std::vector<TextChunk>& chunks)
+{
+    return chunks.empty() ? 0 : chunks.back().first_line + chunks.back().lines;
+}
+
+/**
+    \brief Information from the banner and size lines of a MatrixMarket file
+*/
+struct MatrixMarketHeader
+{
+    bool coordinate;
+    bool pattern;
+    int symmetry;               ///< 0 general, 1 symmetric, -1 skew-symmetric
+    unsigned int n;
+    std::size_t entries;        ///< number of data lines
+    const char* body;           ///< first character after size line
+};
+
+static MatrixMarketHeader readMatrixMarketHeader(const char* p, const char* end)
+{
+    MatrixMarketHeader header;
+    const char* e = lineEnd(p, end);
+    std::istringstream banner(std::string(p, e));
+    std::string word, object, format, field, symmetry;
+
+    banner >> word >> object >> format >> field >> symmetry;
+    for(std::string* str: {&object, &format, &field, &symmetry})
+    {
+        std::transform(str->begin(), str->end(), str->begin(), [](unsigned char c) { return std::tolower(c); });
+    }
+    if(word != "%%MatrixMarket" || object != "matrix")
+    {
+        throw std::invalid_argument("File is not a MatrixMarket matrix");
+    }
+    if(format != "coordinate" && format != "array")
+    {
+        throw std::invalid_argument("Unknown MatrixMarket format " + format);
+    }
+    if(field != "integer" && !(field == "pattern" && format == "coordinate"))
+    {
+        throw std::invalid_argument("Only integer MatrixMarket matrices are supported");
+    }
+    if(symmetry != "general" && symmetry != "symmetric" && symmetry != "skew-symmetric")
+    {
+        throw std::invalid_argument("Unsupported MatrixMarket symmetry " + symmetry);
+    }
+    header.coordinate = (format == "coordinate");
+    header.pattern = (field == "pattern");
+    header.symmetry = (symmetry == "general") ? 0 : (symmetry == "symmetric" ? 1 : -1);
+
+    p = (e < end) ? e + 1 : end;
+    while(p < end)
+    {
+        e = lineEnd(p, end);
+        const char* first = skipSpaces(p, e);
+        if(first != e && *first != '%')
+        {
+            break;
+        }
+        p = (e < end) ? e + 1 : end;
+    }
+    if(p >= end)
+    {
+        throw std::invalid_argument("MatrixMarket file has no size line");
+    }
+
+    long long rows, cols, entries = 0;
+    const char* q = readInteger(p, e, rows);
+    q = readInteger(q, e, cols);
+    if(header.coordinate)
+    {
+        q = readInteger(q, e, entries);
+    }
+    expectLineEnd(q, e);
+    if(rows != cols || rows < 0 || rows > std::numeric_limits<int>::max() || entries < 0)
+    {
+        throw std::invalid_argument("MatrixMarket matrix is not square");
+    }
+
+    header.n = static_cast<unsigned int>(rows);
+    if(header.coordinate)
+    {
+        header.entries = static_cast<std::size_t>(entries);
+    }
+    else
+    {
+        std::size_t n = header.n;
+        header.entries = (header.symmetry == 0) ? n * n : (header.symmetry == 1 ? n * (n + 1) / 2 : n * (n - 1) / 2);
+    }
+    header.body = (e < end) ? e + 1 : end;
+    return header;
+}
+
+/**
+    \brief Find position of k:th stored element of MatrixMarket array, elements are stored column by column and symmetric matrices store only lower triangle
+    \param header file header
+    \param k index of element
+    \param i row of element
+    \param j column of element
+*/
+static void arrayPosition(const MatrixMarketHeader& header, std::size_t k, unsigned int& i, unsigned int& j)
+{
+    std::size_t n = header.n;
+
+    if(header.symmetry == 0)
+    {
+        j = static_cast<unsigned int>(k / n);
+        i = static_cast<unsigned int>(k % n);
+        return;
+    }
+
+    std::size_t first = (header.symmetry == 1) ? 0 : 1;
+    j = 0;
+    while(k >= n - j - first)
+    {
+        k -= n - j - first;
+        j++;
+    }
+    i = static_cast<unsigned int>(j + first + k);
+}
+
+/**
+    \brief Find value of mirrored element of symmetric or skew-symmetric matrix
+    \param symmetry 1 for symmetric, -1 for skew-symmetric
+    \param value value of stored element
+    \throw std::invalid_argument if negated value does not fit in int
+    \return The value
+*/
+static int mirroredValue(int symmetry, int value)
+{
+    if(symmetry == -1 && value == std::numeric_limits<int>::min())
+    {
+        throw std::invalid_argument("Number in matrix file is too large");
+    }
+    return symmetry * value;
+}
+
+/**
+    \brief Read entries of coordinate MatrixMarket file, symmetric matrices get a mirrored entry after each stored one
+    \param header file header
+    \param chunks lines of the body
+    \throw std::invalid_argument if a line is not a valid entry
+    \return Entries in the order of the file
+*/
+static std::vector<SparseSquareMatrix::Entry> readCoordinateEntries(const MatrixMarketHeader& header, std::vector<TextChunk>& chunks)
+{
+    std::size_t per_line = (header.symmetry == 0) ? 1 : 2;
+    std::vector<SparseSquareMatrix::Entry> entries(header.entries * per_line);
+
+    runParallel(chunks, [&header, &entries, per_line](TextChunk& chunk)
+    {
+        forEachLine(chunk, [&](const char* p, const char* e, std::size_t line)
+        {
+            SparseSquareMatrix::Entry entry{0, 0, 1};
+            p = readIndex(p, e, header.n, entry.row);
+            p = readIndex(p, e, header.n, entry.column);
+            if(!header.pattern)
+            {
+                p = readValue(p, e, entry.value);
+            }
+            expectLineEnd(p, e);
+
+            entries[line * per_line] = entry;
+            if(per_line == 2)
+            {
+                int mirrored = (entry.row == entry.column) ? 0 : mirroredValue(header.symmetry, entry.value);
+                entries[line * per_line + 1] = SparseSquareMatrix::Entry{entry.column, entry.row, mirrored};
+            }
+        });
+    });
+    return entries;
+}
+
+static void parseMatrixMarketDense(const MatrixMarketHeader& header, std::vector<TextChunk>& chunks, std::vector<int>& values)
+{
+    std::size_t n = header.n;
+
+    if(header.coordinate)
+    {
+        // entries and mirrors may hit the same element, they are summed in one thread like in sparse import
+        for(const SparseSquareMatrix::Entry& entry: readCoordinateEntries(header, chunks))
+        {
+            int& element = values[entry.row * n + entry.column];
+            element = static_cast<int>(static_cast<unsigned int>(element) + static_cast<unsigned int>(entry.value));
+        }
+        return;
+    }
+
+    // every element of an array file has its own line, so threads never write the same element
+    runParallel(chunks, [&header, &values, n](TextChunk& chunk)
+    {
+        unsigned int i = 0;
+        unsigned int j = 0;
+
+        if(chunk.lines > 0)
+        {
+            arrayPosition(header, chunk.first_line, i, j);
+        }
+
+        forEachLine(chunk, [&](const char* p, const char* e, std::size_t)
+        {
+            int value = 1;
+            if(!header.pattern)
+            {
+                p = readValue(p, e, value);
+            }
+            expectLineEnd(p, e);
+
+            values[i * n + j] = value;
+            if(header.symmetry != 0 && i != j)
+            {
+                values[j * n + i] = mirroredValue(header.symmetry, value);
+            }
+
+            i++;
+            if(i == n)
+            {
+                j++;
+                i = (header.symmetry == 0) ? 0 : j + (header.symmetry == -1 ? 1 : 0);
+            }
+        });
+    });
+}
+
+ConcreteSquareMatrix importMatrixMarket(const std::string& path, unsigned int threads)
+{
+    MappedFile file(path);
+    const char* end = file.data() + file.size();
+    MatrixMarketHeader header = readMatrixMarketHeader(file.data(), end);
+    std::vector<TextChunk> chunks = splitLines(header.body, end, threads);
+
+    if(countLines(chunks) != header.entries)
+    {
+        throw std::invalid_argument("MatrixMarket file has wrong number of entries");
+    }
+
+    std::vector<int> values(static_cast<std::size_t>(header.n) * header.n, 0);
+    parseMatrixMarketDense(header, chunks, values);
+    return ConcreteSquareMatrix::fromValues(header.n, values.data());
+}
+
+SparseSquareMatrix importMatrixMarketSparse(const std::string& path, unsigned int threads)
+{
+    MappedFile file(path);
+    const char* end = file.data() + file.size();
+    MatrixMarketHeader header = readMatrixMarketHeader(file.data(), end);
+
+    if(!header.coordinate)
+    {
+        throw std::invalid_argument("Sparse import needs a coordinate MatrixMarket file");
+    }
+
+    std::vector<TextChunk> chunks = splitLines(header.body, end, threads);
+    if(countLines(chunks) != header.entries)
+    {
+        throw std::invalid_argument("MatrixMarket file has wrong number of entries");
+    }
+
+    return SparseSquareMatrix(header.n, readCoordinateEntries(header, chunks));
+}
+
+ConcreteSquareMatrix importCsv(const std::string& path, unsigned int threads)
+{
+    MappedFile file(path);
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+    std::vector<TextChunk> chunks = splitLines(begin, end, threads);
+    std::size_t n = countLines(chunks);
+
+    if(n == 0)
+    {
+        return ConcreteSquareMatrix();
+    }
+
+    std::vector<int> values(n * n);
+    runParallel(chunks, [&values, n](TextChunk& chunk)
+    {
+        forEachLine(chunk, [&values, n](const char* p, const char* e, std::size_t line)
+        {
+            int* row = values.data() + line * n;
+            for(std::size_t j = 0; j < n; j++)
+            {
+                if(j > 0)
+                {
+                    p = skipSpaces(p, e);
+                    if(p == e || *p != ',')
+                    {
+                        throw std::invalid_argument("CSV row has too few values");
+                    }
+                    p++;
+                }
+                p = readValue(p, e, row[j]);
+            }
+            expectLineEnd(p, e);
+        });
+    });
+
+    return ConcreteSquareMatrix::fromValues(static_cast<unsigned int>(n), values.data());
+}
+
+static void appendNumber(std::string& buffer, long long value)
+{
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    buffer.append(digits, result.ptr);
+}
+
+static void flushBuffer(std::ofstream& file, std::string& buffer, bool force)
+{
+    if(force || buffer.size() >= write_chunk_size)
+    {
+        file.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+}
+
+static std::ofstream openForWriting(const std::string& path)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if(!file)
+    {
+        throw std::runtime_error("Could not open file " + path);
+    }
+    return file;
+}
+
+static void finishWriting(std::ofstream& file, std::string& buffer, const std::string& path)
+{
+    flushBuffer(file, buffer, true);
+    if(!file)
+    {
+        throw std::runtime_error("Could not write file " + path);
+    }
+}
+
+void exportMatrixMarket(const std::string& path, const ConcreteSquareMatrix& m)
+{
+    std::size_t n = m.getSize();
+    std::vector<int> values(n * n);
+    std::ofstream file = openForWriting(path);
+    std::string buffer;
+
+    m.copyValues(values.data());
+    buffer.reserve(write_chunk_size + 64);
+    buffer += "%%MatrixMarket matrix array integer general\n";
+    appendNumber(buffer, n);
+    buffer += ' ';
+    appendNumber(buffer, n);
+    buffer += '\n';
+    for(std::size_t j = 0; j < n; j++)
+    {
+        for(std::size_t i = 0; i < n; i++)
+        {
+            appendNumber(buffer, values[i * n + j]);
+            buffer += '\n';
+            flushBuffer(file, buffer, false);
+        }
+    }
+    finishWriting(file, buffer, path);
+}
+
+void exportMatrixMarket(const std::string& path, const SparseSquareMatrix& m)
+{
+    std::ofstream file = openForWriting(path);
+    std::string buffer;
+    const auto& row_start = m.getRowStart();
+    const auto& columns = m.getColumns();
+    const auto& values = m.getValues();
+
+    buffer.reserve(write_chunk_size + 64);
+    buffer += "%%MatrixMarket matrix coordinate integer general\n";
+    appendNumber(buffer, m.getSize());
+    buffer += ' ';
+    appendNumber(buffer, m.getSize());
+    buffer += ' ';
+    appendNumber(buffer, m.nonZeros());
+    buffer += '\n';
+    for(std::size_t i = 0; i < m.getSize(); i++)
+    {
+        for(std::size_t k = row_start[i]; k < row_start[i + 1]; k++)
+        {
+            appendNumber(buffer, i + 1);
+            buffer += ' ';
+            appendNumber(buffer, columns[k] + 1);
+            buffer += ' ';
+            appendNumber(buffer, values[k]);
+            buffer += '\n';
+            flushBuffer(file, buffer, false);
+        }
+    }
+    finishWriting(file, buffer, path);
+}
+
+void exportCsv(const std::string& path, const ConcreteSquareMatrix& m)
+{
+    std::size_t n = m.getSize();
+    std::vector<int> values(n * n);
+    std::ofstream file = openForWriting(path);
+    std::string buffer;
+
+    m.copyValues(values.data());
+    buffer.reserve(write_chunk_size + 64);
+    for(std::size_t i = 0; i < n; i++)
+    {
+        for(std::size_t j = 0; j < n; j++)
+        {
+            if(j > 0)
+            {
+                buffer += ',';
+            }
+            appendNumber(buffer, values[i * n + j]);
+        }
+        buffer += '\n';
+        flushBuffer(file, buffer, false);
+    }
+    finishWriting(file, buffer, path);
+}
+
+/**
+    \brief Read comma separated values of one line
+    \param p start of line
+    \param e end of line
+    \param count number of values
+    \param store function called with index and value of each value
+*/
+template <typename Fn>
+static void readCsvLine(const char* p, const char* e, std::size_t count, Fn store)
+{
+    for(std::size_t k = 0; k < count; k++)
+    {
+        if(k > 0)
+        {
+            p = skipSpaces(p, e);
+            if(p == e || *p != ',')
+            {
+                throw std::invalid_argument("CSV line has too few values");
+            }
+            p++;
+        }
+        int value;
+        p = readValue(p, e, value);
+        store(k, value);
+    }
+    expectLineEnd(p, e);
+}
+
+MatrixBatch importBatchCsv(const std::string& path, unsigned int threads)
+{
+    MappedFile file(path);
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+    std::vector<TextChunk> chunks = splitLines(begin, end, threads);
+    std::size_t count = countLines(chunks);
+
+    if(count == 0)
+    {
+        return MatrixBatch();
+    }
+
+    // size of the matrices is decided by the first line
+    const char* first = begin;
+    while(skipSpaces(first, lineEnd(first, end)) == lineEnd(first, end))
+    {
+        first = lineEnd(first, end) + 1;
+    }
+    std::size_t values = 1 + std::count(first, lineEnd(first, end), ',');
+    unsigned int n = 0;
+    while(static_cast<std::size_t>(n + 1) * (n + 1) <= values)
+    {
+        n++;
+    }
+    if(static_cast<std::size_t>(n) * n != values)
+    {
+        throw std::invalid_argument("CSV line does not contain a square matrix");
+    }
+
+    MatrixBatch batch(n, count);
+    int* data = batch.element(0, 0);
+    runParallel(chunks, [data, values, count](TextChunk& chunk)
+    {
+        forEachLine(chunk, [data, values, count](const char* p, const char* e, std::size_t line)
+        {
+            readCsvLine(p, e, values, [data, count, line](std::size_t k, int value)
+            {
+                data[k * count + line] = value;
+            });
+        });
+    });
+    return batch;
+}
+
+void exportBatchCsv(const std::string& path, const MatrixBatch& batch)
+{
+    std::size_t values = static_cast<std::size_t>(batch.getSize()) * batch.getSize();
+    const int* data = batch.element(0, 0);
+    std::ofstream file = openForWriting(path);
+    std::string buffer;
+
+    buffer.reserve(write_chunk_size + 64);
+    for(std::size_t b = 0; b < batch.getCount(); b++)
+    {
+        for(std::size_t k = 0; k < values; k++)
+        {
+            if(k > 0)
+            {
+                buffer += ',';
+            }
+            appendNumber(buffer, data[k * batch.getCount() + b]);
+        }
+        buffer += '\n';
+        flushBuffer(file, buffer, false);
+    }
+    finishWriting(file, buffer, path);
+}
+
+BatchValuation importValuationsCsv(const std::string& path, unsigned int threads)
+{
+    MappedFile file(path);
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+    const char* header_end = lineEnd(begin, end);
+
+    std::vector<char> names;
+    for(const char* p = skipSpaces(begin, header_end); p < header_end; )
+    {
+        if(!std::isalpha(static_cast<unsigned char>(*p)))
+        {
+            throw std::invalid_argument("Variable names must be single letters");
+        }
+        names.push_back(*p);
+        p = skipSpaces(p + 1, header_end);
+        if(p < header_end && *p++ != ',')
+        {
+            throw std::invalid_argument("Variable names must be single letters");
+        }
+        p = skipSpaces(p, header_end);
+    }
+
+    const char* body = std::min(end, header_end + 1);
+    std::vector<TextChunk> chunks = splitLines(body, end, threads);
+    std::size_t count = countLines(chunks);
+    std::vector<std::vector<int>*> columns;
+    BatchValuation variables;
+    for(char name: names)
+    {
+        if(variables.count(name))
+        {
+            throw std::invalid_argument(std::string("Variable ") + name + " is given twice");
+        }
+        columns.push_back(&variables[name]);
+        columns.back()->resize(count);
+    }
+
+    runParallel(chunks, [&columns](TextChunk& chunk)
+    {
+        forEachLine(chunk, [&columns](const char* p, const char* e, std::size_t line)
+        {
+            readCsvLine(p, e, columns.size(), [&columns, line](std::size_t k, int value)
+            {
+                (*columns[k])[line] = value;
+            });
+        });
+    });
+    return variables;
+}
+
+static bool hasExtension(const std::string& path, const std::string& extension)
+{
+    if(path.size() < extension.size())
+    {
+        return false;
+    }
+    std::string end = path.substr(path.size() - extension.size());
+    std::transform(end.begin(), end.end(), end.begin(), [](unsigned char c) { return std::tolower(c); });
+    return end == extension;
+}
+
+ConcreteSquareMatrix importMatrix(const std::string& path)
+{
+    if(hasExtension(path, ".mtx"))
+    {
+        return importMatrixMarket(path);
+    }
+    if(hasExtension(path, ".csv"))
+    {
+        return importCsv(path);
+    }
+    throw std::invalid_argument("File name must end with .mtx or .csv");
+}
+
+void exportMatrix(const std::string& path, const ConcreteSquareMatrix& m)
+{
+    if(hasExtension(path, ".mtx"))
+    {
+        exportMatrixMarket(path, m);
+    }
+    else if(hasExtension(path, ".csv"))
+    {
+        exportCsv(path, m);
+    }
+    else
+    {
+        throw std::invalid_argument("File name must end with .mtx or .csv");
+    }
+}
+
+SparseSquareMatrix::SparseSquareMatrix(unsigned int size, const std::vector<Entry>& entries): n(size), row_start(size + 1, 0)
+{
+    std::vector<std::size_t> position;
+
+    for(const Entry& entry: entries)
+    {
+        if(entry.row >= n || entry.column >= n)
+        {
+            throw std::invalid_argument("Entry is outside the matrix");
+        }
+        row_start[entry.row + 1]++;
+    }
+    for(unsigned int i = 0; i < n; i++)
+    {
+        row_start[i + 1] += row_start[i];
+    }
+
+    position.assign(row_start.begin(), row_start.end() - 1);
+    columns.resize(entries.size());
+    values.resize(entries.size());
+    for(const Entry& entry: entries)
+    {
+        std::size_t k = position[entry.row]++;
+        columns[k] = entry.column;
+        values[k] = entry.value;
+    }
+
+    std::vector<std::pair<unsigned int, int>> row;
+    std::size_t out = 0;
+    for(unsigned int i = 0; i < n; i++)
+    {
+        row.clear();
+        for(std::size_t k = row_start[i]; k < row_start[i + 1]; k++)
+        {
+            row.emplace_back(columns[k], values[k]);
+        }
+        std::sort(row.begin(), row.end(), [](const std::pair<unsigned int, int>& a, const std::pair<unsigned int, int>& b)
+        {
+            return a.first < b.first;
+        });
+
+        row_start[i] = out;
+        for(std::size_t k = 0; k < row.size(); k++)
+        {
+            int sum = row[k].second;
+            while(k + 1 < row.size() && row[k + 1].first == row[k].first)
+            {
+                sum += row[++k].second;
+            }
+            if(sum != 0)
+            {
+                columns[out] = row[k].first;
+                values[out] = sum;
+                out++;
+            }
+        }
+    }
+    row_start[n] = out;
+    columns.resize(out);
+    values.resize(out);
+}
+
+int SparseSquareMatrix::valueAt(unsigned int i, unsigned int j) const
+{
+    auto first = columns.begin() + row_start[i];
+    auto last = columns.begin() + row_start[i + 1];
+    auto iter = std::lower_bound(first, last, j);
+
+    if(iter != last && *iter == j)
+    {
+        return values[iter - columns.begin()];
+    }
+    return 0;
+}
+
+ConcreteSquareMatrix SparseSquareMatrix::toConcrete() const
+{
+    std::vector<int> dense(static_cast<std::size_t>(n) * n, 0);
+
+    for(std::size_t i = 0; i < n; i++)
+    {
+        for(std::size_t k = row_start[i]; k < row_start[i + 1]; k++)
+        {
+            dense[i * n + columns[k]] = values[k];
+        }
+    }
+    return ConcreteSquareMatrix::fromValues(n, dense.data());
+}
+
+SparseSquareMatrix SparseSquareMatrix::fromConcrete(const ConcreteSquareMatrix& m)
+{
+    std::vector<Entry> entries;
+
+    for(unsigned int i = 0; i < m.getSize(); i++)
+    {
+        for(unsigned int j = 0; j < m.getSize(); j++)
+        {
+            int value = m.valueAt(i, j);
+            if(value != 0)
+            {
+                entries.push_back(Entry{i, j, value});
+            }
+        }
+    }
+    return SparseSquareMatrix(m.getSize(), entries);
+}
@@ -0,0 +1,220 @@
+/**
+    \file matrixio.h
+    \brief Header for MatrixMarket and CSV import and export, and SparseSquareMatrix class
+*/
+
+#ifndef MATRIXIO_H_INCLUDED
+#define MATRIXIO_H_INCLUDED
+#include "elementarymatrix.h"
+#include "matrixbatch.h"
+#include <string>
+#include <vector>
+
+/**
+    \class SparseSquareMatrix
+    \brief Square matrix of integers in compressed sparse row format, only non-zero elements are stored
+*/
+class SparseSquareMatrix
+{
+    public:
+
+        /**
+            \brief One matrix element given with its position
+        */
+        struct Entry
+        {
+            unsigned int row;
+            unsigned int column;
+            int value;
+        };
+
+    private:
+        unsigned int n;
+        std::vector<std::size_t> row_start;
+        std::vector<unsigned int> columns;
+        std::vector<int> values;
+    public:
+
+        /**
+            \brief Default constructor
+        */
+        SparseSquareMatrix(): n(0), row_start(1, 0){};
+
+        /**
+            \brief Parametric constructor, entries in same position are summed and zeros are dropped
+            \param size number of rows and columns
+            \param entries elements in any order, positions start from 0
+            \throw std::invalid_argument if an entry is outside the matrix
+        */
+        SparseSquareMatrix(unsigned int size, const std::vector<Entry>& entries);
+
+        /**
+            \brief Function to get size of matrix
+            \return Number of rows and columns
+        */
+        unsigned int getSize() const
+        {
+            return n;
+        }
+
+        /**
+            \brief Function to get number of stored elements
+            \return Number of non-zero elements
+        */
+        std::size_t nonZeros() const
+        {
+            return values.size();
+        }
+
+        /**
+            \brief Function to get value of element
+            \param i row index
+            \param j column index
+            \return Value of element, 0 if element is not stored
+        */
+        int valueAt(unsigned int i, unsigned int j) const;
+
+        /**
+            \brief Function to get where each row starts in column and value arrays
+            \return Vector of n+1 offsets
+        */
+        const std::vector<std::size_t>& getRowStart() const
+        {
+            return row_start;
+        }
+
+        /**
+            \brief Function to get column indices of stored elements
+            \return Vector of column indices, sorted inside each row
+        */
+        const std::vector<unsigned int>& getColumns() const
+        {
+            return columns;
+        }
+
+        /**
+            \brief Function to get values of stored elements
+            \return Vector of values in same order as columns
+        */
+        const std::vector<int>& getValues() const
+        {
+            return values;
+        }
+
+        /**
+            \brief Convert to dense matrix
+            \return ConcreteSquareMatrix object
+        */
+        ConcreteSquareMatrix toConcrete() const;
+
+        /**
+            \brief Make sparse matrix from non-zero elements of dense matrix
+            \param m matrix to convert
+            \return SparseSquareMatrix object
+        */
+        static SparseSquareMatrix fromConcrete(const ConcreteSquareMatrix& m);
+};
+
+/**
+    \brief Read integer MatrixMarket file (array or coordinate, general, symmetric or skew-symmetric), large files are parsed on several threads
+
+    Coordinate entries in the same position are summed, like in importMatrixMarketSparse.
+    \param path name of the file
+    \param threads number of chunks parsed in parallel, 0 uses the thread count of the global task scheduler
+    \throw std::runtime_error if file cannot be read
+    \throw std::invalid_argument if file is not a valid square integer MatrixMarket matrix
+    \return ConcreteSquareMatrix object
+*/
+ConcreteSquareMatrix importMatrixMarket(const std::string& path, unsigned int threads = 0);
+
+/**
+    \brief Read coordinate MatrixMarket file without making it dense, large files are parsed on several threads
+    \param path name of the file
+    \param threads number of chunks parsed in parallel, 0 uses the thread count of the global task scheduler
+    \throw std::runtime_error if file cannot be read
+    \throw std::invalid_argument if file is not a valid square integer coordinate MatrixMarket matrix
+    \return SparseSquareMatrix object
+*/
+SparseSquareMatrix importMatrixMarketSparse(const std::string& path, unsigned int threads = 0);
+
+/**
+    \brief Read matrix from CSV file with one row per line and values separated by commas, large files are parsed on several threads
+    \param path name of the file
+    \param threads number of chunks parsed in parallel, 0 uses the thread count of the global task scheduler
+    \throw std::runtime_error if file cannot be read
+    \throw std::invalid_argument if file does not contain a square integer matrix
+    \return ConcreteSquareMatrix object
+*/
+ConcreteSquareMatrix importCsv(const std::string& path, unsigned int threads = 0);
+
+/**
+    \brief Write matrix to MatrixMarket file in array format
+    \param path name of the file
+    \param m matrix to write
+    \throw std::runtime_error if file cannot be written
+*/
+void exportMatrixMarket(const std::string& path, const ConcreteSquareMatrix& m);
+
+/**
+    \brief Write sparse matrix to MatrixMarket file in coordinate format
+    \param path name of the file
+    \param m matrix to write
+    \throw std::runtime_error if file cannot be written
+*/
+void exportMatrixMarket(const std::string& path, const SparseSquareMatrix& m);
+
+/**
+    \brief Write matrix to CSV file with one row per line
+    \param path name of the file
+    \param m matrix to write
+    \throw std::runtime_error if file cannot be written
+*/
+void exportCsv(const std::string& path, const ConcreteSquareMatrix& m);
+
+/**
+    \brief Read batch of matrices from CSV file with one matrix per line, each line has the values of a matrix in row-major order
+    \param path name of the file
+    \param threads number of chunks parsed in parallel, 0 uses the thread count of the global task scheduler
+    \throw std::runtime_error if file cannot be read
+    \throw std::invalid_argument if lines do not contain square integer matrices of the same size
+    \return MatrixBatch object
+*/
+MatrixBatch importBatchCsv(const std::string& path, unsigned int threads = 0);
+
+/**
+    \brief Write batch of matrices to CSV file with one matrix per line
+    \param path name of the file
+    \param batch matrices to write
+    \throw std::runtime_error if file cannot be written
+*/
+void exportBatchCsv(const std::string& path, const MatrixBatch& batch);
+
+/**
+    \brief Read values of variables from CSV file, first line has the variable names and each following line one value of each
+    \param path name of the file
+    \param threads number of chunks parsed in parallel, 0 uses the thread count of the global task scheduler
+    \throw std::runtime_error if file cannot be read
+    \throw std::invalid_argument if names are not single characters or a line has the wrong number of values
+    \return BatchValuation object
+*/
+BatchValuation importValuationsCsv(const std::string& path, unsigned int threads = 0);
+
+/**
+    \brief Read matrix from file, format is chosen by file extension (.mtx or .csv)
+    \param path name of the file
+    \throw std::runtime_error if file cannot be read
+    \throw std::invalid_argument if extension is unknown or file is not valid
+    \return ConcreteSquareMatrix object
+*/
+ConcreteSquareMatrix importMatrix(const std::string& path);
+
+/**
+    \brief Write matrix to file, format is chosen by file extension (.mtx or .csv)
+    \param path name of the file
+    \param m matrix to write
+    \throw std::runtime_error if file cannot be written
+    \throw std::invalid_argument if extension is unknown
+*/
+void exportMatrix(const std::string& path, const ConcreteSquareMatrix& m);
+
+#endif // MATRIXIO_H_INCLUDED
@@ -0,0 +1,46 @@
+/**
+    \file matrixparser.cpp
+    \brief Code for MatrixStreamParser class
+*/
+
+#include "matrixparser.h"
+
+template<>
+std::vector<std::shared_ptr<IntElement>> MatrixStreamParser<IntElement>::makeRow(const std::vector<Token>& tokens)
+{
+    std::shared_ptr<std::vector<IntElement>> block = std::make_shared<std::vector<IntElement>>();
+    std::vector<std::shared_ptr<IntElement>> row;
+
+    block->reserve(tokens.size());
+    row.reserve(tokens.size());
+    for(const Token& token: tokens)
+    {
+        if(token.variable != 0)
+        {
+            fail();
+        }
+        block->emplace_back(token.number);
+        row.emplace_back(block, &block->back());
+    }
+    return row;
+}
+
+template<>
+std::vector<std::shared_ptr<Element>> MatrixStreamParser<Element>::makeRow(const std::vector<Token>& tokens)
+{
+    std::vector<std::shared_ptr<Element>> row;
+
+    row.reserve(tokens.size());
+    for(const Token& token: tokens)
+    {
+        if(token.variable != 0)
+        {
+            row.push_back(std::make_shared<VariableElement>(token.variable));
+        }
+        else
+        {
+            row.push_back(std::make_shared<IntElement>(token.number));
+        }
+    }
+    return row;
+}
@@ -0,0 +1,247 @@
+/**
+    \file matrixparser.h
+    \brief Header for MatrixStreamParser class
+*/
+
+#ifndef MATRIXPARSER_H_INCLUDED
+#define MATRIXPARSER_H_INCLUDED
+#include "elementarymatrix.h"
+#include <cctype>
+#include <functional>
+#include <istream>
+#include <stdexcept>
+#include <vector>
+
+/**
+    \class MatrixStreamParser
+    \brief Parser reading square matrix literals of form [[a11,...,a1n]...[an1,...,ann]] straight from a stream
+
+    Characters are taken from the stream buffer one at a time, so the literal is never copied
+    to a string and nothing after the closing bracket is consumed. Only the current row is
+    kept in addition to the elements already stored in the matrix.
+
+    \tparam T Type of Element-object (IntElement for ConcreteSquareMatrix, Element for SymbolicSquareMatrix)
+*/
+template <typename T>
+class MatrixStreamParser
+{
+    private:
+
+        /**
+            \brief One parsed matrix entry, variable is 0 for numbers
+        */
+        struct Token
+        {
+            int number;
+            char variable;
+        };
+
+        std::streambuf* buf;
+        std::size_t consumed = 0;
+        std::size_t report_interval;
+        std::size_t next_report;
+        std::function<void(std::size_t)> progress;
+        std::vector<Token> row_tokens;
+
+        /**
+            \brief Take next character from stream
+            \return The character, or EOF
+        */
+        int next()
+        {
+            int c = buf->sbumpc();
+            if(c != std::char_traits<char>::eof() && ++consumed >= next_report)
+            {
+                next_report += report_interval;
+                if(progress)
+                {
+                    progress(consumed);
+                }
+            }
+            return c;
+        }
+
+        /**
+            \brief Skip whitespace and look at next character without taking it
+            \return The character, or EOF
+        */
+        int peekNonSpace()
+        {
+            int c = buf->sgetc();
+            while(c == ' ' || c == '\t' || c == '\n' || c == '\r')
+            {
+                next();
+                c = buf->sgetc();
+            }
+            return c;
+        }
+
+        /**
+            \brief Take next non-whitespace character and check that it is the expected one
+            \param expected character that must come next
+            \throw std::invalid_argument if character is something else
+        */
+        void expect(char expected)
+        {
+            if(peekNonSpace() != expected)
+            {
+                fail();
+            }
+            next();
+        }
+
+        /**
+            \brief Report syntax error
+            \throw std::invalid_argument always
+        */
+        [[noreturn]] void fail() const
+        {
+            throw std::invalid_argument("String must be in format [[a11,...,a1n]...[an1,...ann]]");
+        }
+
+        /**
+            \brief Read one matrix entry
+            \return The entry
+            \throw std::invalid_argument if entry is not an integer or a single letter
+        */
+        Token readToken()
+        {
+            int c = peekNonSpace();
+            Token token{0, 0};
+
+            if(std::isalpha(c))
+            {
+                token.variable = static_cast<char>(next());
+                return token;
+            }
+
+            bool negative = false;
+            if(c == '-' || c == '+')
+            {
+                negative = (c == '-');
+                next();
+                c = buf->sgetc();
+            }
+            if(!std::isdigit(c))
+            {
+                fail();
+            }
+
+            long long value = 0;
+            while(std::isdigit(c))
+            {
+                value = value * 10 + (next() - '0');
+                if(value > 2147483648LL)
+                {
+                    fail();
+                }
+                c = buf->sgetc();
+            }
+            if(negative)
+            {
+                value = -value;
+            }
+            if(value > 2147483647LL)
+            {
+                fail();
+            }
+            token.number = static_cast<int>(value);
+            return token;
+        }
+
+        /**
+            \brief Convert tokens of one row to elements
+            \param tokens parsed entries of the row
+            \return Row of elements
+            \throw std::invalid_argument if row has entries the matrix type cannot hold
+        */
+        std::vector<std::shared_ptr<T>> makeRow(const std::vector<Token>& tokens);
+
+    public:
+
+        /**
+            \brief Parametric constructor
+            \param is stream to read from
+            \param callback function called with number of characters read so far, may be empty
+            \param interval how many characters are read between calls to callback
+        */
+        MatrixStreamParser(std::istream& is, std::function<void(std::size_t)> callback = nullptr, std::size_t interval = 1 << 24):
+            buf(is.rdbuf()), report_interval(interval), next_report(interval), progress(std::move(callback)){};
+
+        /**
+            \brief Read one matrix literal from stream, reading stops after the closing bracket
+            \throw std::invalid_argument if input is not a square matrix
+            \return Matrix object
+        */
+        ElementarySquareMatrix<T> parse()
+        {
+            std::vector<std::vector<std::shared_ptr<T>>> elems;
+            ElementarySquareMatrix<T> sq;
+            std::size_t n = 0;
+
+            expect('[');
+            expect('[');
+            while(true)
+            {
+                row_tokens.clear();
+                if(n > 0)
+                {
+                    row_tokens.reserve(n);
+                }
+                while(true)
+                {
+                    row_tokens.push_back(readToken());
+                    int c = peekNonSpace();
+                    next();
+                    if(c == ']')
+                    {
+                        break;
+                    }
+                    if(c != ',')
+                    {
+                        fail();
+                    }
+                }
+
+                if(n == 0)
+                {
+                    n = row_tokens.size();
+                    elems.reserve(n);
+                }
+                if(row_tokens.size() != n || elems.size() == n)
+                {
+                    fail();
+                }
+                elems.push_back(makeRow(row_tokens));
+
+                int c = peekNonSpace();
+                next();
+                if(c == ']')
+                {
+                    break;
+                }
+                if(c != '[')
+                {
+                    fail();
+                }
+            }
+
+            if(elems.size() != n)
+            {
+                fail();
+            }
+            sq.setVector(std::move(elems));
+            return sq;
+        }
+
+        /**
+            \brief Function to get number of characters read
+            \return Number of characters
+        */
+        std::size_t charactersRead() const
+        {
+            return consumed;
+        }
+};
+
+#endif // MATRIXPARSER_H_INCLUDED
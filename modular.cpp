@@ -0,0 +1,190 @@
+/**
+    \file modular.cpp
+    \brief Code for matrix arithmetic modulo an integer
+*/
+
+#include "modular.h"
+#include "kernels.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+/// Number of rows of C that share one block of B in modularMultiply
+static const unsigned int modular_row_block = 16;
+
+Modulus::Modulus(std::uint32_t modulus): p(modulus)
+{
+    if(p < 2)
+    {
+        throw std::invalid_argument("Modulus must be at least 2");
+    }
+    barrett = std::numeric_limits<std::uint64_t>::max() / p;
+}
+
+std::uint64_t Modulus::lazyProducts() const
+{
+    std::uint64_t largest = p - 1;
+    return (std::numeric_limits<std::uint64_t>::max() - largest) / (largest * largest);
+}
+
+void modularMultiply(unsigned int n, const std::uint32_t* a, const std::uint32_t* b, std::uint32_t* c, const Modulus& mod,
+                     Progress* progress)
+{
+    const std::size_t depth_block = static_cast<std::size_t>(std::min<std::uint64_t>(mod.lazyProducts(), kernel_depth_block));
+    std::vector<std::uint64_t> acc(modular_row_block * kernel_column_block);
+    // rows are gone through once for every block of columns
+    if(progress)
+        progress->setTotal(static_cast<std::size_t>(n) * ((n + kernel_column_block - 1) / kernel_column_block));
+
+    for(std::size_t j0 = 0; j0 < n; j0 += kernel_column_block)
+    {
+        std::size_t width = std::min<std::size_t>(n - j0, kernel_column_block);
+        for(std::size_t i0 = 0; i0 < n; i0 += modular_row_block)
+        {
+            std::size_t height = std::min<std::size_t>(n - i0, modular_row_block);
+            if(progress)
+                progress->check();
+            std::fill(acc.begin(), acc.end(), 0);
+
+            for(std::size_t k0 = 0; k0 < n; k0 += depth_block)
+            {
+                std::size_t k1 = std::min<std::size_t>(n, k0 + depth_block);
+                for(std::size_t i = 0; i < height; i++)
+                {
+                    std::uint64_t* acc_row = &acc[i * kernel_column_block];
+                    const std::uint32_t* a_row = a + (i0 + i) * n;
+                    for(std::size_t k = k0; k < k1; k++)
+                    {
+                        const std::uint64_t factor = a_row[k];
+                        const std::uint32_t* b_row = b + k * n + j0;
+                        for(std::size_t j = 0; j < width; j++)
+                        {
+                            acc_row[j] += factor * b_row[j];
+                        }
+                    }
+                    // reduce once per block of depth so the next block cannot overflow
+                    for(std::size_t j = 0; j < width; j++)
+                    {
+                        acc_row[j] = mod.reduce(acc_row[j]);
+                    }
+                }
+            }
+
+            for(std::size_t i = 0; i < height; i++)
+            {
+                std::copy_n(&acc[i * kernel_column_block], width, c + (i0 + i) * n + j0);
+            }
+            if(progress)
+                progress->advance(height);
+        }
+    }
+}
+
+std::vector<std::uint32_t> reducedValues(const ConcreteSquareMatrix& m, const Modulus& mod)
+{
+    if(mod.getValue() > 2147483648u)
+    {
+        throw std::invalid_argument("Modulus must be at most 2^31");
+    }
+
+    std::vector<int> values(static_cast<std::size_t>(m.getSize()) * m.getSize());
+    m.copyValues(values.data());
+
+    std::vector<std::uint32_t> reduced(values.size());
+    for(std::size_t i = 0; i < values.size(); i++)
+    {
+        reduced[i] = mod.fromInt(values[i]);
+    }
+    return reduced;
+}
+
+ConcreteSquareMatrix fromReduced(unsigned int n, const std::vector<std::uint32_t>& values)
+{
+    return ConcreteSquareMatrix::fromValues(n, reinterpret_cast<const int*>(values.data()));
+}
+
+ConcreteSquareMatrix modularAdd(const ConcreteSquareMatrix& m1, const ConcreteSquareMatrix& m2, const Modulus& mod)
+{
+    if(m1.getSize() != m2.getSize())
+    {
+        throw std::invalid_argument("Matrices are not the same size");
+    }
+
+    std::vector<std::uint32_t> a = reducedValues(m1, mod);
+    std::vector<std::uint32_t> b = reducedValues(m2, mod);
+    for(std::size_t i = 0; i < a.size(); i++)
+    {
+        a[i] = mod.add(a[i], b[i]);
+    }
+    return fromReduced(m1.getSize(), a);
+}
+
+ConcreteSquareMatrix modularSubtract(const ConcreteSquareMatrix& m1, const ConcreteSquareMatrix& m2, const Modulus& mod)
+{
+    if(m1.getSize() != m2.getSize())
+    {
+        throw std::invalid_argument("Matrices are not the same size");
+    }
+
+    std::vector<std::uint32_t> a = reducedValues(m1, mod);
+    std::vector<std::uint32_t> b = reducedValues(m2, mod);
+    for(std::size_t i = 0; i < a.size(); i++)
+    {
+        a[i] = mod.subtract(a[i], b[i]);
+    }
+    return fromReduced(m1.getSize(), a);
+}
+
+ConcreteSquareMatrix modularMultiply(const ConcreteSquareMatrix& m1, const ConcreteSquareMatrix& m2, const Modulus& mod, Progress* progress)
+{
+    unsigned int n = m1.getSize();
+    if(n != m2.getSize())
+    {
+        throw std::invalid_argument("Matrices are not the same size");
+    }
+
+    std::vector<std::uint32_t> a = reducedValues(m1, mod);
+    std::vector<std::uint32_t> b = reducedValues(m2, mod);
+    std::vector<std::uint32_t> c(a.size());
+    modularMultiply(n, a.data(), b.data(), c.data(), mod, progress);
+    return fromReduced(n, c);
+}
+
+ConcreteSquareMatrix modularPower(const ConcreteSquareMatrix& m, unsigned long long e, const Modulus& mod, Progress* progress)
+{
+    unsigned int n = m.getSize();
+    std::vector<std::uint32_t> base = reducedValues(m, mod);
+    std::vector<std::uint32_t> result(base.size(), 0);
+    std::vector<std::uint32_t> temp(base.size());
+    bool identity = true;
+
+    for(unsigned int i = 0; i < n; i++)
+    {
+        result[static_cast<std::size_t>(i) * n + i] = mod.reduce(1);
+    }
+
+    while(e != 0)
+    {
+        if(e & 1)
+        {
+            if(identity)
+            {
+                result = base;
+                identity = false;
+            }
+            else
+            {
+                modularMultiply(n, result.data(), base.data(), temp.data(), mod, progress);
+                result.swap(temp);
+            }
+        }
+        e >>= 1;
+        if(e != 0)
+        {
+            modularMultiply(n, base.data(), base.data(), temp.data(), mod, progress);
+            base.swap(temp);
+        }
+    }
+    return fromReduced(n, result);
+}
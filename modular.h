@@ -0,0 +1,167 @@
+/**
+    \file modular.h
+    \brief Header for matrix arithmetic modulo an integer
+*/
+
+#ifndef MODULAR_H_INCLUDED
+#define MODULAR_H_INCLUDED
+#include "elementarymatrix.h"
+#include "progress.h"
+#include <cstdint>
+#include <vector>
+
+/**
+    \class Modulus
+    \brief Modulus with precomputed Barrett constant, reduces 64-bit numbers without division
+*/
+class Modulus
+{
+    private:
+        std::uint32_t p;
+        std::uint64_t barrett;
+    public:
+
+        /**
+            \brief Parametric constructor
+            \param modulus the modulus
+            \throw std::invalid_argument if modulus is smaller than 2
+        */
+        explicit Modulus(std::uint32_t modulus);
+
+        /**
+            \brief Function to get the modulus
+            \return The modulus
+        */
+        std::uint32_t getValue() const
+        {
+            return p;
+        }
+
+        /**
+            \brief Reduce 64-bit number
+            \param x number to reduce
+            \return x mod p
+        */
+        std::uint32_t reduce(std::uint64_t x) const
+        {
+#ifdef __SIZEOF_INT128__
+            std::uint64_t q = static_cast<std::uint64_t>((static_cast<unsigned __int128>(x) * barrett) >> 64);
+            std::uint64_t r = x - q * p;
+            return static_cast<std::uint32_t>(r >= p ? r - p : r);
+#else
+            return static_cast<std::uint32_t>(x % p);
+#endif
+        }
+
+        /**
+            \brief Map integer to range 0..p-1
+            \param v integer
+            \return v mod p
+        */
+        std::uint32_t fromInt(long long v) const
+        {
+            long long r = v % static_cast<long long>(p);
+            return static_cast<std::uint32_t>(r < 0 ? r + p : r);
+        }
+
+        std::uint32_t add(std::uint32_t a, std::uint32_t b) const
+        {
+            std::uint64_t s = static_cast<std::uint64_t>(a) + b;
+            return static_cast<std::uint32_t>(s >= p ? s - p : s);
+        }
+
+        std::uint32_t subtract(std::uint32_t a, std::uint32_t b) const
+        {
+            return a >= b ? a - b : a + (p - b);
+        }
+
+        std::uint32_t multiply(std::uint32_t a, std::uint32_t b) const
+        {
+            return reduce(static_cast<std::uint64_t>(a) * b);
+        }
+
+        /**
+            \brief Tell how many products of reduced numbers can be added to a reduced number without overflowing 64 bits
+            \return The number
+        */
+        std::uint64_t lazyProducts() const;
+};
+
+/**
+    \brief Calculate C = A*B mod p for n x n row-major arrays of reduced numbers
+
+    Products are accumulated in 64 bits and reduced once per block of depth, the
+    innermost loop runs along contiguous rows and can be vectorized.
+    \param n number of rows and columns
+    \param a first matrix
+    \param b second matrix
+    \param c result, must not overlap a or b
+    \param mod the modulus
+    \param progress progress reported by rows and checked for cancellation, may be nullptr
+    \throw OperationCancelled if progress is cancelled
+*/
+void modularMultiply(unsigned int n, const std::uint32_t* a, const std::uint32_t* b, std::uint32_t* c, const Modulus& mod,
+                     Progress* progress = nullptr);
+
+/**
+    \brief Copy values of matrix reduced modulo p to contiguous array
+    \param m the matrix
+    \param mod the modulus, at most 2^31
+    \throw std::invalid_argument if modulus is too large
+    \return Row-major array of values 0..p-1
+*/
+std::vector<std::uint32_t> reducedValues(const ConcreteSquareMatrix& m, const Modulus& mod);
+
+/**
+    \brief Build matrix of reduced values, values below 2^31 fit in IntElement
+    \param n number of rows and columns
+    \param values row-major array of values 0..p-1
+    \return ConcreteSquareMatrix object
+*/
+ConcreteSquareMatrix fromReduced(unsigned int n, const std::vector<std::uint32_t>& values);
+
+/**
+    \brief Add two matrices modulo p
+    \param m1 first matrix
+    \param m2 second matrix
+    \param mod the modulus, at most 2^31
+    \throw std::invalid_argument if matrices are not the same size or modulus is too large
+    \return ConcreteSquareMatrix object with values 0..p-1
+*/
+ConcreteSquareMatrix modularAdd(const ConcreteSquareMatrix& m1, const ConcreteSquareMatrix& m2, const Modulus& mod);
+
+/**
+    \brief Subtract two matrices modulo p
+    \param m1 first matrix
+    \param m2 second matrix
+    \param mod the modulus, at most 2^31
+    \throw std::invalid_argument if matrices are not the same size or modulus is too large
+    \return ConcreteSquareMatrix object with values 0..p-1
+*/
+ConcreteSquareMatrix modularSubtract(const ConcreteSquareMatrix& m1, const ConcreteSquareMatrix& m2, const Modulus& mod);
+
+/**
+    \brief Multiply two matrices modulo p
+    \param m1 first matrix
+    \param m2 second matrix
+    \param mod the modulus, at most 2^31
+    \param progress progress reported by rows and checked for cancellation, may be nullptr
+    \throw std::invalid_argument if matrices are not the same size or modulus is too large
+    \throw OperationCancelled if progress is cancelled
+    \return ConcreteSquareMatrix object with values 0..p-1
+*/
+ConcreteSquareMatrix modularMultiply(const ConcreteSquareMatrix& m1, const ConcreteSquareMatrix& m2, const Modulus& mod, Progress* progress = nullptr);
+
+/**
+    \brief Raise matrix to a power modulo p with repeated squaring
+    \param m the matrix
+    \param e the exponent, 0 gives identity matrix
+    \param mod the modulus, at most 2^31
+    \param progress progress reported by rows of each multiplication and checked for cancellation, may be nullptr
+    \throw std::invalid_argument if modulus is too large
+    \throw OperationCancelled if progress is cancelled
+    \return ConcreteSquareMatrix object with values 0..p-1
+*/
+ConcreteSquareMatrix modularPower(const ConcreteSquareMatrix& m, unsigned long long e, const Modulus& mod, Progress* progress = nullptr);
+
+#endif // MODULAR_H_INCLUDED
@@ -0,0 +1,120 @@
+/**
+    \file progress.h
+    \brief Header for Progress and OperationCancelled classes
+*/
+
+#ifndef PROGRESS_H_INCLUDED
+#define PROGRESS_H_INCLUDED
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+
+/**
+    \class OperationCancelled
+    \brief Exception thrown by an operation that noticed it was cancelled
+*/
+class OperationCancelled : public std::runtime_error
+{
+    public:
+
+        /**
+            \brief Default constructor
+        */
+        OperationCancelled(): std::runtime_error("Operation was cancelled") {}
+};
+
+/**
+    \class Progress
+    \brief Progress of a long operation shared with the thread that watches it
+
+    The operation sets the total amount of work, advances the counter and calls check()
+    between units of work, the watching thread reads the counters and may cancel.
+    Every member is a lock-free atomic, so cancel() may be called from a signal handler.
+*/
+class Progress
+{
+    private:
+        std::atomic<std::size_t> done{0};
+        std::atomic<std::size_t> total{0};
+        std::atomic<bool> cancelled{false};
+
+    public:
+
+        /**
+            \brief Prepare for a new operation, counters and cancellation are cleared
+        */
+        void reset()
+        {
+            done = 0;
+            total = 0;
+            cancelled = false;
+        }
+
+        /**
+            \brief Start new stage of work, counter is reset
+            \param units amount of work in the stage
+        */
+        void setTotal(std::size_t units)
+        {
+            done = 0;
+            total = units;
+        }
+
+        /**
+            \brief Record finished work
+            \param units amount of work finished
+        */
+        void advance(std::size_t units = 1)
+        {
+            done += units;
+        }
+
+        /**
+            \brief Function to get finished work
+            \return Amount of work finished in the current stage
+        */
+        std::size_t getDone() const
+        {
+            return done;
+        }
+
+        /**
+            \brief Function to get total work
+            \return Amount of work in the current stage, 0 if not known yet
+        */
+        std::size_t getTotal() const
+        {
+            return total;
+        }
+
+        /**
+            \brief Ask operation to stop at its next check
+        */
+        void cancel()
+        {
+            cancelled = true;
+        }
+
+        /**
+            \brief Function to check if operation was asked to stop
+            \return true if cancel() has been called
+        */
+        bool isCancelled() const
+        {
+            return cancelled;
+        }
+
+        /**
+            \brief Stop operation if it was cancelled
+            \throw OperationCancelled if cancel() has been called
+        */
+        void check() const
+        {
+            if(cancelled)
+            {
+                throw OperationCancelled();
+            }
+        }
+};
+
+#endif // PROGRESS_H_INCLUDED
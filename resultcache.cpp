@@ -0,0 +1,199 @@
+/**
+    \file resultcache.cpp
+    \brief Code for ResultCache class
+*/
+
+#include "resultcache.h"
+#include "elementarymatrix.h"
+#include "exactmatrix.h"
+
+std::uint64_t valuationHash(const Valuation& v)
+{
+    std::uint64_t h = hashCombine(0, v.size());
+    for(const auto& binding : v)
+    {
+        h = hashCombine(h, static_cast<unsigned char>(binding.first));
+        h = hashCombine(h, static_cast<std::uint32_t>(binding.second));
+    }
+    return h;
+}
+
+std::size_t approximateSize(const SquareMatrix& m)
+{
+    if(const ConcreteSquareMatrix* cm = dynamic_cast<const ConcreteSquareMatrix*>(&m))
+    {
+        std::size_t n = cm->getSize();
+        return sizeof(ConcreteSquareMatrix) + n * sizeof(std::vector<std::shared_ptr<IntElement>>)
+               + n * n * (sizeof(std::shared_ptr<IntElement>) + sizeof(IntElement));
+    }
+    if(const SymbolicSquareMatrix* sm = dynamic_cast<const SymbolicSquareMatrix*>(&m))
+    {
+        std::size_t n = sm->getSize();
+        return sizeof(SymbolicSquareMatrix) + n * sizeof(std::vector<std::shared_ptr<Element>>)
+               + n * n * (sizeof(std::shared_ptr<Element>) + sizeof(CompositeElement));
+    }
+    if(const ExactSquareMatrix* em = dynamic_cast<const ExactSquareMatrix*>(&m))
+    {
+        std::size_t n = em->getSize();
+        return sizeof(ExactSquareMatrix) + n * n * sizeof(long long) + em->getPromoted().size() * 64;
+    }
+    return sizeof(SquareMatrix);
+}
+
+std::size_t ResultCache::KeyHash::operator()(const Key& k) const
+{
+    return static_cast<std::size_t>(hashCombine(hashCombine(static_cast<std::uint64_t>(k.op), k.first), k.second));
+}
+
+ResultCache::ResultCache(std::size_t bytes): budget(bytes)
+{
+}
+
+void ResultCache::shrink()
+{
+    while(usage > budget && !entries.empty())
+    {
+        usage -= entries.back().size;
+        index.erase(entries.back().key);
+        entries.pop_back();
+        evictions++;
+    }
+}
+
+ResultCache::Key ResultCache::makeKey(CachedOperation op, const SquareMatrix& first, const SquareMatrix* second, const Valuation& v,
+                                      std::uint64_t mode)
+{
+    return Key{op, hashCombine(hashCombine(first.contentHash(), valuationHash(v)), mode), second ? second->contentHash() : 0};
+}
+
+std::shared_ptr<SquareMatrix> ResultCache::find(CachedOperation op, const SquareMatrix& first, const SquareMatrix* second, const Valuation& v,
+                                                std::uint64_t mode)
+{
+    Key key = makeKey(op, first, second, v, mode);
+    Entry candidate;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = index.find(key);
+        if(found == index.end())
+        {
+            misses++;
+            return nullptr;
+        }
+        candidate = *found->second;
+    }
+
+    // operands are compared without the lock, copies that share elements with them compare in constant time
+    bool same = candidate.mode == mode && candidate.valuation == v && first.sameContent(*candidate.first)
+                && (second == nullptr ? candidate.second == nullptr : candidate.second != nullptr && second->sameContent(*candidate.second));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if(!same)
+    {
+        misses++;
+        return nullptr;
+    }
+    hits++;
+    auto found = index.find(key);
+    if(found != index.end() && found->second->result == candidate.result)
+        entries.splice(entries.begin(), entries, found->second);
+    return candidate.result;
+}
+
+void ResultCache::insert(CachedOperation op, const SquareMatrix& first, const SquareMatrix* second, const Valuation& v, std::uint64_t mode,
+                         std::shared_ptr<SquareMatrix> result)
+{
+    Key key = makeKey(op, first, second, v, mode);
+    std::shared_ptr<const SquareMatrix> first_copy(first.clone());
+    std::shared_ptr<const SquareMatrix> second_copy(second ? second->clone() : nullptr);
+    std::size_t bytes = approximateSize(*result) + approximateSize(*first_copy) + (second_copy ? approximateSize(*second_copy) : 0);
+    // results are hashed by the thread that made them, other sessions only read the hash
+    result->contentHash();
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto found = index.find(key);
+    if(found != index.end())
+    {
+        usage -= found->second->size;
+        entries.erase(found->second);
+        index.erase(found);
+    }
+    if(bytes > budget)
+        return;
+
+    entries.push_front(Entry{key, std::move(result), std::move(first_copy), std::move(second_copy), v, mode, bytes});
+    index.emplace(key, entries.begin());
+    usage += bytes;
+    shrink();
+}
+
+void ResultCache::erase(CachedOperation op)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for(auto it = entries.begin(); it != entries.end(); )
+    {
+        if(it->key.op == op)
+        {
+            usage -= it->size;
+            index.erase(it->key);
+            it = entries.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void ResultCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    index.clear();
+    usage = 0;
+    hits = 0;
+    misses = 0;
+    evictions = 0;
+}
+
+void ResultCache::setBudget(std::size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    budget = bytes;
+    shrink();
+}
+
+std::size_t ResultCache::getBudget() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return budget;
+}
+
+std::size_t ResultCache::getUsage() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return usage;
+}
+
+std::size_t ResultCache::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+std::size_t ResultCache::getHits() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return hits;
+}
+
+std::size_t ResultCache::getMisses() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return misses;
+}
+
+std::size_t ResultCache::getEvictions() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return evictions;
+}
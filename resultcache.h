@@ -0,0 +1,194 @@
+/**
+    \file resultcache.h
+    \brief Header for ResultCache class
+*/
+
+#ifndef RESULTCACHE_H_INCLUDED
+#define RESULTCACHE_H_INCLUDED
+#include "squarematrix.h"
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+/**
+    \brief Operations whose results are kept in ResultCache
+*/
+enum class CachedOperation : std::uint8_t
+{
+    Add,
+    Subtract,
+    Multiply,
+    Transpose,
+    Evaluate
+};
+
+/**
+    \brief Calculate 64-bit hash of variable values, used to tell apart results computed with different valuations
+    \param v map where variable values are stored
+    \return The hash
+*/
+std::uint64_t valuationHash(const Valuation& v);
+
+/**
+    \brief Estimate memory used by a matrix
+    \param m matrix to estimate
+    \return Approximate size in bytes
+*/
+std::size_t approximateSize(const SquareMatrix& m);
+
+/**
+    \class ResultCache
+    \brief Bounded least recently used cache of operation results
+
+    Results are found by operation and content hashes of the operands. Hashes are not
+    trusted: copies of the operands are kept with each result and compared on every hit,
+    so colliding or forged hashes only cause misses.
+*/
+class ResultCache
+{
+    private:
+        struct Key
+        {
+            CachedOperation op;
+            std::uint64_t first;
+            std::uint64_t second;
+
+            bool operator==(const Key& k) const
+            {
+                return op == k.op && first == k.first && second == k.second;
+            }
+        };
+
+        struct KeyHash
+        {
+            std::size_t operator()(const Key& k) const;
+        };
+
+        struct Entry
+        {
+            Key key;
+            std::shared_ptr<SquareMatrix> result;
+            std::shared_ptr<const SquareMatrix> first;
+            std::shared_ptr<const SquareMatrix> second;
+            Valuation valuation;
+            std::uint64_t mode;
+            std::size_t size;
+        };
+
+        mutable std::mutex mutex;
+        std::list<Entry> entries;
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+        std::size_t budget;
+        std::size_t usage = 0;
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        std::size_t evictions = 0;
+
+        /**
+            \brief Remove least recently used entries until usage fits in budget
+        */
+        void shrink();
+
+        /**
+            \brief Calculate key of operation
+            \param op operation
+            \param first first operand
+            \param second second operand, nullptr for operations of one matrix
+            \param v variable values the result was calculated with
+            \param mode modulus, or other value telling how result was calculated
+            \return The key
+        */
+        static Key makeKey(CachedOperation op, const SquareMatrix& first, const SquareMatrix* second, const Valuation& v, std::uint64_t mode);
+
+    public:
+
+        /**
+            \brief Parametric constructor
+            \param bytes memory budget of cached results in bytes
+        */
+        explicit ResultCache(std::size_t bytes = std::size_t(256) << 20);
+
+        ResultCache(const ResultCache&) = delete;
+        ResultCache& operator=(const ResultCache&) = delete;
+
+        /**
+            \brief Find cached result and mark it most recently used, operands of the result are compared with the given ones
+            \param op operation
+            \param first first operand
+            \param second second operand, nullptr for operations of one matrix
+            \param v variable values
+            \param mode modulus, or other value telling how result is calculated
+            \return Pointer to result, nullptr if result is not in cache
+        */
+        std::shared_ptr<SquareMatrix> find(CachedOperation op, const SquareMatrix& first, const SquareMatrix* second, const Valuation& v,
+                                           std::uint64_t mode = 0);
+
+        /**
+            \brief Add result to cache with copies of its operands, least recently used results are dropped to stay in budget
+            \param op operation
+            \param first first operand
+            \param second second operand, nullptr for operations of one matrix
+            \param v variable values the result was calculated with
+            \param mode modulus, or other value telling how result was calculated
+            \param result result of the operation, must not be modified afterwards, its hash is calculated before it is shared
+        */
+        void insert(CachedOperation op, const SquareMatrix& first, const SquareMatrix* second, const Valuation& v, std::uint64_t mode,
+                    std::shared_ptr<SquareMatrix> result);
+
+        /**
+            \brief Remove all cached results of an operation
+            \param op operation
+        */
+        void erase(CachedOperation op);
+
+        /**
+            \brief Remove all cached results and reset counters
+        */
+        void clear();
+
+        /**
+            \brief Change memory budget, results are dropped if they do not fit anymore
+            \param bytes memory budget in bytes
+        */
+        void setBudget(std::size_t bytes);
+
+        /**
+            \brief Function to get memory budget
+            \return Budget in bytes
+        */
+        std::size_t getBudget() const;
+
+        /**
+            \brief Function to get approximate memory used by cached results
+            \return Usage in bytes
+        */
+        std::size_t getUsage() const;
+
+        /**
+            \brief Function to get number of cached results
+            \return The number
+        */
+        std::size_t size() const;
+
+        /**
+            \brief Function to get number of successful lookups
+            \return The number
+        */
+        std::size_t getHits() const;
+
+        /**
+            \brief Function to get number of failed lookups
+            \return The number
+        */
+        std::size_t getMisses() const;
+
+        /**
+            \brief Function to get number of results dropped to stay in budget
+            \return The number
+        */
+        std::size_t getEvictions() const;
+};
+
+#endif // RESULTCACHE_H_INCLUDED
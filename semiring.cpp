@@ -0,0 +1,188 @@
+/**
+    \file semiring.cpp
+    \brief Code for matrix multiplication over semirings
+*/
+
+#include "semiring.h"
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template <>
+void semiringMultiply<BooleanSemiring>(unsigned int n, const std::uint8_t* a, const std::uint8_t* b, std::uint8_t* c, Progress* progress)
+{
+    const std::size_t words = (n + 63) / 64;
+    std::vector<std::uint64_t> rows(n * words, 0);
+    std::vector<std::uint64_t> columns(n * words, 0);
+    for(std::size_t i = 0; i < n; i++)
+    {
+        for(std::size_t k = 0; k < n; k++)
+        {
+            if(a[i * n + k] != 0)
+                rows[i * words + k / 64] |= std::uint64_t(1) << (k % 64);
+            if(b[i * n + k] != 0)
+                columns[k * words + i / 64] |= std::uint64_t(1) << (i % 64);
+        }
+    }
+    if(progress)
+        progress->setTotal(n);
+
+    auto work = [&](std::size_t first, std::size_t last)
+    {
+        for(std::size_t i = first; i < last; i++)
+        {
+            if(progress)
+                progress->check();
+            const std::uint64_t* row = &rows[i * words];
+            for(std::size_t j = 0; j < n; j++)
+            {
+                // one common bit is enough, so most entries of dense matrices stop at the first word
+                const std::uint64_t* column = &columns[j * words];
+                std::uint8_t found = 0;
+                for(std::size_t w = 0; w < words && found == 0; w++)
+                {
+                    found = (row[w] & column[w]) != 0;
+                }
+                c[i * n + j] = found;
+            }
+            if(progress)
+                progress->advance();
+        }
+    };
+
+    if(n >= semiring_parallel_threshold)
+        parallelFor(0, n, std::max<std::size_t>(1, (std::size_t(1) << 18) / (static_cast<std::size_t>(n) * words)), work);
+    else
+        work(0, n);
+}
+
+namespace
+{
+    /**
+        \brief Copy values of matrix to row-major array of semiring values
+        \param m the matrix
+        \return The array
+    */
+    template <typename S>
+    std::vector<typename S::value_type> semiringValues(const ConcreteSquareMatrix& m)
+    {
+        std::vector<int> values(static_cast<std::size_t>(m.getSize()) * m.getSize());
+        m.copyValues(values.data());
+        std::vector<typename S::value_type> result(values.size());
+        for(std::size_t k = 0; k < values.size(); k++)
+        {
+            // only the boolean semiring changes values, everything but 0 is true
+            result[k] = std::is_same<S, BooleanSemiring>::value ? typename S::value_type(values[k] != 0)
+                                                                : static_cast<typename S::value_type>(values[k]);
+        }
+        return result;
+    }
+
+    /**
+        \brief Build matrix of row-major array of semiring values
+        \param n number of rows and columns
+        \param values the array
+        \return ConcreteSquareMatrix object
+    */
+    template <typename T>
+    ConcreteSquareMatrix fromSemiringValues(unsigned int n, const std::vector<T>& values)
+    {
+        std::vector<int> result(values.begin(), values.end());
+        return ConcreteSquareMatrix::fromValues(n, result.data());
+    }
+
+    template <typename S>
+    ConcreteSquareMatrix multiplyOver(const ConcreteSquareMatrix& m1, const ConcreteSquareMatrix& m2, Progress* progress)
+    {
+        unsigned int n = m1.getSize();
+        if(n != m2.getSize())
+        {
+            throw std::invalid_argument("Matrices are not the same size");
+        }
+
+        std::vector<typename S::value_type> a = semiringValues<S>(m1);
+        std::vector<typename S::value_type> b = semiringValues<S>(m2);
+        std::vector<typename S::value_type> c(a.size());
+        semiringMultiply<S>(n, a.data(), b.data(), c.data(), progress);
+        return fromSemiringValues(n, c);
+    }
+
+    template <typename S>
+    ConcreteSquareMatrix powerOver(const ConcreteSquareMatrix& m, unsigned long long e, Progress* progress)
+    {
+        unsigned int n = m.getSize();
+        std::vector<typename S::value_type> base = semiringValues<S>(m);
+        std::vector<typename S::value_type> result(base.size(), S::zero);
+        std::vector<typename S::value_type> temp(base.size());
+        bool identity = true;
+
+        for(unsigned int i = 0; i < n; i++)
+        {
+            result[static_cast<std::size_t>(i) * n + i] = S::one;
+        }
+
+        while(e != 0)
+        {
+            if(e & 1)
+            {
+                if(identity)
+                {
+                    result = base;
+                    identity = false;
+                }
+                else
+                {
+                    semiringMultiply<S>(n, result.data(), base.data(), temp.data(), progress);
+                    result.swap(temp);
+                }
+            }
+            e >>= 1;
+            if(e != 0)
+            {
+                semiringMultiply<S>(n, base.data(), base.data(), temp.data(), progress);
+                base.swap(temp);
+            }
+        }
+        return fromSemiringValues(n, result);
+    }
+}
+
+const char* semiringName(Semiring s)
+{
+    switch(s)
+    {
+        case Semiring::MinPlus:
+            return "min-plus";
+        case Semiring::MaxPlus:
+            return "max-plus";
+        default:
+            return "boolean";
+    }
+}
+
+ConcreteSquareMatrix semiringMultiply(const ConcreteSquareMatrix& m1, const ConcreteSquareMatrix& m2, Semiring s, Progress* progress)
+{
+    switch(s)
+    {
+        case Semiring::MinPlus:
+            return multiplyOver<MinPlus>(m1, m2, progress);
+        case Semiring::MaxPlus:
+            return multiplyOver<MaxPlus>(m1, m2, progress);
+        default:
+            return multiplyOver<BooleanSemiring>(m1, m2, progress);
+    }
+}
+
+ConcreteSquareMatrix semiringPower(const ConcreteSquareMatrix& m, unsigned long long e, Semiring s, Progress* progress)
+{
+    switch(s)
+    {
+        case Semiring::MinPlus:
+            return powerOver<MinPlus>(m, e, progress);
+        case Semiring::MaxPlus:
+            return powerOver<MaxPlus>(m, e, progress);
+        default:
+            return powerOver<BooleanSemiring>(m, e, progress);
+    }
+}
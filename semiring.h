@@ -0,0 +1,228 @@
+/**
+    \file semiring.h
+    \brief Header for matrix multiplication over semirings
+*/
+
+#ifndef SEMIRING_H_INCLUDED
+#define SEMIRING_H_INCLUDED
+#include "elementarymatrix.h"
+#include "kernels.h"
+#include "progress.h"
+#include "taskscheduler.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+/// Matrices smaller than this are multiplied over semirings in one thread
+const unsigned int semiring_parallel_threshold = 128;
+
+/**
+    \brief Add numbers, sums that overflow stop at the largest or smallest int
+
+    Overflow is found from the signs of the wrapped sum, so only 32-bit operations and
+    selects are needed and loops of sums are vectorized.
+    \param a first number
+    \param b second number
+    \return The sum
+*/
+inline int saturatingAdd(int a, int b)
+{
+    int sum = static_cast<int>(static_cast<unsigned int>(a) + static_cast<unsigned int>(b));
+    int limit = (a < 0) ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
+    return (((a ^ sum) & (b ^ sum)) < 0) ? limit : sum;
+}
+
+/**
+    \brief Semiring of '+' and '*' with numbers that wrap around like IntElement
+*/
+struct PlusTimes
+{
+    using value_type = unsigned int;
+    static constexpr value_type zero = 0;
+    static constexpr value_type one = 1;
+
+    static value_type add(value_type a, value_type b)
+    {
+        return a + b;
+    }
+
+    static value_type multiply(value_type a, value_type b)
+    {
+        return a * b;
+    }
+};
+
+/**
+    \brief Semiring of min and '+' for shortest paths, 2^31 - 1 is infinity and sums stop at it
+*/
+struct MinPlus
+{
+    using value_type = int;
+    static constexpr value_type zero = std::numeric_limits<int>::max();
+    static constexpr value_type one = 0;
+
+    static value_type add(value_type a, value_type b)
+    {
+        return std::min(a, b);
+    }
+
+    static value_type multiply(value_type a, value_type b)
+    {
+        return (a == zero || b == zero) ? zero : saturatingAdd(a, b);
+    }
+};
+
+/**
+    \brief Semiring of max and '+' for longest paths and scheduling, -2^31 is minus infinity and sums stop at it
+*/
+struct MaxPlus
+{
+    using value_type = int;
+    static constexpr value_type zero = std::numeric_limits<int>::min();
+    static constexpr value_type one = 0;
+
+    static value_type add(value_type a, value_type b)
+    {
+        return std::max(a, b);
+    }
+
+    static value_type multiply(value_type a, value_type b)
+    {
+        return (a == zero || b == zero) ? zero : saturatingAdd(a, b);
+    }
+};
+
+/**
+    \brief Semiring of or and and for reachability, values are 0 and 1
+*/
+struct BooleanSemiring
+{
+    using value_type = std::uint8_t;
+    static constexpr value_type zero = 0;
+    static constexpr value_type one = 1;
+
+    static value_type add(value_type a, value_type b)
+    {
+        return a | b;
+    }
+
+    static value_type multiply(value_type a, value_type b)
+    {
+        return a & b;
+    }
+};
+
+/**
+    \brief Calculate C = A*B over semiring S for n x n row-major arrays
+
+    Rows of A that hold zero of the semiring are skipped, zero annihilates in every
+    semiring. The innermost loop runs along a contiguous row of B and a local block of sums,
+    so min, max and saturating sums can be vectorized. Columns are handled in blocks that
+    stay in cache and rows of large matrices are divided between threads.
+    \tparam S the semiring
+    \param n number of rows and columns
+    \param a first matrix
+    \param b second matrix
+    \param c result, must not overlap a or b
+    \param progress progress reported by rows and checked for cancellation, may be nullptr
+    \throw OperationCancelled if progress is cancelled
+*/
+template <typename S>
+void semiringMultiply(unsigned int n, const typename S::value_type* a, const typename S::value_type* b, typename S::value_type* c,
+                      Progress* progress = nullptr)
+{
+    using T = typename S::value_type;
+    if(progress)
+        progress->setTotal(n);
+
+    auto rows = [&](std::size_t first, std::size_t last)
+    {
+        // sums of one block of a row are kept apart from B, so the loop over it needs no alias checks
+        std::array<T, kernel_column_block> sums;
+        for(std::size_t i = first; i < last; i++)
+        {
+            if(progress)
+                progress->check();
+            const T* a_row = a + i * n;
+            for(std::size_t j0 = 0; j0 < n; j0 += kernel_column_block)
+            {
+                std::size_t width = std::min<std::size_t>(n - j0, kernel_column_block);
+                std::fill(sums.begin(), sums.begin() + width, S::zero);
+                for(std::size_t k = 0; k < n; k++)
+                {
+                    const T factor = a_row[k];
+                    if(factor == S::zero)
+                        continue;
+
+                    const T* b_row = b + k * n + j0;
+                    for(std::size_t j = 0; j < width; j++)
+                    {
+                        sums[j] = S::add(sums[j], S::multiply(factor, b_row[j]));
+                    }
+                }
+                std::copy(sums.begin(), sums.begin() + width, c + i * n + j0);
+            }
+            if(progress)
+                progress->advance();
+        }
+    };
+
+    // each task gets about 2^18 products
+    if(n >= semiring_parallel_threshold)
+        parallelFor(0, n, std::max<std::size_t>(1, (std::size_t(1) << 18) / (static_cast<std::size_t>(n) * n)), rows);
+    else
+        rows(0, n);
+}
+
+/**
+    \brief Calculate C = A*B over the boolean semiring with rows of A and columns of B packed to 64-bit words
+
+    Entry (i, j) is 1 when some word of row i of A and column j of B have a common bit,
+    so 64 products are done with one AND.
+*/
+template <>
+void semiringMultiply<BooleanSemiring>(unsigned int n, const std::uint8_t* a, const std::uint8_t* b, std::uint8_t* c, Progress* progress);
+
+/**
+    \brief Semirings of multiplication commands
+*/
+enum class Semiring
+{
+    MinPlus,
+    MaxPlus,
+    Boolean
+};
+
+/**
+    \brief Function to get name of semiring used in messages
+    \param s the semiring
+    \return "min-plus", "max-plus" or "boolean"
+*/
+const char* semiringName(Semiring s);
+
+/**
+    \brief Multiply two matrices over a semiring, for boolean semiring values other than 0 are 1
+    \param m1 first matrix
+    \param m2 second matrix
+    \param s the semiring
+    \param progress progress reported by rows and checked for cancellation, may be nullptr
+    \throw std::invalid_argument if matrices are not the same size
+    \throw OperationCancelled if progress is cancelled
+    \return ConcreteSquareMatrix object
+*/
+ConcreteSquareMatrix semiringMultiply(const ConcreteSquareMatrix& m1, const ConcreteSquareMatrix& m2, Semiring s, Progress* progress = nullptr);
+
+/**
+    \brief Raise matrix to power over a semiring by repeated squaring, power 0 is the identity of the semiring
+    \param m the matrix
+    \param e the exponent
+    \param s the semiring
+    \param progress progress reported by rows and checked for cancellation, may be nullptr
+    \throw OperationCancelled if progress is cancelled
+    \return ConcreteSquareMatrix object
+*/
+ConcreteSquareMatrix semiringPower(const ConcreteSquareMatrix& m, unsigned long long e, Semiring s, Progress* progress = nullptr);
+
+#endif // SEMIRING_H_INCLUDED
@@ -0,0 +1,465 @@
+/**
+    \file server.cpp
+    \brief Code for CalculatorSession and CalculatorServer classes
+*/
+
+#include "server.h"
+#include "determinant.h"
+#include "taskscheduler.h"
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+void CalculatorSession::execute(const std::string& line, ResultCache& cache, std::ostream& out)
+{
+    std::istringstream strm(line);
+    if((strm >> std::ws).peek() == '[')
+    {
+        std::shared_ptr<SquareMatrix> matrix_ptr = readMatrixLine(line);
+        if(matrix_ptr == nullptr)
+        {
+            out << "Invalid input" << std::endl;
+            return;
+        }
+        matrices.push(matrix_ptr);
+        out << "Added matrix to stack" << std::endl;
+        return;
+    }
+
+    std::string input;
+    if(!(strm >> input))
+        return;
+
+    if(input.size() >= 2 && input[1] == '=')
+    {
+        std::istringstream value(input.substr(2));
+        int number = 0;
+        if(!(value >> number) || value.rdbuf()->in_avail() != 0)
+        {
+            out << "You must give an integer value to the character" << std::endl;
+            return;
+        }
+        v[input[0]] = number;
+        out << "Gave character " << input[0] << " the value of " << number << std::endl;
+        return;
+    }
+
+    if(input == "+" || input == "-" || input == "*")
+    {
+        stackOperation(matrices, v, cache, input[0], modulus.get(), exact, out);
+    }
+    else if(input == "pretty" || input == "compact")
+    {
+        layout = (input == "pretty") ? MatrixLayout::Pretty : MatrixLayout::Compact;
+        out << ((input == "pretty") ? "Matrices are printed one row per line" : "Matrices are printed on one line") << std::endl;
+    }
+    else if(input == "mod")
+    {
+        unsigned long long p = 0;
+        if(!(strm >> p) || p == 1 || p > 2147483648ULL)
+        {
+            out << "Modulus must be between 2 and 2147483648, or 0 to turn modular mode off" << std::endl;
+        }
+        else if(p == 0)
+        {
+            modulus.reset();
+            out << "Modular mode is off" << std::endl;
+        }
+        else
+        {
+            modulus = std::make_shared<Modulus>(static_cast<std::uint32_t>(p));
+            exact = false;
+            out << "Calculating modulo " << p << std::endl;
+        }
+    }
+    else if(input == "exact")
+    {
+        exact = !exact;
+        if(exact)
+            modulus.reset();
+        out << (exact ? "Exact mode is on" : "Exact mode is off") << std::endl;
+    }
+    else if(input == "cache")
+    {
+        out << "Result cache: " << cache.getHits() << " hits, " << cache.getMisses() << " misses, "
+            << cache.getEvictions() << " evictions, " << cache.size() << " results using "
+            << (cache.getUsage() >> 10) << " of " << (cache.getBudget() >> 10) << " kB" << std::endl;
+    }
+    else if(input == "save" || input == "load" || input == "import" || input == "export" || input == "snapshot" || input == "restore"
+            || input == "lu" || input == "solve" || input == "inverse" || input == "cachelimit")
+    {
+        out << "Command " << input << " is not available in server mode" << std::endl;
+    }
+    else if(input == "minplus" || input == "maxplus" || input == "boolean")
+    {
+        Semiring sr = (input == "minplus") ? Semiring::MinPlus : (input == "maxplus") ? Semiring::MaxPlus : Semiring::Boolean;
+        semiringOperation(matrices, v, cache, sr, out);
+    }
+    else if(input == "minpow" || input == "maxpow" || input == "boolpow")
+    {
+        Semiring sr = (input == "minpow") ? Semiring::MinPlus : (input == "maxpow") ? Semiring::MaxPlus : Semiring::Boolean;
+        unsigned long long e = 0;
+        if(!(strm >> e))
+        {
+            out << "You must give a non-negative integer exponent" << std::endl;
+            return;
+        }
+        if(matrices.empty())
+        {
+            out << "Stack is empty" << std::endl;
+            return;
+        }
+        try
+        {
+            std::shared_ptr<SquareMatrix> res_ptr = std::make_shared<ConcreteSquareMatrix>(semiringPower(*evaluateCached(*matrices.top(), v, cache), e, sr));
+            matrices.pop();
+            matrices.push(res_ptr);
+            out << "Raised topmost matrix to " << semiringName(sr) << " power: " << res_ptr->toString() << std::endl;
+        }
+        catch(const std::invalid_argument& ia)
+        {
+            out << "Couldn't do evaluation, please declare values to variables" << std::endl;
+        }
+    }
+    else if(input == "=" || input == "det" || input == "transpose" || input == "pow" || input == "specialize")
+    {
+        unsigned long long e = 0;
+        if(input == "pow" && !(strm >> e))
+        {
+            out << "You must give a non-negative integer exponent" << std::endl;
+            return;
+        }
+        if(matrices.empty())
+        {
+            out << "Stack is empty" << std::endl;
+            return;
+        }
+
+        const SquareMatrix& top = *matrices.top();
+        try
+        {
+            if(input == "=")
+            {
+                if(const ExactSquareMatrix* em = dynamic_cast<const ExactSquareMatrix*>(&top))
+                    em->write(out, layout);
+                else
+                    evaluateCached(top, v, cache)->write(out, layout);
+                out << std::endl;
+            }
+            else if(input == "det")
+            {
+                out << "Determinant of topmost matrix: " << determinant(*evaluateCached(top, v, cache)) << std::endl;
+            }
+            else if(input == "transpose")
+            {
+                std::shared_ptr<SquareMatrix> res_ptr = transposeCached(top, v, cache, out);
+                if(res_ptr == nullptr)
+                    return;
+                matrices.pop();
+                matrices.push(res_ptr);
+                out << "Transposed topmost matrix: " << res_ptr->toString() << std::endl;
+            }
+            else if(input == "pow")
+            {
+                std::shared_ptr<SquareMatrix> res_ptr = power(top, e, v, cache, modulus.get(), exact);
+                matrices.pop();
+                matrices.push(res_ptr);
+                out << "Raised topmost matrix to power: " << res_ptr->toString() << std::endl;
+            }
+            else
+            {
+                std::shared_ptr<SquareMatrix> spec_ptr = std::make_shared<SymbolicSquareMatrix>(top.specialize(v));
+                matrices.pop();
+                matrices.push(spec_ptr);
+                out << "Specialized topmost matrix: " << spec_ptr->toString() << std::endl;
+            }
+        }
+        catch(const std::invalid_argument& ia)
+        {
+            if(input == "det" && dynamic_cast<const ExactSquareMatrix*>(&top) != nullptr)
+                out << ia.what() << std::endl;
+            else
+                out << "Couldn't do evaluation, please declare values to variables" << std::endl;
+        }
+    }
+    else
+    {
+        out << "Invalid input" << std::endl;
+    }
+}
+
+void CalculatorSession::executeBatch(const std::vector<std::string>& lines, ResultCache& cache, std::ostream& out)
+{
+    CommandPlan plan;
+    std::vector<std::string> responses;
+    auto runPlan = [&]()
+    {
+        if(plan.size() == 0)
+            return;
+        responses.clear();
+        std::stack<std::shared_ptr<SquareMatrix>> before = matrices;
+        try
+        {
+            plan.run(matrices, v, cache, modulus.get(), exact, responses);
+        }
+        catch(const std::exception& e)
+        {
+            // plan may have stopped halfway, so the stack is put back and every line of it gets the error
+            matrices = before;
+            responses.assign(plan.size(), std::string("Could not run command: ") + e.what() + "\n");
+            plan = CommandPlan();
+        }
+        for(const std::string& r: responses)
+        {
+            out << r << '\n';
+        }
+    };
+
+    for(const std::string& line: lines)
+    {
+        if(CommandPlan::isPlannable(line))
+        {
+            plan.add(line);
+            continue;
+        }
+        runPlan();
+        try
+        {
+            execute(line, cache, out);
+        }
+        catch(const std::exception& e)
+        {
+            out << "Could not run command: " << e.what() << std::endl;
+        }
+        out << '\n';
+    }
+    runPlan();
+}
+
+/**
+    \brief Client connection of CalculatorServer
+
+    Only the polling thread touches input, complete and closing, session is used by one
+    task at a time and busy tells whether a task has it.
+*/
+struct CalculatorServer::Connection
+{
+    int fd;
+    std::string input;
+    std::size_t complete = 0;   ///< length of the complete lines at the start of input
+    CalculatorSession session;
+    std::atomic<bool> busy{false};
+    bool closing = false;
+
+    explicit Connection(int socket): fd(socket) {}
+
+    ~Connection()
+    {
+        close(fd);
+    }
+};
+
+namespace
+{
+    /**
+        \brief Write whole buffer to socket, a client that went away does not raise SIGPIPE
+        \param fd the socket
+        \param data buffer to write
+        \return false if the socket was closed
+    */
+    bool sendAll(int fd, const std::string& data)
+    {
+        std::size_t sent = 0;
+        while(sent < data.size())
+        {
+            ssize_t count = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if(count < 0 && errno == EINTR)
+                continue;
+            if(count <= 0)
+                return false;
+            sent += static_cast<std::size_t>(count);
+        }
+        return true;
+    }
+}
+
+CalculatorServer::CalculatorServer(const std::string& socket_path, unsigned int worker_threads, std::size_t max_line):
+    path(socket_path), threads(worker_threads), line_limit(max_line)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if(path.size() >= sizeof(address.sun_path))
+    {
+        throw std::runtime_error("Socket path is too long: " + path);
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    if(pipe2(wake_fds, O_NONBLOCK | O_CLOEXEC) != 0)
+    {
+        throw std::runtime_error("Could not create pipe");
+    }
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    unlink(path.c_str());
+    if(listen_fd < 0 || bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listen_fd, SOMAXCONN) != 0)
+    {
+        if(listen_fd >= 0)
+            close(listen_fd);
+        close(wake_fds[0]);
+        close(wake_fds[1]);
+        throw std::runtime_error("Could not listen on socket " + path);
+    }
+}
+
+CalculatorServer::~CalculatorServer()
+{
+    close(listen_fd);
+    close(wake_fds[0]);
+    close(wake_fds[1]);
+    unlink(path.c_str());
+}
+
+void CalculatorServer::wake()
+{
+    char c = 0;
+    ssize_t ignored = write(wake_fds[1], &c, 1);
+    (void)ignored;
+}
+
+void CalculatorServer::stop()
+{
+    stopping = true;
+    wake();
+}
+
+void CalculatorServer::run()
+{
+    // polling thread only hands out tasks, so every thread of the pool is a worker
+    TaskScheduler pool(threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) + 1 : threads + 1);
+    TaskGroup group(pool);
+    std::vector<std::shared_ptr<Connection>> connections;
+    std::vector<pollfd> fds;
+    std::vector<Connection*> polled;
+    char buffer[1 << 16];
+
+    while(!stopping)
+    {
+        fds.assign({pollfd{wake_fds[0], POLLIN, 0}, pollfd{listen_fd, POLLIN, 0}});
+        polled.clear();
+        for(const auto& c: connections)
+        {
+            // a busy client is polled again once its batch is done, the kernel keeps its input meanwhile
+            if(!c->busy && !c->closing)
+            {
+                fds.push_back(pollfd{c->fd, POLLIN, 0});
+                polled.push_back(c.get());
+            }
+        }
+
+        if(poll(fds.data(), fds.size(), -1) < 0 && errno != EINTR)
+            break;
+
+        if(fds[0].revents != 0)
+        {
+            while(read(wake_fds[0], buffer, sizeof(buffer)) > 0)
+            {
+            }
+        }
+        if(fds[1].revents & POLLIN)
+        {
+            int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if(fd >= 0)
+                connections.push_back(std::make_shared<Connection>(fd));
+        }
+        for(std::size_t i = 0; i < polled.size(); i++)
+        {
+            if(fds[i + 2].revents == 0)
+                continue;
+            Connection& c = *polled[i];
+            ssize_t count = read(c.fd, buffer, sizeof(buffer));
+            if(count > 0)
+            {
+                // only new input is searched for the end of a line
+                const char* last = static_cast<const char*>(memrchr(buffer, '\n', static_cast<std::size_t>(count)));
+                if(last != nullptr)
+                    c.complete = c.input.size() + static_cast<std::size_t>(last - buffer) + 1;
+                c.input.append(buffer, static_cast<std::size_t>(count));
+                if(c.input.size() - c.complete > line_limit)
+                {
+                    // the line would never be answered, so it is not kept
+                    c.input.resize(c.complete);
+                    c.closing = true;
+                }
+            }
+            else if(count == 0 || errno != EINTR)
+            {
+                c.closing = true;
+            }
+        }
+
+        for(std::size_t i = 0; i < connections.size(); )
+        {
+            std::shared_ptr<Connection> c = connections[i];
+            if(c->busy)
+            {
+                i++;
+                continue;
+            }
+
+            if(c->complete != 0)
+            {
+                // every complete line received so far is one batch
+                std::string lines = c->input.substr(0, c->complete);
+                c->input.erase(0, c->complete);
+                c->complete = 0;
+                c->busy = true;
+                batches++;
+                group.run([this, c, lines = std::move(lines)]()
+                {
+                    // the client is always answered and released, an exception here would also end run()
+                    std::ostringstream out;
+                    try
+                    {
+                        std::istringstream in(lines);
+                        std::vector<std::string> batch;
+                        std::string line;
+                        while(std::getline(in, line))
+                        {
+                            batch.push_back(line);
+                        }
+                        c->session.executeBatch(batch, cache, out);
+                        requests += batch.size();
+                    }
+                    catch(const std::exception& e)
+                    {
+                        out << "Could not run command: " << e.what() << "\n\n";
+                    }
+                    catch(...)
+                    {
+                        out << "Could not run command\n\n";
+                    }
+                    sendAll(c->fd, out.str());
+                    c->busy = false;
+                    wake();
+                });
+                i++;
+            }
+            else if(c->closing)
+            {
+                connections.erase(connections.begin() + i);
+            }
+            else
+            {
+                i++;
+            }
+        }
+    }
+    group.wait();
+}
@@ -0,0 +1,150 @@
+/**
+    \file server.h
+    \brief Header for CalculatorSession and CalculatorServer classes
+*/
+
+#ifndef SERVER_H_INCLUDED
+#define SERVER_H_INCLUDED
+#include "commandplan.h"
+#include "commands.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <stack>
+#include <string>
+#include <vector>
+
+/**
+    \class CalculatorSession
+    \brief Stack, variable values and modes of one client of the server
+*/
+class CalculatorSession
+{
+    private:
+        std::stack<std::shared_ptr<SquareMatrix>> matrices;
+        Valuation v;
+        std::shared_ptr<const Modulus> modulus;
+        bool exact = false;
+        MatrixLayout layout = MatrixLayout::Compact;
+
+    public:
+
+        /**
+            \brief Run one line of input, commands are the same as in the interactive calculator except the ones using files
+            \param line matrix, variable assignment or command
+            \param cache cache of results, may be shared by sessions
+            \param out stream for messages
+        */
+        void execute(const std::string& line, ResultCache& cache, std::ostream& out);
+
+        /**
+            \brief Run lines received together, runs of matrices and '+', '-' and '*' lines are run as a CommandPlan
+            \param lines the lines
+            \param cache cache of results, may be shared by sessions
+            \param out stream for messages, messages of each line are followed by an empty line, a line that fails with any other exception is answered with its message
+        */
+        void executeBatch(const std::vector<std::string>& lines, ResultCache& cache, std::ostream& out);
+
+        /**
+            \brief Function to get number of matrices in the stack
+            \return The number
+        */
+        std::size_t getStackSize() const
+        {
+            return matrices.size();
+        }
+};
+
+/// Longest line a server client may send by default, a client sending a longer line is disconnected
+const std::size_t server_line_limit = std::size_t(1) << 26;
+
+/**
+    \class CalculatorServer
+    \brief Server hosting a CalculatorSession for each client connected to a Unix domain socket
+
+    Clients send lines of input and get the messages of each line back, followed by an
+    empty line. One thread polls the sockets and hands the lines of a client to a pool of
+    worker threads, all complete lines received from a client so far are run as one batch
+    with CalculatorSession::executeBatch and their responses are sent with one write.
+    Lines of a client are run in order, one batch at a time. Sessions share one result
+    cache, so results are reused across clients.
+*/
+class CalculatorServer
+{
+    private:
+        struct Connection;
+
+        std::string path;
+        unsigned int threads;
+        std::size_t line_limit;
+        int listen_fd = -1;
+        int wake_fds[2] = {-1, -1};
+        std::atomic<bool> stopping{false};
+        std::atomic<std::uint64_t> requests{0};
+        std::atomic<std::uint64_t> batches{0};
+        ResultCache cache;
+
+        /**
+            \brief Wake the polling thread
+        */
+        void wake();
+
+    public:
+
+        /**
+            \brief Parametric constructor, starts listening on the socket
+            \param socket_path path of the Unix domain socket, an existing file is replaced
+            \param worker_threads number of threads running the commands, 0 uses all hardware threads
+            \param max_line longest line a client may send, a client sending a longer line is disconnected
+            \throw std::runtime_error if socket cannot be created
+        */
+        explicit CalculatorServer(const std::string& socket_path, unsigned int worker_threads = 0, std::size_t max_line = server_line_limit);
+
+        CalculatorServer(const CalculatorServer&) = delete;
+        CalculatorServer& operator=(const CalculatorServer&) = delete;
+
+        /**
+            \brief Destructor, closes and removes the socket
+        */
+        ~CalculatorServer();
+
+        /**
+            \brief Serve clients until stop() is called, running commands are finished before returning
+        */
+        void run();
+
+        /**
+            \brief Ask run() to return, may be called from another thread or a signal handler
+        */
+        void stop();
+
+        /**
+            \brief Function to get number of lines run
+            \return The number
+        */
+        std::uint64_t getRequests() const
+        {
+            return requests;
+        }
+
+        /**
+            \brief Function to get number of tasks the lines were run in
+            \return The number
+        */
+        std::uint64_t getBatches() const
+        {
+            return batches;
+        }
+
+        /**
+            \brief Function to get the result cache shared by sessions
+            \return Reference to the cache
+        */
+        const ResultCache& getCache() const
+        {
+            return cache;
+        }
+};
+
+#endif // SERVER_H_INCLUDED
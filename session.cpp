@@ -0,0 +1,505 @@
+/**
+    \file session.cpp
+    \brief Code for saving calculator session to a binary snapshot file and restoring it
+*/
+
+#include "session.h"
+#include "matrixfile.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+static const char session_file_magic[4] = {'M', 'X', 'C', 'S'};
+static const std::uint16_t session_file_version = 1;
+static const std::uint32_t session_file_byte_order = 0x01020304;
+
+static_assert(sizeof(SessionFileHeader) == 32, "Session file header must not have padding");
+static_assert(sizeof(SessionVariable) == 8, "Session variable must not have padding");
+static_assert(sizeof(SessionEntry) == 24, "Session entry must not have padding");
+static_assert(sizeof(SessionNode) == 12, "Session node must not have padding");
+
+/**
+    \class SessionSnapshot
+    \brief Memory-mapped session snapshot file shared by the restored stack entries
+*/
+class SessionSnapshot
+{
+    private:
+        MappedFile file;
+        std::vector<SessionEntry> entries;
+        std::uint32_t node_count = 0;
+        std::uint64_t node_offset = 0;
+        mutable std::once_flag nodes_flag;
+        mutable std::vector<std::shared_ptr<Element>> nodes;
+
+        /**
+            \brief Build expression nodes of the snapshot, operands are always built before their users
+            \throw std::invalid_argument if node table is not valid
+        */
+        void buildNodes() const
+        {
+            const char* data = file.data() + node_offset;
+            std::vector<std::shared_ptr<Element>> built;
+            built.reserve(node_count);
+
+            for(std::uint32_t i = 0; i < node_count; i++)
+            {
+                SessionNode node;
+                std::memcpy(&node, data + i * sizeof(SessionNode), sizeof(node));
+
+                if(node.kind == 0)
+                {
+                    built.push_back(std::make_shared<IntElement>(node.value));
+                }
+                else if(node.kind == 1)
+                {
+                    built.push_back(std::make_shared<VariableElement>(node.symbol));
+                }
+                else if(node.kind == 2 && node.value >= 0 && static_cast<std::uint32_t>(node.value) < i && node.operand < i)
+                {
+                    built.push_back(std::make_shared<CompositeElement>(built[node.value], built[node.operand], node.symbol));
+                }
+                else
+                {
+                    throw std::invalid_argument("Session file has invalid expression node");
+                }
+            }
+            nodes = std::move(built);
+        }
+
+    public:
+
+        /**
+            \brief Parametric constructor, reads and checks header and entry list
+            \param path name of the file
+            \param v valuation to fill with variables of the snapshot
+            \throw std::runtime_error if file cannot be read
+            \throw std::invalid_argument if file is not a valid session snapshot
+        */
+        SessionSnapshot(const std::string& path, Valuation& v): file(path)
+        {
+            SessionFileHeader header;
+
+            if(file.size() < sizeof(header))
+            {
+                throw std::invalid_argument("File is not a session file");
+            }
+
+            std::memcpy(&header, file.data(), sizeof(header));
+            if(std::memcmp(header.magic, session_file_magic, sizeof(header.magic)) != 0)
+            {
+                throw std::invalid_argument("File is not a session file");
+            }
+            if(header.version != session_file_version)
+            {
+                throw std::invalid_argument("Unsupported session file version");
+            }
+            if(header.byte_order != session_file_byte_order)
+            {
+                throw std::invalid_argument("Session file was written with different byte order");
+            }
+
+            std::uint64_t size = file.size();
+            std::uint64_t list_size = sizeof(SessionVariable) * static_cast<std::uint64_t>(header.variable_count)
+                                    + sizeof(SessionEntry) * static_cast<std::uint64_t>(header.entry_count);
+            if(size - sizeof(header) < list_size || header.node_offset > size
+               || (size - header.node_offset) / sizeof(SessionNode) < header.node_count)
+            {
+                throw std::invalid_argument("Session file is truncated");
+            }
+
+            const char* pos = file.data() + sizeof(header);
+            for(std::uint32_t i = 0; i < header.variable_count; i++, pos += sizeof(SessionVariable))
+            {
+                SessionVariable var;
+                std::memcpy(&var, pos, sizeof(var));
+                v[var.name] = var.value;
+            }
+
+            entries.resize(header.entry_count);
+            for(std::uint32_t i = 0; i < header.entry_count; i++, pos += sizeof(SessionEntry))
+            {
+                SessionEntry& entry = entries[i];
+                std::memcpy(&entry, pos, sizeof(entry));
+
+                std::uint64_t count = static_cast<std::uint64_t>(entry.n) * entry.n;
+                if(entry.kind > 1 || entry.offset % alignof(std::int32_t) != 0 || entry.offset > size
+                   || (size - entry.offset) / sizeof(std::int32_t) < count)
+                {
+                    throw std::invalid_argument("Session file is truncated");
+                }
+            }
+
+            node_count = header.node_count;
+            node_offset = header.node_offset;
+        }
+
+        /**
+            \brief Function to get number of stack entries
+            \return The number
+        */
+        std::size_t size() const
+        {
+            return entries.size();
+        }
+
+        /**
+            \brief Function to get stack entry
+            \param i index of entry, 0 is the bottom of the stack
+            \return Reference to entry
+        */
+        const SessionEntry& getEntry(std::size_t i) const
+        {
+            return entries[i];
+        }
+
+        /**
+            \brief Read matrix of a stack entry
+            \param i index of entry, 0 is the bottom of the stack
+            \throw std::invalid_argument if matrix data is not valid
+            \return Pointer to ConcreteSquareMatrix or SymbolicSquareMatrix object
+        */
+        std::shared_ptr<SquareMatrix> read(std::size_t i) const
+        {
+            const SessionEntry& entry = entries[i];
+            const char* data = file.data() + entry.offset;
+
+            if(entry.kind == 0)
+            {
+                return std::make_shared<ConcreteSquareMatrix>(ConcreteSquareMatrix::fromValues(entry.n, reinterpret_cast<const int*>(data)));
+            }
+
+            std::call_once(nodes_flag, [this](){ buildNodes(); });
+
+            const std::uint32_t* indices = reinterpret_cast<const std::uint32_t*>(data);
+            std::vector<std::vector<std::shared_ptr<Element>>> elems(entry.n);
+            for(std::uint32_t row = 0; row < entry.n; row++)
+            {
+                elems[row].reserve(entry.n);
+                for(std::uint32_t col = 0; col < entry.n; col++)
+                {
+                    std::uint32_t node = indices[static_cast<std::size_t>(row) * entry.n + col];
+                    if(node >= nodes.size())
+                    {
+                        throw std::invalid_argument("Session file has invalid expression node");
+                    }
+                    elems[row].push_back(nodes[node]);
+                }
+            }
+
+            std::shared_ptr<SymbolicSquareMatrix> sq = std::make_shared<SymbolicSquareMatrix>();
+            sq->setVector(std::move(elems));
+            return sq;
+        }
+};
+
+LazySquareMatrix::LazySquareMatrix(std::shared_ptr<const SessionSnapshot> s, std::size_t i): snapshot(std::move(s)), index(i)
+{
+}
+
+const SquareMatrix& LazySquareMatrix::load() const
+{
+    // matrix is published through loaded, so isLoaded never reads it while another thread is writing it
+    std::call_once(load_flag, [this]()
+    {
+        matrix = snapshot->read(index);
+        loaded.store(true, std::memory_order_release);
+    });
+    return *matrix;
+}
+
+bool LazySquareMatrix::isLoaded() const
+{
+    return loaded.load(std::memory_order_acquire);
+}
+
+std::string LazySquareMatrix::toString() const
+{
+    return load().toString();
+}
+
+void LazySquareMatrix::write(std::ostream& os, MatrixLayout layout) const
+{
+    load().write(os, layout);
+}
+
+ConcreteSquareMatrix LazySquareMatrix::evaluate(const Valuation& v) const
+{
+    return load().evaluate(v);
+}
+
+SymbolicSquareMatrix LazySquareMatrix::specialize(const Valuation& v) const
+{
+    return load().specialize(v);
+}
+
+std::uint64_t LazySquareMatrix::contentHash() const
+{
+    return snapshot->getEntry(index).hash;
+}
+
+SquareMatrix* LazySquareMatrix::clone() const
+{
+    return load().clone();
+}
+
+bool LazySquareMatrix::sameContent(const SquareMatrix& m) const
+{
+    try
+    {
+        return load().sameContent(m);
+    }
+    catch(const std::invalid_argument& ia)
+    {
+        return false;
+    }
+}
+
+namespace
+{
+    /**
+        \class NodeTable
+        \brief Collects expression nodes of symbolic matrices, every shared node gets one index
+    */
+    class NodeTable
+    {
+        private:
+            std::unordered_map<const Element*, std::uint32_t> indices;
+            std::vector<SessionNode> nodes;
+            std::vector<const Element*> pending;
+
+            /**
+                \brief Add one node whose operands already have indices
+                \param e node to add
+                \throw std::invalid_argument if node is not of known Element type
+            */
+            void emit(const Element* e)
+            {
+                SessionNode node = {};
+
+                if(const IntElement* ie = dynamic_cast<const IntElement*>(e))
+                {
+                    node.kind = 0;
+                    node.value = ie->getVal();
+                }
+                else if(const VariableElement* ve = dynamic_cast<const VariableElement*>(e))
+                {
+                    node.kind = 1;
+                    node.symbol = ve->getVal();
+                }
+                else if(const CompositeElement* ce = dynamic_cast<const CompositeElement*>(e))
+                {
+                    node.kind = 2;
+                    node.symbol = ce->getOperator();
+                    node.value = static_cast<std::int32_t>(indices.at(ce->getOperand1().get()));
+                    node.operand = indices.at(ce->getOperand2().get());
+                }
+                else
+                {
+                    throw std::invalid_argument("Unknown element type");
+                }
+
+                indices.emplace(e, static_cast<std::uint32_t>(nodes.size()));
+                nodes.push_back(node);
+            }
+
+        public:
+
+            /**
+                \brief Give index to a node and all its operands, deep expressions are walked without recursion
+                \param root node to add
+                \return Index of the node
+            */
+            std::uint32_t add(const Element* root)
+            {
+                auto found = indices.find(root);
+                if(found != indices.end())
+                    return found->second;
+
+                pending.push_back(root);
+                while(!pending.empty())
+                {
+                    const Element* e = pending.back();
+                    if(indices.count(e) != 0)
+                    {
+                        pending.pop_back();
+                        continue;
+                    }
+
+                    const CompositeElement* ce = dynamic_cast<const CompositeElement*>(e);
+                    if(ce != nullptr)
+                    {
+                        const Element* op1 = ce->getOperand1().get();
+                        const Element* op2 = ce->getOperand2().get();
+                        bool ready = true;
+                        if(indices.count(op2) == 0)
+                        {
+                            pending.push_back(op2);
+                            ready = false;
+                        }
+                        if(indices.count(op1) == 0)
+                        {
+                            pending.push_back(op1);
+                            ready = false;
+                        }
+                        if(!ready)
+                            continue;
+                    }
+
+                    pending.pop_back();
+                    emit(e);
+                }
+                return indices.at(root);
+            }
+
+            /**
+                \brief Function to get collected nodes
+                \return Reference to nodes, operands before their users
+            */
+            const std::vector<SessionNode>& getNodes() const
+            {
+                return nodes;
+            }
+    };
+
+    /**
+        \brief Stack entry prepared for writing
+    */
+    struct PreparedEntry
+    {
+        SessionEntry entry;
+        const ConcreteSquareMatrix* concrete = nullptr;
+        std::vector<std::uint32_t> indices;
+    };
+}
+
+void saveSession(const std::string& path, const std::stack<std::shared_ptr<SquareMatrix>>& matrices, const Valuation& v)
+{
+    static_assert(sizeof(int) == 4, "Session files store 32-bit integers");
+    std::stack<std::shared_ptr<SquareMatrix>> rest = matrices;
+    std::vector<std::shared_ptr<SquareMatrix>> stack_entries;
+    std::vector<SymbolicSquareMatrix> converted;
+
+    while(!rest.empty())
+    {
+        stack_entries.push_back(rest.top());
+        rest.pop();
+    }
+    std::reverse(stack_entries.begin(), stack_entries.end());
+    converted.reserve(stack_entries.size());
+
+    NodeTable table;
+    std::vector<PreparedEntry> prepared(stack_entries.size());
+    for(std::size_t i = 0; i < stack_entries.size(); i++)
+    {
+        const SquareMatrix* m = stack_entries[i].get();
+        if(const LazySquareMatrix* lazy = dynamic_cast<const LazySquareMatrix*>(m))
+            m = &lazy->load();
+
+        PreparedEntry& p = prepared[i];
+        p.entry = {};
+        p.entry.hash = m->contentHash();
+
+        if(const ConcreteSquareMatrix* cm = dynamic_cast<const ConcreteSquareMatrix*>(m))
+        {
+            p.entry.kind = 0;
+            p.entry.n = cm->getSize();
+            p.concrete = cm;
+            continue;
+        }
+
+        const SymbolicSquareMatrix* sm = dynamic_cast<const SymbolicSquareMatrix*>(m);
+        if(sm == nullptr)
+        {
+            converted.push_back(m->specialize(Valuation()));
+            sm = &converted.back();
+        }
+
+        p.entry.kind = 1;
+        p.entry.n = sm->getSize();
+        p.indices.reserve(static_cast<std::size_t>(p.entry.n) * p.entry.n);
+        for(unsigned int row = 0; row < sm->getSize(); row++)
+        {
+            for(unsigned int col = 0; col < sm->getSize(); col++)
+            {
+                p.indices.push_back(table.add(&sm->getElement(row, col)));
+            }
+        }
+    }
+
+    const std::vector<SessionNode>& nodes = table.getNodes();
+    SessionFileHeader header;
+    std::memcpy(header.magic, session_file_magic, sizeof(header.magic));
+    header.version = session_file_version;
+    header.reserved = 0;
+    header.byte_order = session_file_byte_order;
+    header.variable_count = static_cast<std::uint32_t>(v.size());
+    header.entry_count = static_cast<std::uint32_t>(prepared.size());
+    header.node_count = static_cast<std::uint32_t>(nodes.size());
+    header.node_offset = sizeof(header) + sizeof(SessionVariable) * v.size() + sizeof(SessionEntry) * prepared.size();
+
+    std::uint64_t offset = header.node_offset + sizeof(SessionNode) * nodes.size();
+    for(PreparedEntry& p : prepared)
+    {
+        p.entry.offset = offset;
+        offset += sizeof(std::int32_t) * static_cast<std::uint64_t>(p.entry.n) * p.entry.n;
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if(!file)
+    {
+        throw std::runtime_error("Could not open file " + path);
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for(const auto& binding : v)
+    {
+        SessionVariable var = {};
+        var.name = binding.first;
+        var.value = binding.second;
+        file.write(reinterpret_cast<const char*>(&var), sizeof(var));
+    }
+    for(const PreparedEntry& p : prepared)
+    {
+        file.write(reinterpret_cast<const char*>(&p.entry), sizeof(p.entry));
+    }
+    file.write(reinterpret_cast<const char*>(nodes.data()), sizeof(SessionNode) * nodes.size());
+
+    std::vector<int> values;
+    for(const PreparedEntry& p : prepared)
+    {
+        if(p.concrete != nullptr)
+        {
+            values.resize(static_cast<std::size_t>(p.entry.n) * p.entry.n);
+            p.concrete->copyValues(values.data());
+            file.write(reinterpret_cast<const char*>(values.data()), sizeof(int) * values.size());
+        }
+        else
+        {
+            file.write(reinterpret_cast<const char*>(p.indices.data()), sizeof(std::uint32_t) * p.indices.size());
+        }
+    }
+
+    if(!file)
+    {
+        throw std::runtime_error("Could not write file " + path);
+    }
+}
+
+void restoreSession(const std::string& path, std::stack<std::shared_ptr<SquareMatrix>>& matrices, Valuation& v)
+{
+    Valuation restored_v;
+    std::shared_ptr<const SessionSnapshot> snapshot = std::make_shared<SessionSnapshot>(path, restored_v);
+    std::stack<std::shared_ptr<SquareMatrix>> restored;
+
+    for(std::size_t i = 0; i < snapshot->size(); i++)
+    {
+        restored.push(std::make_shared<LazySquareMatrix>(snapshot, i));
+    }
+
+    matrices = std::move(restored);
+    v = std::move(restored_v);
+}
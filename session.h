@@ -0,0 +1,180 @@
+/**
+    \file session.h
+    \brief Header for saving calculator session to a binary snapshot file and restoring it
+*/
+
+#ifndef SESSION_H_INCLUDED
+#define SESSION_H_INCLUDED
+#include "elementarymatrix.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stack>
+#include <string>
+
+/**
+    \brief Header at the start of a session snapshot file
+
+    Header is followed by variable_count SessionVariable records and entry_count
+    SessionEntry records, bottom of the stack first. Expression nodes of all symbolic
+    entries are stored once in a shared table of node_count SessionNode records starting
+    at node_offset, operands always before the nodes using them. Matrix data of each entry
+    starts at its own offset: n*n 32-bit integers for concrete matrices and n*n node
+    indices for symbolic matrices, both in row-major order.
+*/
+struct SessionFileHeader
+{
+    char magic[4];                  ///< always "MXCS"
+    std::uint16_t version;          ///< format version, currently 1
+    std::uint16_t reserved;         ///< always 0
+    std::uint32_t byte_order;       ///< 0x01020304 written in native byte order
+    std::uint32_t variable_count;   ///< number of variable bindings
+    std::uint32_t entry_count;      ///< number of stack entries
+    std::uint32_t node_count;       ///< number of expression nodes
+    std::uint64_t node_offset;      ///< offset of node table from start of file
+};
+
+/**
+    \brief Variable binding in a session snapshot file
+*/
+struct SessionVariable
+{
+    char name;                  ///< name of the variable
+    char reserved[3];           ///< always 0
+    std::int32_t value;         ///< value of the variable
+};
+
+/**
+    \brief Stack entry in a session snapshot file
+*/
+struct SessionEntry
+{
+    std::uint8_t kind;          ///< 0 for ConcreteSquareMatrix, 1 for SymbolicSquareMatrix
+    std::uint8_t reserved[3];   ///< always 0
+    std::uint32_t n;            ///< number of rows and columns
+    std::uint64_t offset;       ///< offset of matrix data from start of file
+    std::uint64_t hash;         ///< content hash of the matrix
+};
+
+/**
+    \brief Expression node in a session snapshot file
+*/
+struct SessionNode
+{
+    std::uint8_t kind;          ///< 0 for IntElement, 1 for VariableElement, 2 for CompositeElement
+    char symbol;                ///< name of variable or character of operation
+    std::uint16_t reserved;     ///< always 0
+    std::int32_t value;         ///< value of IntElement or index of first operand
+    std::uint32_t operand;      ///< index of second operand
+};
+
+class SessionSnapshot;
+
+/**
+    \class LazySquareMatrix
+    \brief Stack entry restored from a session snapshot, matrix is read from the file on first use
+*/
+class LazySquareMatrix : public SquareMatrix
+{
+    private:
+        std::shared_ptr<const SessionSnapshot> snapshot;
+        std::size_t index;
+        mutable std::once_flag load_flag;
+        mutable std::shared_ptr<SquareMatrix> matrix;
+        mutable std::atomic<bool> loaded{false};
+    public:
+
+        /**
+            \brief Parametric constructor
+            \param s snapshot the entry belongs to
+            \param i index of the entry in snapshot
+        */
+        LazySquareMatrix(std::shared_ptr<const SessionSnapshot> s, std::size_t i);
+
+        /**
+            \brief Read matrix from the snapshot if it has not been read yet
+            \throw std::invalid_argument if matrix data in file is not valid
+            \return Reference to ConcreteSquareMatrix or SymbolicSquareMatrix object
+        */
+        const SquareMatrix& load() const;
+
+        /**
+            \brief Tell if matrix has been read from the snapshot
+            \return true if matrix is in memory
+        */
+        bool isLoaded() const;
+
+        /**
+            \brief Returns string representation of matrix
+            \return The string representation
+        */
+        std::string toString() const override;
+
+        /**
+            \brief Write matrix to a stream
+            \param os stream to write in
+            \param layout layout of the output
+        */
+        void write(std::ostream& os, MatrixLayout layout) const override;
+
+        /**
+            \brief Evaluate variables in matrix
+            \param v map where variable values are stored
+            \throw std::invalid_argument if evaluation cannot be done
+            \return ConcreteSquareMatrix object
+        */
+        ConcreteSquareMatrix evaluate(const Valuation& v) const override;
+
+        /**
+            \brief Substitute variables that are bound in valuation and keep the rest symbolic
+            \param v map where variable values are stored
+            \return SymbolicSquareMatrix object over the remaining variables
+        */
+        SymbolicSquareMatrix specialize(const Valuation& v) const override;
+
+        /**
+            \brief Return hash of matrix content stored in the snapshot, matrix is not read
+            \return The hash
+        */
+        std::uint64_t contentHash() const override;
+
+        /**
+            \brief Copy matrix read from the snapshot
+            \throw std::invalid_argument if matrix data in file is not valid
+            \return Pointer to the copy
+        */
+        SquareMatrix* clone() const override;
+
+        /**
+            \brief Compare matrix read from the snapshot with another matrix, hash stored in the file is not used
+            \param m matrix to compare with
+            \return true if matrices have the same content, false also if matrix data in file is not valid
+        */
+        bool sameContent(const SquareMatrix& m) const override;
+};
+
+/**
+    \brief Write stack of matrices and variable values to a session snapshot file
+    \param path name of the file
+    \param matrices stack to write
+    \param v variable values to write
+    \throw std::runtime_error if file cannot be written
+*/
+void saveSession(const std::string& path, const std::stack<std::shared_ptr<SquareMatrix>>& matrices, const Valuation& v);
+
+/**
+    \brief Restore stack of matrices and variable values from a session snapshot file
+
+    Only header, variables and entry list are read here, stack gets LazySquareMatrix
+    objects that read their matrix when first used. Stack and valuation are replaced
+    only if file is valid.
+    \param path name of the file
+    \param matrices stack to fill
+    \param v variable values to fill
+    \throw std::runtime_error if file cannot be read
+    \throw std::invalid_argument if file is not a valid session snapshot
+*/
+void restoreSession(const std::string& path, std::stack<std::shared_ptr<SquareMatrix>>& matrices, Valuation& v);
+
+#endif // SESSION_H_INCLUDED
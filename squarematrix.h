@@ -1,41 +1,83 @@
-/**
-    \file squarematrix.h
-    \brief Header for SquareMatrix abstract class
-*/
-
-#ifndef SQUAREMATRIX_H_INCLUDED
-#define SQUAREMATRIX_H_INCLUDED
-#include "element.h"
-
-template <typename T>
-class ElementarySquareMatrix;
-
-/**
-    \class SquareMatrix
-    \brief SquareMatrix abstract class
-*/
-class SquareMatrix
-{
-    public:
-
-        /**
-            \brief Destructor
-        */
-        virtual ~SquareMatrix() = default;
-
-        /**
-            \brief Returns string representation of matrix
-            \return The string representation
-        */
-        virtual std::string toString() const = 0;
-
-        /**
-            \brief Evaluate variables in SquareMatrix
-            \param v map where variable values are stored
-            \throw std::invalid_argument if evaluation cannot be done
-            \return ConcreteSquareMatrix object
-        */
-        virtual ElementarySquareMatrix<IntElement> evaluate(const Valuation& v) const = 0;
-};
-
-#endif // SQUAREMATRIX_H_INCLUDED
+/**
+    \file squarematrix.h
+    \brief Header for SquareMatrix abstract class
+*/
+
+#ifndef SQUAREMATRIX_H_INCLUDED
+#define SQUAREMATRIX_H_INCLUDED
+#include "element.h"
+
+template <typename T>
+class ElementarySquareMatrix;
+
+/**
+    \brief Layout used when matrix is printed
+*/
+enum class MatrixLayout
+{
+    Compact,    ///< whole matrix on one line, e.g. [[1,2][3,4]]
+    Pretty      ///< one row per line with columns aligned
+};
+
+/**
+    \class SquareMatrix
+    \brief SquareMatrix abstract class
+*/
+class SquareMatrix
+{
+    public:
+
+        /**
+            \brief Destructor
+        */
+        virtual ~SquareMatrix() = default;
+
+        /**
+            \brief Returns string representation of matrix
+            \return The string representation
+        */
+        virtual std::string toString() const = 0;
+
+        /**
+            \brief Write matrix to a stream in large chunks without building the whole string first
+            \param os stream to write in
+            \param layout layout of the output
+        */
+        virtual void write(std::ostream& os, MatrixLayout layout) const = 0;
+
+        /**
+            \brief Evaluate variables in SquareMatrix
+            \param v map where variable values are stored
+            \throw std::invalid_argument if evaluation cannot be done
+            \return ConcreteSquareMatrix object
+        */
+        virtual ElementarySquareMatrix<IntElement> evaluate(const Valuation& v) const = 0;
+
+        /**
+            \brief Substitute variables that are bound in valuation and keep the rest symbolic
+            \param v map where variable values are stored
+            \return SymbolicSquareMatrix object over the remaining variables
+        */
+        virtual ElementarySquareMatrix<Element> specialize(const Valuation& v) const = 0;
+
+        /**
+            \brief Calculate 64-bit hash of matrix content
+            \return The hash
+        */
+        virtual std::uint64_t contentHash() const = 0;
+
+        /**
+            \brief Copy matrix
+            \return Pointer to the copy
+        */
+        virtual SquareMatrix* clone() const = 0;
+
+        /**
+            \brief Compare content with another matrix, hashes are not trusted
+            \param m matrix to compare with
+            \return true if matrices are of the same kind and have the same elements
+        */
+        virtual bool sameContent(const SquareMatrix& m) const = 0;
+};
+
+#endif // SQUAREMATRIX_H_INCLUDED
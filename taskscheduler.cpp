@@ -0,0 +1,171 @@
+/**
+    \file taskscheduler.cpp
+    \brief Code for TaskScheduler and TaskGroup classes
+*/
+
+#include "taskscheduler.h"
+
+namespace
+{
+    /// Scheduler whose worker the current thread is, nullptr for other threads
+    thread_local TaskScheduler* current_scheduler = nullptr;
+
+    /// Index of deque of the current thread in current_scheduler
+    thread_local unsigned int current_queue = 0;
+}
+
+TaskScheduler::TaskScheduler(unsigned int threads)
+{
+    if(threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for(unsigned int i = 0; i < threads; i++)
+    {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for(unsigned int i = 1; i < threads; i++)
+    {
+        workers.emplace_back(&TaskScheduler::workerLoop, this, i);
+    }
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    stopping = true;
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        sleep_cv.notify_all();
+    }
+    for(auto& w: workers)
+    {
+        w.join();
+    }
+}
+
+TaskScheduler& TaskScheduler::global()
+{
+    static TaskScheduler scheduler;
+    return scheduler;
+}
+
+void TaskScheduler::push(Item item)
+{
+    unsigned int index = (current_scheduler == this) ? current_queue : 0;
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->items.push_back(std::move(item));
+    }
+    queued++;
+
+    if(sleeping > 0)
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        sleep_cv.notify_one();
+    }
+}
+
+bool TaskScheduler::runOne()
+{
+    if(queued == 0)
+        return false;
+
+    unsigned int own = (current_scheduler == this) ? current_queue : 0;
+    Item item;
+    bool found = false;
+    {
+        std::lock_guard<std::mutex> lock(queues[own]->mutex);
+        if(!queues[own]->items.empty())
+        {
+            item = std::move(queues[own]->items.back());
+            queues[own]->items.pop_back();
+            found = true;
+        }
+    }
+
+    // oldest tasks of other threads are the largest ones
+    for(std::size_t i = 1; !found && i < queues.size(); i++)
+    {
+        Queue& victim = *queues[(own + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if(!victim.items.empty())
+        {
+            item = std::move(victim.items.front());
+            victim.items.pop_front();
+            found = true;
+            steals++;
+        }
+    }
+
+    if(!found)
+        return false;
+
+    queued--;
+    item.group->execute(item.task);
+    item.group->remaining--;
+    return true;
+}
+
+void TaskScheduler::workerLoop(unsigned int index)
+{
+    current_scheduler = this;
+    current_queue = index;
+
+    while(!stopping)
+    {
+        if(runOne())
+            continue;
+
+        // push counts the task before it reads sleeping, and sleeping is counted under the lock before queued is read,
+        // so either this thread sees the task or push notifies it after the wait has released the lock
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        sleeping++;
+        sleep_cv.wait(lock, [this]() { return queued > 0 || stopping; });
+        sleeping--;
+    }
+}
+
+void TaskGroup::execute(const std::function<void()>& task)
+{
+    try
+    {
+        task();
+    }
+    catch(...)
+    {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if(error == nullptr)
+            error = std::current_exception();
+    }
+}
+
+TaskGroup::~TaskGroup()
+{
+    while(remaining > 0)
+    {
+        if(!scheduler.runOne())
+            std::this_thread::yield();
+    }
+}
+
+void TaskGroup::run(std::function<void()> task)
+{
+    remaining++;
+    scheduler.push(TaskScheduler::Item{std::move(task), this});
+}
+
+void TaskGroup::wait()
+{
+    while(remaining > 0)
+    {
+        if(!scheduler.runOne())
+            std::this_thread::yield();
+    }
+
+    std::exception_ptr e;
+    {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        std::swap(e, error);
+    }
+    if(e != nullptr)
+        std::rethrow_exception(e);
+}
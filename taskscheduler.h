@@ -0,0 +1,200 @@
+/**
+    \file taskscheduler.h
+    \brief Header for work-stealing TaskScheduler and TaskGroup classes
+*/
+
+#ifndef TASKSCHEDULER_H_INCLUDED
+#define TASKSCHEDULER_H_INCLUDED
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TaskGroup;
+
+/**
+    \class TaskScheduler
+    \brief Pool of worker threads that run tasks from per-thread deques
+
+    A worker pushes and pops tasks at the back of its own deque, idle workers steal
+    from the front of the other deques, so large tasks forked early are stolen first.
+    Threads that are not workers push to a shared deque. Threads waiting for a
+    TaskGroup run queued tasks instead of blocking.
+*/
+class TaskScheduler
+{
+    private:
+        friend class TaskGroup;
+
+        /**
+            \brief Queued task and the group waiting for it
+        */
+        struct Item
+        {
+            std::function<void()> task;
+            TaskGroup* group;
+        };
+
+        /**
+            \brief Deque of one thread, index 0 is shared by threads that are not workers
+        */
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<Item> items;
+        };
+
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::vector<std::thread> workers;
+        std::atomic<bool> stopping{false};
+        std::atomic<std::size_t> queued{0};
+        std::atomic<unsigned int> sleeping{0};
+        std::atomic<std::uint64_t> steals{0};
+        std::mutex sleep_mutex;
+        std::condition_variable sleep_cv;
+
+        /**
+            \brief Push task to deque of calling thread
+            \param item task to push
+        */
+        void push(Item item);
+
+        /**
+            \brief Run one queued task, own deque first, then steal from others
+            \return false if there was no task to run
+        */
+        bool runOne();
+
+        /**
+            \brief Loop of worker thread
+            \param index index of worker's deque
+        */
+        void workerLoop(unsigned int index);
+
+    public:
+
+        /**
+            \brief Parametric constructor
+            \param threads number of threads running tasks including the waiting thread, 0 uses all hardware threads
+        */
+        explicit TaskScheduler(unsigned int threads = 0);
+
+        TaskScheduler(const TaskScheduler&) = delete;
+        TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+        /**
+            \brief Destructor, stops and joins workers
+        */
+        ~TaskScheduler();
+
+        /**
+            \brief Function to get scheduler shared by matrix operations
+            \return Reference to scheduler with all hardware threads
+        */
+        static TaskScheduler& global();
+
+        /**
+            \brief Function to get number of threads
+            \return Number of workers plus the waiting thread
+        */
+        unsigned int getThreadCount() const
+        {
+            return static_cast<unsigned int>(workers.size()) + 1;
+        }
+
+        /**
+            \brief Function to get number of tasks taken from deque of another thread
+            \return Number of steals
+        */
+        std::uint64_t getSteals() const
+        {
+            return steals;
+        }
+};
+
+/**
+    \class TaskGroup
+    \brief Fork-join group of tasks
+*/
+class TaskGroup
+{
+    private:
+        friend class TaskScheduler;
+        TaskScheduler& scheduler;
+        std::atomic<std::size_t> remaining{0};
+        std::mutex error_mutex;
+        std::exception_ptr error;
+
+        /**
+            \brief Run task of this group and record its exception
+            \param task the task
+        */
+        void execute(const std::function<void()>& task);
+
+    public:
+
+        /**
+            \brief Parametric constructor
+            \param s scheduler running the tasks
+        */
+        explicit TaskGroup(TaskScheduler& s = TaskScheduler::global()): scheduler(s) {}
+
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+        /**
+            \brief Destructor, waits for tasks that are still running
+        */
+        ~TaskGroup();
+
+        /**
+            \brief Fork task, it may run in any thread of the scheduler
+            \param task the task
+        */
+        void run(std::function<void()> task);
+
+        /**
+            \brief Join tasks, calling thread runs queued tasks while waiting
+            \throw First exception thrown by a task of this group
+        */
+        void wait();
+};
+
+/**
+    \brief Call f(begin, end) for subranges of [first, last) in parallel
+
+    Range is split in halves until it is at most grain long, one half is forked and the
+    other one is handled by the calling thread, so uneven work is balanced by stealing.
+    \param first start of range
+    \param last end of range
+    \param grain largest subrange that is not split further
+    \param f function called with subranges
+    \param s scheduler running the tasks
+*/
+template <typename F>
+void parallelFor(std::size_t first, std::size_t last, std::size_t grain, const F& f, TaskScheduler& s = TaskScheduler::global())
+{
+    grain = std::max<std::size_t>(grain, 1);
+    if(last - first <= grain || s.getThreadCount() == 1)
+    {
+        if(first < last)
+            f(first, last);
+        return;
+    }
+
+    std::size_t middle = first + (last - first) / 2;
+    TaskGroup group(s);
+    group.run([=, &f, &s]() { parallelFor(middle, last, grain, f, s); });
+    parallelFor(first, middle, grain, f, s);
+    group.wait();
+}
+
+#endif // TASKSCHEDULER_H_INCLUDED